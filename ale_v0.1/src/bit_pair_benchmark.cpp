@@ -0,0 +1,201 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  bit_pair_benchmark.cpp
+ *
+ *  The entry point for bit_pair_benchmark: replays the RAM dumps of a game
+ *  through the RAMAgent bit and bit-pair feature generators (the one that
+ *  walks all the pairs of bits, and the one that works from the set bits
+ *  only), checks that they give the same features, and prints the time per
+ *  step of each. The dumps are read from ram_dump_file, or first recorded
+ *  there by playing the ROM with random actions
+ **************************************************************************** */
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include "bspf.hxx"
+#include "Settings.hxx"
+#include "FSNode.hxx"
+#include "OSystem.hxx"
+#include "SettingsUNIX.hxx"
+#include "OSystemUNIX.hxx"
+#include "game_controller.h"
+#include "bit_pair_tools.h"
+#include "common_constants.h"
+
+/* *********************************************************************
+	Returns a monotonic time, in nanoseconds
+ ******************************************************************* */
+static long long now_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/* *********************************************************************
+	Plays the ROM with random actions for num_frames frames (resetting
+	it every max_num_frames_per_episode frames), and writes the RAM of
+	each frame (RAM_LENGTH bytes) to the given file
+ ******************************************************************* */
+static void record_ram_dumps(OSystem* osystem, const string& dump_file,
+							 int num_frames) {
+	FILE* file = fopen(dump_file.c_str(), "wb");
+	if (file == NULL) {
+		cerr << "Cannot create " << dump_file << endl;
+		exit(-1);
+	}
+	int episode_frames = osystem->settings().getInt(
+									"max_num_frames_per_episode", true);
+	Event* event = osystem->event();
+	MediaSource& mediasrc = osystem->console().mediaSource();
+	System& system = osystem->console().system();
+	uInt8 ram[RAM_LENGTH];
+	for (int frame = 0; frame < num_frames; frame++) {
+		int action;
+		if (episode_frames > 0 && frame % episode_frames == 0) {
+			action = RESET;
+		} else {
+			action = rand() % (PLAYER_A_DOWNLEFTFIRE + 1);
+		}
+		GameController::apply_action(event, action, PLAYER_B_NOOP);
+		mediasrc.update();
+		for (int i = 0; i < RAM_LENGTH; i++) {
+			ram[i] = system.peek(i + 0x80);
+		}
+		fwrite(ram, 1, RAM_LENGTH, file);
+	}
+	fclose(file);
+	cout << "Recorded the RAM of " << num_frames << " frames in "
+		 << dump_file << endl;
+}
+
+/* *********************************************************************
+	Reads the RAM dumps of the given file
+ ******************************************************************* */
+static void read_ram_dumps(const string& dump_file, vector<IntVect>& dumps) {
+	FILE* file = fopen(dump_file.c_str(), "rb");
+	if (file == NULL) {
+		cerr << "Cannot open " << dump_file << endl;
+		exit(-1);
+	}
+	uInt8 ram[RAM_LENGTH];
+	while (fread(ram, 1, RAM_LENGTH, file) == RAM_LENGTH) {
+		dumps.push_back(IntVect(ram, ram + RAM_LENGTH));
+	}
+	fclose(file);
+	if (dumps.empty()) {
+		cerr << dump_file << " has no RAM dumps" << endl;
+		exit(-1);
+	}
+}
+
+/* *********************************************************************
+	The generator RAMAgent used before bit_pair_tools: appends the
+	indices of the set bits, then walks all the pairs of bits
+ ******************************************************************* */
+static void generate_all_pairs(const IntVect& ram, IntVect& bits,
+							   IntVect& feature_inds) {
+	int num_bits = RAM_LENGTH * 8;
+	int full_vect_index = 0;
+	for (int i = 0; i < RAM_LENGTH; i++) {
+		for (int k = 7; k >= 0; k--) {
+			bits[full_vect_index] = (ram[i] >> k) & 1;
+			if (bits[full_vect_index] == 1) {
+				feature_inds.push_back(full_vect_index);
+			}
+			full_vect_index++;
+		}
+	}
+	for (int i = 0; i < num_bits; i++) {
+		for (int j = i + 1; j < num_bits; j++) {
+			if (bits[i] == 1 && bits[j] == 1) {
+				feature_inds.push_back(full_vect_index);
+			}
+			full_vect_index++;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	OSystem* osystem = new OSystemUNIX();
+	SettingsUNIX settings(osystem);
+	osystem->settings().loadConfig();
+
+	// Load the experiment parameters (max_num_frames_per_episode)
+	string exp_params_loc = osystem->settings().getString("working_dir") +
+							"experiment_params.txt";
+	osystem->settings().loadConfig(exp_params_loc.c_str());
+
+	// Take care of commandline arguments (over-ride all file settings)
+	string romfile = osystem->settings().loadCommandLine(argc, argv);
+	osystem->settings().validate();
+
+	if (osystem->settings().getString("random_seed") == "time") {
+		srand((unsigned)time(0));
+	} else {
+		srand((unsigned)osystem->settings().getInt("random_seed"));
+	}
+
+	string dump_file = osystem->settings().getString("ram_dump_file", true);
+	if (!FilesystemNode::fileExists(dump_file)) {
+		// Record the dumps first
+		osystem->create();
+		if (romfile == "" || !FilesystemNode::fileExists(romfile)) {
+			cerr << dump_file << " does not exist, and no ROM File was "
+				 << "specified to record it" << endl;
+			exit(-1);
+		}
+		if (!osystem->createConsole(romfile)) {
+			cerr << "Cannot load the ROM file " << romfile << endl;
+			exit(-1);
+		}
+		record_ram_dumps(osystem, dump_file,
+					osystem->settings().getInt("ram_dump_frames", true));
+	}
+	vector<IntVect> dumps;
+	read_ram_dumps(dump_file, dumps);
+
+	int num_bits = RAM_LENGTH * 8;
+	IntVect bits(num_bits, 0);
+	BitWordVect bit_words;
+	IntVect active_bits;
+	IntVect old_inds, new_inds;
+	long long old_ns = 0;
+	long long new_ns = 0;
+	long long num_set_bits = 0;
+	long long num_features = 0;
+	for (unsigned int d = 0; d < dumps.size(); d++) {
+		long long start = now_ns();
+		old_inds.clear();
+		generate_all_pairs(dumps[d], bits, old_inds);
+		old_ns += now_ns() - start;
+		start = now_ns();
+		pack_ram_bits(&dumps[d], bit_words);
+		extract_active_bits(bit_words, active_bits);
+		new_inds.clear();
+		generate_bit_pair_features(active_bits, num_bits, new_inds);
+		new_ns += now_ns() - start;
+		if (new_inds != old_inds) {
+			cerr << "The generators differ on RAM dump " << d << endl;
+			exit(-1);
+		}
+		num_set_bits += active_bits.size();
+		num_features += new_inds.size();
+	}
+	int num_dumps = dumps.size();
+	cout << num_dumps << " RAM dumps, " << (double)num_set_bits / num_dumps
+		 << " set bits and " << (double)num_features / num_dumps
+		 << " features per dump on average. Identical features." << endl;
+	cout << "All the pairs: " << old_ns / 1000.0 / num_dumps
+		 << " usec/step" << endl;
+	cout << "Set bits only: " << new_ns / 1000.0 / num_dumps
+		 << " usec/step" << endl;
+	delete osystem;
+	return 0;
+}
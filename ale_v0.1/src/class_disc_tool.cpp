@@ -0,0 +1,88 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  class_disc_tool.cpp
+ *
+ *  The entry point for class_disc_tool: runs the background detection
+ *  (do_bg_detection) and the class discovery (do_class_disc) offline, on the
+ *  frames recorded by a player agent in record_frames_file, in several
+ *  processes. The ROM is only loaded for the size and the palette of the
+ *  screens. The results are the files the player agent would have saved
+ **************************************************************************** */
+#include <cstdlib>
+#include "bspf.hxx"
+#include "Settings.hxx"
+#include "FSNode.hxx"
+#include "OSystem.hxx"
+#include "SettingsUNIX.hxx"
+#include "OSystemUNIX.hxx"
+#include "frame_recording.h"
+#include "offline_class_discovery.h"
+#include "common_constants.h"
+
+int main(int argc, char* argv[]) {
+	OSystem* osystem = new OSystemUNIX();
+	SettingsUNIX settings(osystem);
+	osystem->settings().loadConfig();
+
+	// Load the Class Discovery parameters
+    string cl_dis_params_loc = osystem->settings().getString("working_dir") +
+					osystem->settings().getString("class_disc_params_file");
+	osystem->settings().loadConfig(cl_dis_params_loc.c_str());
+
+	// Take care of commandline arguments (over-ride all file settings)
+	string romfile = osystem->settings().loadCommandLine(argc, argv);
+	osystem->settings().validate();
+	osystem->create();
+	if (romfile == "" || !FilesystemNode::fileExists(romfile)) {
+		cerr << "No ROM File specified or the ROM file was not found." << endl;
+		exit(-1);
+	}
+	if (!osystem->createConsole(romfile)) {
+		cerr << "Cannot load the ROM file " << romfile << endl;
+		exit(-1);
+	}
+	osystem->settings().setString("rom_file", romfile);
+	osystem->console().setPalette("standard");
+
+	string frames_file = osystem->settings().getString("record_frames_file",
+														true);
+	if (frames_file == "") {
+		cerr << "No recording given: set record_frames_file" << endl;
+		exit(-1);
+	}
+	MediaSource& mediasrc = osystem->console().mediaSource();
+	{
+		FrameReader reader(frames_file);
+		if (reader.get_height() != (int)mediasrc.height() ||
+			reader.get_width() != (int)mediasrc.width()) {
+			cerr << frames_file << " has " << reader.get_width() << "x"
+				 << reader.get_height() << " screens, the ROM has "
+				 << mediasrc.width() << "x" << mediasrc.height() << endl;
+			exit(-1);
+		}
+	}
+	int num_workers = get_class_disc_num_workers(osystem);
+	bool do_bg_detection = osystem->settings().getBool("do_bg_detection",
+														true);
+	bool do_class_disc = osystem->settings().getBool("do_class_disc", true);
+	if (!do_bg_detection && !do_class_disc) {
+		cerr << "Nothing to do: set do_bg_detection and/or do_class_disc"
+			 << endl;
+		exit(-1);
+	}
+	if (do_bg_detection) {
+		detect_background_offline(osystem, frames_file, num_workers);
+	}
+	if (do_class_disc) {
+		discover_classes_offline(osystem, frames_file, num_workers);
+	}
+	delete osystem;
+	return 0;
+}
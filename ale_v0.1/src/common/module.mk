@@ -3,6 +3,7 @@ MODULE := src/common
 MODULE_OBJS := \
 	src/common/SoundNull.o \
 	src/common/export_screen.o \
+	src/common/screen_changes.o \
 	src/common/vector_matrix_tools.o \
 
 MODULE_DIRS += \
@@ -0,0 +1,68 @@
+/* *****************************************************************************
+ *  screen_changes.cpp
+ *
+ *  The implementation of the ScreenChanges class, which keeps the parts of 
+ *  the screen that changed since they were last processed, from the dirty 
+ *  spans reported by the TIA
+ **************************************************************************** */
+
+#include "screen_changes.h"
+#include "OSystem.hxx"
+#include "TIA.hxx"
+
+/* *********************************************************************
+    Constructor. Turns on the dirty span tracking of the TIA
+ ******************************************************************** */
+ScreenChanges::ScreenChanges(OSystem* osystem) {
+    MediaSource& mediasrc = osystem->console().mediaSource();
+    // The TIA is our only MediaSource
+    p_tia = (TIA*)(&mediasrc);
+    p_tia->enableDirtyTracking(true);
+    i_screen_width = mediasrc.width();
+    i_screen_height = mediasrc.height();
+    i_last_frame = -1;
+    v_span_starts.resize(i_screen_height);
+    v_span_ends.resize(i_screen_height);
+    mark_all();
+}
+
+/* *********************************************************************
+    Adds the changes of the last frame of the TIA. Should be called
+    after every frame
+ ******************************************************************** */
+void ScreenChanges::update(void) {
+    int frame = p_tia->frameCount();
+    if (frame == i_last_frame) {
+        return;
+    }
+    if (i_last_frame == -1 || frame != i_last_frame + 1) {
+        // Some frames were not seen
+        mark_all();
+    } else {
+        const TIA::DirtySpan* spans = p_tia->dirtySpans();
+        for (int y = 0; y < i_screen_height; y++) {
+            if (spans[y].end <= spans[y].start) {
+                continue;
+            }
+            v_span_starts[y] = min(v_span_starts[y], (int)spans[y].start);
+            v_span_ends[y] = max(v_span_ends[y], (int)spans[y].end);
+        }
+    }
+    i_last_frame = frame;
+}
+
+/* *********************************************************************
+    Marks all the screen as changed
+ ******************************************************************** */
+void ScreenChanges::mark_all(void) {
+    v_span_starts.assign(i_screen_height, 0);
+    v_span_ends.assign(i_screen_height, i_screen_width);
+}
+
+/* *********************************************************************
+    Marks all the screen as unchanged (after the changes are processed)
+ ******************************************************************** */
+void ScreenChanges::clear(void) {
+    v_span_starts.assign(i_screen_height, i_screen_width);
+    v_span_ends.assign(i_screen_height, 0);
+}
@@ -0,0 +1,93 @@
+/* *****************************************************************************
+ *  screen_changes.h
+ *
+ *  The implementation of the ScreenChanges class, which keeps the parts of 
+ *  the screen that changed since they were last processed, from the dirty 
+ *  spans reported by the TIA
+ **************************************************************************** */
+
+#ifndef SCREEN_CHANGES_H
+#define SCREEN_CHANGES_H
+
+#include "common_constants.h"
+
+class OSystem;
+class TIA;
+
+class ScreenChanges {
+    /* *************************************************************************
+        Keeps, for each row of the screen, the columns that changed since 
+		the last call to clear(): the union of the dirty spans the TIA 
+		reports for each frame. When some frames were not seen (update() 
+		was not called after them), or the TIA cannot tell (e.g. after 
+		loading a state), the whole screen is changed.
+		
+        Instance Variables:
+            - p_tia             Pointer to the TIA (which tracks the changes)
+            - i_screen_width    Width of the screen
+            - i_screen_height   Height of the screen
+			- i_last_frame		The TIA frame of the last update (-1 before 
+								the first one)
+			- v_span_starts		The first changed column of each row
+			- v_span_ends		One past the last changed column of each row
+								(the row is unchanged when end <= start)
+    ************************************************************************* */
+    public:
+        /* *********************************************************************
+            Constructor. Turns on the dirty span tracking of the TIA
+         ******************************************************************** */
+        ScreenChanges(OSystem* osystem);
+
+        /* *********************************************************************
+            Deconstructor
+         ******************************************************************** */
+        virtual ~ScreenChanges() {}
+
+        /* *********************************************************************
+            Adds the changes of the last frame of the TIA. Should be called
+			after every frame
+         ******************************************************************** */
+        void update(void);
+
+        /* *********************************************************************
+            Marks all the screen as changed
+         ******************************************************************** */
+        void mark_all(void);
+
+        /* *********************************************************************
+            Marks all the screen as unchanged (after the changes are 
+			processed)
+         ******************************************************************** */
+        void clear(void);
+
+        /* *********************************************************************
+            Returns true if some pixels of the given row changed
+         ******************************************************************** */
+        bool is_row_changed(int row) const {
+            return v_span_ends[row] > v_span_starts[row];
+        }
+
+        /* *********************************************************************
+            Returns the first changed column of the given row
+         ******************************************************************** */
+        int get_span_start(int row) const {
+            return v_span_starts[row];
+        }
+
+        /* *********************************************************************
+            Returns one past the last changed column of the given row
+         ******************************************************************** */
+        int get_span_end(int row) const {
+            return v_span_ends[row];
+        }
+
+    protected:
+        TIA* p_tia;
+        int i_screen_width;
+        int i_screen_height;
+        int i_last_frame;
+        IntVect v_span_starts;
+        IntVect v_span_ends;
+};
+
+#endif
@@ -80,6 +80,7 @@ FIFOController::~FIFOController() {
  * ****************************************************************** */
 void FIFOController::update() {
 	Action player_a_action, player_b_action;
+	update_frame_buffer();
 	// 0- See if we are skipping this frame
 	if (i_skip_frames_counter < i_skip_frames_num) {
 		// skip this frame
@@ -108,18 +109,26 @@ void FIFOController::update() {
 			}
 		}
 		if (b_send_screen_matrix) {
-			// The next section is taken from FrameBufferSoft
-			for (int i = 0; i < i_screen_width * i_screen_height; i++) {
-				uInt8 v = pi_curr_frame_buffer[i];
-				if (v != pi_old_frame_buffer[i]) {
-					char buffer[50];
-					int ind_j = i / i_screen_width;
-					int ind_i = i - (ind_j * i_screen_width);
-					sprintf (buffer, "%03i%03i%03i", ind_i, ind_j, v);
-					final_str += buffer;
-					pi_old_frame_buffer[i] = v;
+			// Only the parts of the screen that changed since the last 
+			// frame we sent can have updated pixels
+			for (int ind_j = 0; ind_j < i_screen_height; ind_j++) {
+				if (!p_screen_changes->is_row_changed(ind_j)) {
+					continue;
+				}
+				int span_end = p_screen_changes->get_span_end(ind_j);
+				for (int ind_i = p_screen_changes->get_span_start(ind_j); 
+					 ind_i < span_end; ind_i++) {
+					int i = ind_j * i_screen_width + ind_i;
+					uInt8 v = pi_curr_frame_buffer[i];
+					if (v != pi_old_frame_buffer[i]) {
+						char buffer[50];
+						sprintf (buffer, "%03i%03i%03i", ind_i, ind_j, v);
+						final_str += buffer;
+						pi_old_frame_buffer[i] = v;
+					}
 				}
 			}
+			p_screen_changes->clear();
 		} else {
 			final_str += "NADA";
 		}
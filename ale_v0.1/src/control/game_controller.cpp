@@ -27,6 +27,7 @@ GameController::GameController(OSystem* _osystem) {
     p_console = &(p_osystem->console());
     MediaSource& mediasrc = p_console->mediaSource();
     pi_curr_frame_buffer = mediasrc.currentFrameBuffer();
+    p_screen_changes = new ScreenChanges(p_osystem);
     p_emulator_system = &(p_console->system());
     i_screen_width  = mediasrc.width();
     i_screen_height = mediasrc.height();
@@ -63,6 +64,18 @@ GameController::GameController(OSystem* _osystem) {
     Deconstructor
  ******************************************************************** */
 GameController::~GameController() {
+    delete p_screen_changes;
+}
+
+/* *********************************************************************
+ *  Points pi_curr_frame_buffer to the last frame (the TIA swaps its 
+ *  two frame buffers on every frame), and adds the changes of the 
+ *  frame to p_screen_changes. Called on every iteration of the main 
+ *  loop, skipped frames included
+ * ********************************************************************/
+void GameController::update_frame_buffer(void) {
+    pi_curr_frame_buffer = p_console->mediaSource().currentFrameBuffer();
+    p_screen_changes->update();
 }
 
 
@@ -20,6 +20,7 @@
 #include "OSystem.hxx"
 #include "System.hxx"
 #include "common_constants.h"
+#include "screen_changes.h"
 #include "export_screen.h"
 
 #define PADDLE_DELTA 23000
@@ -87,6 +88,14 @@ class GameController {
          *	The code is mainly based on RamDebug.cxx
          * ********************************************************************/
         int read_ram(int offset); 
+
+        /* *********************************************************************
+         *  Returns the parts of the screen that changed since the screen was 
+         *  last read
+         * ********************************************************************/
+        const ScreenChanges* get_screen_changes(void) const {
+            return p_screen_changes;
+        }
         
         
 
@@ -102,6 +111,14 @@ class GameController {
 		 *  updating the corresponding paddle's resistance
          * ********************************************************************/
 		 void update_paddles_positions(int delta_left, int delta_right);
+
+		/* *********************************************************************
+         *  Points pi_curr_frame_buffer to the last frame (the TIA swaps its 
+		 *  two frame buffers on every frame), and adds the changes of the 
+		 *  frame to p_screen_changes. Called on every iteration of the main 
+		 *  loop, skipped frames included
+         * ********************************************************************/
+		void update_frame_buffer(void);
 		
         OSystem* p_osystem;         // Pointer to the stella's OSystem object
         Event* p_global_event_obj;  // Pointer to the global event object
@@ -110,6 +127,8 @@ class GameController {
         int i_screen_height;        // Height of the screen
         uInt8* pi_curr_frame_buffer;// Pointer to the current framebuffer (used
                                     // to read the screen matrix)
+        ScreenChanges* p_screen_changes; // The parts of the screen that 
+                                    // changed since it was last read
         Console* p_console;         // Pointer to the Console object
         System* p_emulator_system;  // Pointer to the emulator system  (used to
                                     // read the system RAM)
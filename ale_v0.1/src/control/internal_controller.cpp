@@ -86,6 +86,7 @@ InternalController::~InternalController() {
  * ****************************************************************** */
 void InternalController::update() {
 	Action player_a_action, player_b_action;
+	update_frame_buffer();
 	// See if we are skipping this frame
 	if (i_skip_frames_counter < p_game_settings->i_skip_frames_num) {
 		// skip this frame
@@ -131,20 +132,25 @@ void InternalController::update() {
 
 
 /* *********************************************************************
-    Copies the content of the framebufer to pm_screen_matrix
+    Copies the content of the framebufer to pm_screen_matrix. Only the 
+	parts of the screen that changed since the last copy are copied
  * ****************************************************************** */
 void InternalController::copy_framebuffer(void) {
     if (!b_send_screen_matrix) {
         return;
     }
-    // This code section is taken from FrameBufferSoft
-    int ind_i, ind_j;
-    for (int i = 0; i < i_screen_width * i_screen_height; i++) {
-        uInt8 v = pi_curr_frame_buffer[i];
-        ind_i = i / i_screen_width;
-        ind_j = i - (ind_i * i_screen_width);
-        (*pm_screen_matrix)[ind_i][ind_j] = v;
+    for (int y = 0; y < i_screen_height; y++) {
+        if (!p_screen_changes->is_row_changed(y)) {
+            continue;
+        }
+        const uInt8* frame_row = pi_curr_frame_buffer + y * i_screen_width;
+        IntVect& screen_row = (*pm_screen_matrix)[y];
+        int span_end = p_screen_changes->get_span_end(y);
+        for (int x = p_screen_changes->get_span_start(y); x < span_end; x++) {
+            screen_row[x] = frame_row[x];
+        }
     }
+    p_screen_changes->clear();
 }
 
 /* *********************************************************************
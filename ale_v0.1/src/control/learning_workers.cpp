@@ -0,0 +1,236 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  learning_workers.cpp
+ *
+ *  Functions that run several learning workers (each with its own emulator,
+ *  GameSettings and traces) on one shared weights vector, or several actors
+ *  feeding one learner process, and merge their learning curves
+ **************************************************************************** */
+
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <ctime>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "learning_workers.h"
+#include "rl_sarsa_lambda.h"
+#include "Settings.hxx"
+
+#define CURVE_AVERAGE_WINDOW 10		// Number of episodes in the running
+									// average of the merged learning curve
+#define LEARNER_IDLE_USECS 200		// How long the learner sleeps when no
+									// actor has a transition for it
+
+static vector<pid_t> v_worker_pids;	// The forked workers (in worker 0)
+
+/* *********************************************************************
+	One episode of one worker, as read from its learning curve
+ ******************************************************************* */
+struct CurvePoint {
+	double seconds;			// Wall clock at the end of the episode
+	int worker;
+	int episode;
+	int frames;				// Frames of this worker so far
+	float reward;			// Reward of the episode
+	bool operator<(const CurvePoint& other) const {
+		return seconds < other.seconds;
+	}
+};
+
+/* *********************************************************************
+	Returns true when several workers (or an actor and a learner) are used
+ ******************************************************************* */
+bool uses_learning_workers(OSystem* osystem) {
+	return (osystem->settings().getInt("num_learning_workers", true) > 1 ||
+			is_actor_learner_mode(osystem));
+}
+
+/* *********************************************************************
+	Returns true when learning_mode is actor_learner
+ ******************************************************************* */
+bool is_actor_learner_mode(OSystem* osystem) {
+	string mode = osystem->settings().getString("learning_mode", true);
+	if (mode != "hogwild" && mode != "actor_learner") {
+		cerr << "Invalid value for learning_mode: " << mode << endl;
+		exit(-1);
+	}
+	return (mode == "actor_learner");
+}
+
+/* *********************************************************************
+	Returns the ids of the first and last workers that play
+ ******************************************************************* */
+static void get_playing_workers(OSystem* osystem, int& first, int& last) {
+	int num_workers = osystem->settings().getInt("num_learning_workers", true);
+	first = is_actor_learner_mode(osystem) ? 1 : 0;
+	last = first + num_workers - 1;
+}
+
+/* *********************************************************************
+	Returns the name of the learning curve file of the given worker
+ ******************************************************************* */
+string learning_curve_filename(int worker_id) {
+	ostringstream filename;
+	filename << "learning_curve__worker_" << worker_id << ".txt";
+	return filename.str();
+}
+
+/* *********************************************************************
+	Forks the worker processes. Must be called after the player agent is 
+	created, so that what it allocated in shared mappings (the hogwild 
+	weights, or the actor/learner channel) is shared by all the workers, 
+	while the emulator, the GameSettings and the traces are copied.
+	In the hogwild mode, the workers 0 to num_learning_workers - 1 play 
+	(0 is the original process). In the actor_learner mode, the original 
+	process is the learner, and the workers 1 to num_learning_workers are 
+	the actors.
+	Sets learning_worker_id and reseeds the random generators in each
+	worker. Returns the id of the calling worker
+ ******************************************************************* */
+int spawn_learning_workers(OSystem* osystem) {
+	Settings& settings = osystem->settings();
+	settings.setInt("learning_worker_id", 0);
+	if (!uses_learning_workers(osystem)) {
+		return 0;
+	}
+	int first, last;
+	get_playing_workers(osystem, first, last);
+	if (is_actor_learner_mode(osystem)) {
+		cout << "Running " << last << " actors and a learner" << endl;
+	} else {
+		cout << "Running " << last + 1 << " learning workers on the shared "
+			 << "weights" << endl;
+	}
+	for (int i = first; i <= last; i++) {
+		// start with empty curves
+		ofstream file(learning_curve_filename(i).c_str());
+	}
+	unsigned int base_seed;
+	if (settings.getString("random_seed") == "time") {
+		base_seed = (unsigned)time(0);
+	} else {
+		base_seed = (unsigned)settings.getInt("random_seed");
+	}
+	cout.flush();	// or the children print our buffered output again
+	for (int i = 1; i <= last; i++) {
+		pid_t pid = fork();
+		if (pid == -1) {
+			cerr << "Failed to fork learning worker " << i << endl;
+			exit(-1);
+		}
+		if (pid == 0) {
+			v_worker_pids.clear();
+			settings.setInt("learning_worker_id", i);
+			srand(base_seed + i);
+			srand48(base_seed + i);
+			return i;
+		}
+		v_worker_pids.push_back(pid);
+	}
+	return 0;
+}
+
+/* *********************************************************************
+	Runs the learner of the actor_learner mode, until all the actors are
+	done and their transitions are learned. An actor that crashes is 
+	reported, and the learner goes on with the others
+ ******************************************************************* */
+void run_learner(OSystem* osystem) {
+	RLSarsaLambda* learner = RLSarsaLambda::get_actor_learner_instance();
+	if (learner == NULL) {
+		cerr << "The actor_learner mode needs a Sarsa based player agent" 
+			 << endl;
+		exit(-1);
+	}
+	cout << "Learner started" << endl;
+	while (true) {
+		if (learner->learn_from_actors() > 0) {
+			continue;
+		}
+		// Nothing to learn: see which actors are done
+		for (unsigned int i = 0; i < v_worker_pids.size(); i++) {
+			int status;
+			if (waitpid(v_worker_pids[i], &status, WNOHANG) != v_worker_pids[i]) {
+				continue;
+			}
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				cerr << "Actor process " << v_worker_pids[i] << " crashed, the "
+					 << "learner goes on with the other actors" << endl;
+			}
+			v_worker_pids.erase(v_worker_pids.begin() + i);
+			i--;
+		}
+		if (v_worker_pids.empty()) {
+			// The rings were emptied before the last actors were reaped
+			while (learner->learn_from_actors() > 0);
+			break;
+		}
+		usleep(LEARNER_IDLE_USECS);
+	}
+	cout << "Learner done" << endl;
+}
+
+/* *********************************************************************
+	Called by worker 0 when its run is over: waits for the other workers,
+	and merges the learning curves of all the workers (ordered by wall
+	clock) into learning_curve__all_workers.txt
+ ******************************************************************* */
+void join_learning_workers(OSystem* osystem) {
+	if (!uses_learning_workers(osystem)) {
+		return;
+	}
+	int first, last;
+	get_playing_workers(osystem, first, last);
+	for (unsigned int i = 0; i < v_worker_pids.size(); i++) {
+		int status;
+		waitpid(v_worker_pids[i], &status, 0);
+	}
+	v_worker_pids.clear();
+	// Each line of a worker curve is: episode,frames,seconds,reward
+	vector<CurvePoint> points;
+	for (int w = first; w <= last; w++) {
+		ifstream infile(learning_curve_filename(w).c_str());
+		CurvePoint point;
+		char delim;
+		point.worker = w;
+		while (infile >> point.episode >> delim >> point.frames >> delim
+					  >> point.seconds >> delim >> point.reward) {
+			points.push_back(point);
+		}
+	}
+	stable_sort(points.begin(), points.end());
+	IntVect worker_frames(last + 1, 0);
+	int total_frames = 0;
+	float window_sum = 0;
+	ofstream file("learning_curve__all_workers.txt");
+	file << "# seconds,frames_all_workers,worker,episode,reward,"
+		 << "average_reward_last_" << CURVE_AVERAGE_WINDOW << endl;
+	for (unsigned int i = 0; i < points.size(); i++) {
+		const CurvePoint& point = points[i];
+		total_frames += point.frames - worker_frames[point.worker];
+		worker_frames[point.worker] = point.frames;
+		window_sum += point.reward;
+		if (i >= CURVE_AVERAGE_WINDOW) {
+			window_sum -= points[i - CURVE_AVERAGE_WINDOW].reward;
+		}
+		int window = min((int)i + 1, CURVE_AVERAGE_WINDOW);
+		file << point.seconds << "," << total_frames << "," << point.worker
+			 << "," << point.episode << "," << point.reward << ","
+			 << window_sum / window << endl;
+	}
+	file.close();
+	double seconds = points.empty() ? 0 : points.back().seconds;
+	cout << "All " << last - first + 1 << " learning workers are done: "
+		 << points.size() << " episodes, " << total_frames << " frames in "
+		 << seconds << " seconds ("
+		 << (seconds > 0 ? total_frames / seconds : 0) << " frames/sec)"
+		 << endl;
+}
@@ -0,0 +1,66 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  learning_workers.h
+ *
+ *  Functions that run several learning workers (each with its own emulator,
+ *  GameSettings and traces) on one shared weights vector, or several actors
+ *  feeding one learner process, and merge their learning curves
+ **************************************************************************** */
+
+#ifndef LEARNING_WORKERS_H
+#define LEARNING_WORKERS_H
+
+#include "common_constants.h"
+#include "OSystem.hxx"
+
+/* *************************************************************************
+	Returns true when several workers (or an actor and a learner) are used
+ ************************************************************************* */
+bool uses_learning_workers(OSystem* osystem);
+
+/* *************************************************************************
+	Returns true when learning_mode is actor_learner
+ ************************************************************************* */
+bool is_actor_learner_mode(OSystem* osystem);
+
+/* *************************************************************************
+	Forks the worker processes. Must be called after the player agent is 
+	created, so that what it allocated in shared mappings (the hogwild 
+	weights, or the actor/learner channel) is shared by all the workers, 
+	while the emulator, the GameSettings and the traces are copied.
+	In the hogwild mode, the workers 0 to num_learning_workers - 1 play 
+	(0 is the original process). In the actor_learner mode, the original 
+	process is the learner, and the workers 1 to num_learning_workers are 
+	the actors.
+	Sets learning_worker_id and reseeds the random generators in each
+	worker. Returns the id of the calling worker
+ ************************************************************************* */
+int spawn_learning_workers(OSystem* osystem);
+
+/* *************************************************************************
+	Runs the learner of the actor_learner mode, until all the actors are
+	done and their transitions are learned. An actor that crashes is 
+	reported, and the learner goes on with the others
+ ************************************************************************* */
+void run_learner(OSystem* osystem);
+
+/* *************************************************************************
+	Called by worker 0 when its run is over: waits for the other workers,
+	and merges the learning curves of all the workers (ordered by wall
+	clock) into learning_curve__all_workers.txt
+ ************************************************************************* */
+void join_learning_workers(OSystem* osystem);
+
+/* *************************************************************************
+	Returns the name of the learning curve file of the given worker
+ ************************************************************************* */
+string learning_curve_filename(int worker_id);
+
+#endif
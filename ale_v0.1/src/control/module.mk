@@ -4,6 +4,7 @@ MODULE_OBJS := \
 	src/control/fifo_controller.o \
 	src/control/game_controller.o \
 	src/control/internal_controller.o \
+	src/control/learning_workers.o \
 	
 MODULE_DIRS += \
 	src/control
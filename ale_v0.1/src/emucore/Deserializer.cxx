@@ -36,6 +36,15 @@ void Deserializer::close(void)
 
 
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Deserializer::rewind(void)
+{
+  myStream.clear();
+  myStream.seekg(0);
+}
+
+
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 int Deserializer::getInt(void)
 {
@@ -46,6 +46,12 @@ class Deserializer {
 		Deserializer(const string stream_str);
 		
 		void close(void);
+		
+		/**
+		 Moves back to the beginning of the stream, so the same state can be
+		 deserialized again without copying it
+		 */
+		void rewind(void);
 
 		/**
 		 Reads an int value from the current input stream.
@@ -139,6 +139,16 @@ Settings::Settings(OSystem* osystem) : myOSystem(osystem) {
                                             // number of frames. -1 = never
 	setInternal("max_num_frames_per_episode", "-1");	// Ends each episode 
 											// after this number of frames
+	setInternal("num_learning_workers", "1");	// Number of worker processes 
+											// (each with its own emulator) 
+											// learning on shared weights
+	setInternal("learning_worker_id", "0");	// Set by each worker to its id
+	setInternal("learning_mode", "hogwild");	// hogwild or actor_learner
+	setInternal("learner_publish_frq", "100");	// The learner publishes its 
+											// weights every this many 
+											// transitions
+	setInternal("actor_ring_bytes", "16777216"); // Size of the transition 
+											// ring of each actor
 	setInternal("num_episodes_to_avg_results", "1000"); // The learning results
 											// will be summarized over this many 
 											// episodes.
@@ -147,6 +157,9 @@ Settings::Settings(OSystem* osystem) : myOSystem(osystem) {
 											// selected automatically.
     setInternal("import_weights_file", ""); // When set, we will import the 
 											// given weights file.
+	setInternal("weights_export_format", "text"); // text: comma seperated 
+											// values, binary: checkpoints 
+											// written in the background
 	setInternal("init_act_explor_count", "0");// At the very begining, we will try
 											// repeating each action this many
 											// times (this is a mthod for 
@@ -166,12 +179,27 @@ Settings::Settings(OSystem* osystem) : myOSystem(osystem) {
 												// after each score recieved.
 	setInternal("end_episode_with_reward", "false");// When true, the episode 
 												// ends with each score 
+	setInternal("use_tia_objects", "false");	// When true, the TIA records
+												// the objects it draws, and
+												// the player-agents get them
+												// as a list of objects
 
 	setInternal("do_bg_detection", "false");	// When true, the player-agent 
 												// will also do backgroudn 
 												// detection 	
+	setInternal("bg_detect_stable_frames", "0");// When positive, background 
+												// detection stops once the 
+												// background has not changed
+												// for this many frames
 	setInternal("do_class_disc", "false");		// When true, the player-agent 
 												// will also do class discovery
+	setInternal("record_frames_file", "");		// When set, the player-agent 
+												// records the screens it sees
+												// in this file (the input of
+												// class_disc_tool)
+	setInternal("class_disc_num_workers", "0");	// Number of processes of 
+												// class_disc_tool (0: one per
+												// core)
 	setInternal("max_perc_difference", "0.1");	// The maximum percentage of 
 												// pixels of the two shapes that
 												// can be different and the 
@@ -183,6 +211,10 @@ Settings::Settings(OSystem* osystem) : myOSystem(osystem) {
 												// meaningful. 
 	setInternal("max_obj_velocity", "8");       // Maximum velocity (pixel/sec)
 												// of objects on screen
+	setInternal("max_pair_distance", "0");      // Pairs of class instances 
+												// further apart than this (in 
+												// pixels) are left out of the
+												// feature-vector (0: never)
 	setInternal("num_block_per_row", "10");     // How many blocks per row
 	setInternal("num_block_per_col", "10");     // How many blocks per column
 	setInternal("do_subtract_background", "true"); // When true we will subtract
@@ -195,9 +227,86 @@ Settings::Settings(OSystem* osystem) : myOSystem(osystem) {
 												// after the give nratio of 
 												// episodes. -1 (default) means 
                                                 // never
+	setInternal("weights_storage", "dense");	// [dense/hashed] How the 
+												// Sarsa-Lambda weights are 
+												// stored
+	setInternal("hashed_weights_size", "1048576"); // Number of weights in the 
+												// hashed storage (a power of 2)
+	setInternal("hashed_weights_safe", "false");// When true, colliding features
+												// are probed to different slots
+												// (and we exit if the table is 
+												// full). When false, they share
+												// a weight
+	setInternal("weights_precision", "double");	// [double/single/fixed16] 
+												// Precision of the Sarsa-Lambda
+												// weights
+	setInternal("fixed_weights_step", "0.0009765625"); // Value of one step of
+												// the fixed16 weights (2^-10)
+	setInternal("interleave_action_weights", "false"); // When true, agents 
+												// whose actions share the base
+												// features keep the weights of 
+												// all actions of a feature 
+												// next to each other
+	setInternal("incremental_q", "true");		// When true, agents whose 
+												// actions share the base 
+												// features update the Q-values 
+												// from the feature changes
+	setInternal("incremental_q_recompute_frq", "1000"); // How often (in steps)
+												// the incremental Q-values are
+												// recomputed from scratch
+	setInternal("bench_variants", "plain,idbd,dbd"); // Step-size variants 
+												// run by sarsa_benchmark
+	setInternal("bench_feature_sizes", "1000,10000,100000"); // Numbers of 
+												// features run by 
+												// sarsa_benchmark
+	setInternal("bench_trace_ratios", "0.01,0.1"); // trace_vec_size_ratio 
+												// values run by sarsa_benchmark
+	setInternal("bench_steps", "200000");		// Steps of each sarsa_benchmark
+												// run
+	setInternal("bench_output_file", "sarsa_benchmark.csv"); // The CSV file
+												// of sarsa_benchmark
+	setInternal("ram_dump_file", "ram_dumps.bin"); // The RAM dumps replayed 
+												// by bit_pair_benchmark
+	setInternal("ram_dump_frames", "10000");	// Number of frames recorded
+												// when ram_dump_file is missing
 	setInternal("shrink_weights_frq", "0");		// How often to remove the 
 												// smallest value in the weights
 												// vactor.
+	setInternal("uct_rollout_frame_skip", "0");	// Each random action in a 
+												// Monte Carlo rollout is held 
+												// for this many frames. 0 means
+												// per-frame rollouts
+	setInternal("uct_rollout_ram_watch", "");	// Comma separated RAM indices
+												// that force a reward check 
+												// during a held rollout action
+	setInternal("uct_prune_actions", "false");	// When true, UCT only expands 
+												// one action from each group of
+												// actions that lead to the same
+												// state
+	setInternal("uct_prune_warmup_expansions", "20"); // Number of full 
+												// expansions used to learn the 
+												// equivalent actions
+	setInternal("uct_prune_recheck_frq", "100");	// How often (in expansions)
+												// the equivalent actions are 
+												// re-checked. 0 means never
+	setInternal("search_telemetry_file", "");	// CSV file for the per-decision
+												// statistics of the search. 
+												// Empty means a summary line 
+												// on stdout
+	setInternal("mc_rollouts_per_batch", "1");	// Number of rollouts run from 
+												// each child of the root in 
+												// one Monte Carlo batch
+	setInternal("fulltree_max_mem_mb", "0");	// Memory budget (in MB) for the
+												// states of the full-tree. 0 
+												// means every node keeps its 
+												// own state
+	setInternal("fulltree_max_spill_mb", "0");	// States that do not fit in 
+												// memory are spilled to disk, 
+												// up to this many MB
+	setInternal("fulltree_spill_file", "fulltree_states.spill");
+	setInternal("fulltree_reuse_tree", "false");// When true, the full-tree is 
+												// kept between decisions and 
+												// expanded from its leaves
 
 }
 
@@ -437,6 +546,27 @@ void Settings::usage() {
 << endl
 	<< " *  -max_num_frames m"																<< endl
 	<< " *  The program will quit after this number of frames. -1 (default) means never."	<< endl
+<< endl
+	<< " *  -num_learning_workers n"														<< endl
+	<< " *   Runs n worker processes, each with its own emulator, game settings and "		<< endl
+	<< " *   traces, that update one shared weights vector without locks (Hogwild). "		<< endl
+	<< " *   Each worker writes learning_curve__worker_i.txt, and the curves are merged "	<< endl
+	<< " *   (by wall clock) into learning_curve__all_workers.txt. Default is 1"			<< endl
+<< endl
+	<< " *  -learning_mode [hogwild]/[actor_learner]"										<< endl
+	<< " *   hogwild (default): all the workers update the shared weights. "				<< endl
+	<< " *   actor_learner: num_learning_workers actor processes play from the weights "	<< endl
+	<< " *   published by a separate learner process, and stream their transitions "		<< endl
+	<< " *   (active features, action, reward) to it through shared-memory rings. "		<< endl
+	<< " *   A crashing actor does not stop the learner."									<< endl
+<< endl
+	<< " *  -learner_publish_frq n"														<< endl
+	<< " *   The learner publishes its weights to the actors every n transitions "		<< endl
+	<< " *   (default 100)"																	<< endl
+<< endl
+	<< " *  -actor_ring_bytes n"															<< endl
+	<< " *   Size of the transition ring of each actor, in bytes (default 16MB). An "		<< endl
+	<< " *   actor waits while its ring is full"											<< endl
 << endl 
 	<< " *  -max_num_frames_per_episode m"													<< endl
 	<< " *  Ends each episode after this number of frames. -1 (default) means never."		<< endl
@@ -446,7 +576,13 @@ void Settings::usage() {
 	<< " *   Default is 1000"																<< endl
 << endl 
 	<< " *  -import_weights_file str"														<< endl
-	<< " *   When set, we will import the given weights file."								<< endl 
+	<< " *   When set, we will import the given weights file. Both binary checkpoints "	<< endl
+	<< " *   and text files are accepted (the format is detected from the file)."			<< endl 
+<< endl
+	<< " *  -weights_export_format [text]/[binary]"										<< endl
+	<< " *   text (default) writes the weights as comma seperated values, blocking the "	<< endl
+	<< " *   agent. binary writes them as a checkpoint with a header (size, actions, "	<< endl
+	<< " *   precision, checksum), from a background thread."								<< endl
 << endl
 	<< " *  -ld [A/B]"																		<< endl
 	<< " *   Left player difficulty. B (default) means easy"								<< endl
@@ -464,6 +600,11 @@ void Settings::usage() {
 	<< " *  -minus_one_zero_reward    Use -1/0 reward system. When true, reward will be -1 on"<< endl
 	<< " *                            everysteps, esxcept when score is positive, in which "<< endl
 	<< " *                            case the reward will be 0"							<< endl
+<< endl
+	<< " *  -use_tia_objects [true/false]"													<< endl
+	<< " *   When true, the TIA records the position, graphics and color of the players, "	<< endl
+	<< " *   missiles and ball on each scanline, and the player-agents get the objects of "	<< endl
+	<< " *   each frame from it, without detecting them on the screen. Default is false."	<< endl
 << endl
 << endl
 	<< " * Sarsa-Lambda Parameters (usually loaded from 'rl_params.txt'). "				<< endl
@@ -500,6 +641,74 @@ void Settings::usage() {
 << endl
 	<< " *  -shrink_weights_const f"
 	<< " *   see documents for shrink_weights_method"										<< endl
+<< endl
+	<< " *  -weights_storage [dense]/[hashed]"												<< endl
+	<< " *   dense (default) keeps one weight per feature. hashed keeps the weights in a "	<< endl
+	<< " *   hash-table of hashed_weights_size entries, so memory is proportional to the "	<< endl
+	<< " *   features that are actually used"												<< endl
+<< endl
+	<< " *  -hashed_weights_size n"														<< endl
+	<< " *   Size of the hashed weights table. Must be a power of 2. Default is 1048576"	<< endl
+<< endl
+	<< " *  -hashed_weights_safe [true]/[false]"											<< endl
+	<< " *   When true, colliding features are probed to different slots. When false "	<< endl
+	<< " *   (default), colliding features share a weight"								<< endl
+<< endl
+	<< " *  -weights_precision [double]/[single]/[fixed16]"									<< endl
+	<< " *   Precision of the Sarsa-Lambda weights: 8 (default), 4 or 2 bytes per weight. "	<< endl
+	<< " *   fixed16 is experimental: weights are multiples of fixed_weights_step, "		<< endl
+	<< " *   saturate at +/- 32767 steps, and updates are rounded stochastically. "		<< endl
+	<< " *   The optimistic_init weights are usually below one step, so most of "		<< endl
+	<< " *   them start at 0"																<< endl
+<< endl
+	<< " *  -fixed_weights_step f"															<< endl
+	<< " *   Value of one step of the fixed16 weights. Default is 0.0009765625 (2^-10)"	<< endl
+<< endl
+	<< " *  -interleave_action_weights [true]/[false]"										<< endl
+	<< " *   When true, the ram and grid-screen agents store the weights of all "	<< endl
+	<< " *   the actions for one feature contiguously, and compute all the Q-values in a "	<< endl
+	<< " *   single pass over the active features. Ignored with hashed weights. "			<< endl
+	<< " *   Default is false: with incremental_q, only the cost of the wider weight "		<< endl
+	<< " *   and trace updates remains"													<< endl
+<< endl
+	<< " *  -incremental_q [true]/[false]"													<< endl
+	<< " *   When true (default), the ram and grid-screen agents keep a running Q-value "	<< endl
+	<< " *   per action, and only add/subtract the weights of the features that changed "	<< endl
+	<< " *   since the last step (and the weights that were updated). Ignored with "		<< endl
+	<< " *   hashed weights"																<< endl
+<< endl
+	<< " *  -incremental_q_recompute_frq n"												<< endl
+	<< " *   How often (in steps) the incremental Q-values are recomputed from scratch, "	<< endl
+	<< " *   to bound the rounding drift. Default is 1000"									<< endl
+<< endl
+	<< " * Sarsa-Benchmark Parameters (for the sarsa_benchmark executable)"				<< endl
+	<< " *  -bench_variants list"															<< endl
+	<< " *   Comma separated step-size variants: plain, idbd and/or dbd. Default is all"	<< endl
+<< endl
+	<< " *  -bench_feature_sizes list"														<< endl
+	<< " *   Comma separated numbers of tile-coding features. Default is "					<< endl
+	<< " *   1000,10000,100000"															<< endl
+<< endl
+	<< " *  -bench_trace_ratios list"														<< endl
+	<< " *   Comma separated trace_vec_size_ratio values (the trace caps). Default is "	<< endl
+	<< " *   0.01,0.1"																		<< endl
+<< endl
+	<< " *  -bench_steps n"																	<< endl
+	<< " *   Number of MountainCar steps of each run. Default is 200000"					<< endl
+<< endl
+	<< " *  -bench_output_file file"														<< endl
+	<< " *   The CSV file with the steps/sec of GetTiles, computeActionValues, "			<< endl
+	<< " *   updateTraces, updateWeights and the whole steps, for each run. Default "		<< endl
+	<< " *   is sarsa_benchmark.csv"														<< endl
+<< endl
+	<< " * Bit-Pair-Benchmark Parameters (for the bit_pair_benchmark executable)"	<< endl
+	<< " *  -ram_dump_file file"															<< endl
+	<< " *   The RAM dumps (128 bytes per frame) replayed through the RAMAgent feature "	<< endl
+	<< " *   generators. When the file is missing, the given ROM is first played with "	<< endl
+	<< " *   random actions and its RAM recorded there. Default is ram_dumps.bin"		<< endl
+<< endl
+	<< " *  -ram_dump_frames n"																<< endl
+	<< " *   Number of frames to record in ram_dump_file. Default is 10000"				<< endl
 << endl
 	<< " *  -use_delta_bar_delta [true]/[false]  "											<< endl
 	<< " *   When true, we will use delta-bar-delta to calculate dynamic step sizes in SARSA"  << endl
@@ -524,6 +733,9 @@ void Settings::usage() {
 	<< " *   Maximum velocity (pixel/sec) of objects on screen. Default is 8"				<< endl
 	<< " *  -max_num_detected_instaces n"													<< endl
 	<< " *   Maximum number of instances that will be detected from each class."			<< endl
+	<< " *  -max_pair_distance n"															<< endl
+	<< " *   Pairs of class instances further apart than n pixels (in x or y) are left"	<< endl
+	<< " *   out of the feature-vector. Default is 0 (never)"								<< endl
 	
 << endl
 << endl
@@ -544,9 +756,23 @@ void Settings::usage() {
 	<< " * Class-Discovery Settings (usually loaded from 'class_disc_params.txt') :"		<< endl
 	<< " *  -do_bg_detection [true]/[false]"												<< endl
 	<< " *   When true, the player-agent will also do backgroudn detection."				<< endl
+<< endl
+	<< " *  -bg_detect_stable_frames n"														<< endl
+	<< " *   When positive, background detection stops as soon as the detected background"	<< endl
+	<< " *   has not changed for n frames. Default is 0 (never stop early)"				<< endl
 << endl
 	<< " *  -do_class_disc [true]/[false]"													<< endl
 	<< " *   When true, the player-agent will also do class discovery."						<< endl
+<< endl
+	<< " *  -record_frames_file filename"													<< endl
+	<< " *   When set, the player-agent records the screens that it would send to the "	<< endl
+	<< " *   background-detection and class-discovery in this (gzipped) file. "			<< endl
+	<< " *   class_disc_tool reads them from the same setting, and runs the background-"	<< endl
+	<< " *   detection (do_bg_detection) and the class-discovery (do_class_disc) on them "	<< endl
+	<< " *   offline, in parallel. Default is no recording"								<< endl
+<< endl
+	<< " *  -class_disc_num_workers n"														<< endl
+	<< " *   Number of processes that class_disc_tool runs. Default is 0 (one per core)"	<< endl
 << endl
 	<< " *  -cls_disc_frames_num n"															<< endl
 	<< " *   Number of frames to use for class discovery."									<< endl
@@ -583,7 +809,7 @@ void Settings::usage() {
 << endl
 << endl
 	<< " * Search-Agent Agent Paramaters (loaded from 'search_params.txt')"				<< endl
-	<< " *  -search_method [fulltree/uct]"													<< endl
+	<< " *  -search_method [fulltree/uct/mc]"												<< endl
 	<< " *   Determines the method to be used by the Search-Agent "						<< endl
 << endl
 	<< " *  -sim_steps_per_node n"															<< endl
@@ -612,6 +838,50 @@ void Settings::usage() {
 	<< " *  -uct_avg_reward_per_frame [true]/[false]"										<< endl
 	<< " *   When true, uct will look at reward/frame (not just reward). This is to prevent"<< endl
 	<< " *   biasing towards exploring already deeper sub-branches"						<< endl
+<< endl
+	<< " *  -uct_rollout_frame_skip n"														<< endl
+	<< " *   When n > 0, each random action in a Monte Carlo rollout is held for n frames,"<< endl
+	<< " *   and the reward and end-of-game are only checked at the end of each hold."		<< endl
+	<< " *   0 (default) means the reward is checked on every frame"						<< endl
+<< endl
+	<< " *  -uct_rollout_ram_watch i,j,..."												<< endl
+	<< " *   RAM indices that trigger a reward and end-of-game check as soon as they "		<< endl
+	<< " *   change, when uct_rollout_frame_skip > 0. Default is empty"					<< endl
+<< endl
+	<< " *  -uct_prune_actions [true]/[false]"												<< endl
+	<< " *   When true, actions that always lead to identical states are grouped, and UCT "<< endl
+	<< " *   only expands one action per group. Default is false"							<< endl
+<< endl
+	<< " *  -uct_prune_warmup_expansions n"												<< endl
+	<< " *   Number of full expansions used to learn the groups of actions. Default is 20"	<< endl
+<< endl
+	<< " *  -uct_prune_recheck_frq n"														<< endl
+	<< " *   Every n expansions, all actions are expanded again to re-check the groups."	<< endl
+	<< " *   0 means never. Default is 100"												<< endl
+<< endl
+	<< " *  -search_telemetry_file path"													<< endl
+	<< " *   CSV file that gets one row of statistics (iterations, nodes, state bytes, "	<< endl
+	<< " *   depth, rollout speed and the time split) per decision. Default is empty, "	<< endl
+	<< " *   which prints a summary line per decision instead"							<< endl
+<< endl
+	<< " *  -mc_rollouts_per_batch n"														<< endl
+	<< " *   Number of rollouts run from each child of the root in one batch of the "		<< endl
+	<< " *   Monte Carlo search. Default is 1"												<< endl
+<< endl
+	<< " *  -fulltree_max_mem_mb n"														<< endl
+	<< " *   Memory budget (in MB) for the frontier states of the full-tree. The tree "	<< endl
+	<< " *   stops growing when the budget (and the spill file) is full. "				<< endl
+	<< " *   0 (default) means no budget"													<< endl
+<< endl
+	<< " *  -fulltree_max_spill_mb n"														<< endl
+	<< " *   Maximum size (in MB) of the spill file for the full-tree states. Default is 0"<< endl
+<< endl
+	<< " *  -fulltree_spill_file path"														<< endl
+	<< " *   Path of the spill file. Default is fulltree_states.spill"					<< endl
+<< endl
+	<< " *  -fulltree_reuse_tree [true]/[false]"											<< endl
+	<< " *   When true, the full-tree is kept between decisions and expanded "			<< endl
+	<< " *   breadth-first from its leaves. Default is false"								<< endl
 << endl
     << endl;
 }
@@ -55,6 +55,23 @@ TIA::TIA(const Console& console, Settings& settings)
   myFrameGreyed = false;
   myPartialFrameFlag = false; //ALE : This was left uninitialized :(
 
+  // ALE : The object trace is off by default, and has a line per row
+  // of the frame buffer
+  myObjectTraceEnabled = false;
+  myObjectTrace = new ObjectTraceLine[300];
+  memset(myObjectTrace, 0, 300 * sizeof(ObjectTraceLine));
+
+  // ALE : So is the dirty span tracking
+  myDirtyTrackingEnabled = false;
+  myDirtyAllPending = true;
+  myDirtyAll = true;
+  myDirtySpans = new DirtySpan[300];
+  for(i = 0; i < 300; ++i)
+  {
+    myDirtySpans[i].start = 0;
+    myDirtySpans[i].end = 160;
+  }
+
   for(i = 0; i < 6; ++i)
     myBitEnabled[i] = true;
 
@@ -118,6 +135,8 @@ TIA::~TIA()
 {
   delete[] myCurrentFrameBuffer;
   delete[] myPreviousFrameBuffer;
+  delete[] myObjectTrace;
+  delete[] myDirtySpans;
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -217,6 +236,7 @@ void TIA::frameReset()
 {
   // Clear frame buffers
   clearBuffers();
+  myDirtyAllPending = true;
 
   // Reset pixel pointer and drawing flag
   myFramePointer = myCurrentFrameBuffer;
@@ -417,6 +437,9 @@ bool TIA::load(Deserializer& in)
     myCurrentScanline = (Int32) in.getInt();
     myVSYNCFinishClock = (Int32) in.getInt();
 
+    // The frame buffers are not part of the state
+    myDirtyAllPending = true;
+
     myEnabledObjects = (uInt8) in.getInt();
 
     myVSYNC = (uInt8) in.getInt();
@@ -574,6 +597,26 @@ inline void TIA::startFrame()
     }
   }   
 
+  // Only the objects drawn on this frame are in its trace
+  if(myObjectTraceEnabled)
+  {
+    for(uInt32 row = 0; row < 300; ++row)
+      myObjectTrace[row].enabled = 0;
+  }
+
+  // All the rows start clean, unless the previous frame buffer cannot be
+  // compared with
+  if(myDirtyTrackingEnabled)
+  {
+    myDirtyAll = myDirtyAllPending;
+    myDirtyAllPending = false;
+    for(uInt32 row = 0; row < 300; ++row)
+    {
+      myDirtySpans[row].start = myDirtyAll ? 0 : myFrameWidth;
+      myDirtySpans[row].end = myDirtyAll ? myFrameWidth : 0;
+    }
+  }
+
   myFrameGreyed = false;
 }
 
@@ -584,6 +627,20 @@ inline void TIA::endFrame()
   // Compute the number of scanlines in the frame
   myScanlineCountForLastFrame = myCurrentScanline;
 
+  // The rest of the frame buffer was not drawn on this frame: it holds
+  // what was drawn two frames ago
+  if(myDirtyTrackingEnabled && !myDirtyAll)
+  {
+    uInt32 offset = myFramePointer - myCurrentFrameBuffer;
+    uInt32 frameEnd = myFrameWidth * myFrameHeight;
+    while(offset < frameEnd)
+    {
+      uInt32 length = myFrameWidth - (offset % myFrameWidth);
+      updateDirtySpan(offset, length);
+      offset += length;
+    }
+  }
+
   // Stats counters
   myFrameCounter++;
 
@@ -1854,9 +1911,15 @@ inline void TIA::updateFrame(Int32 clock)
     // Remember frame pointer in case HMOVE blanks need to be handled
     uInt8* oldFramePointer = myFramePointer;
 
+    // The end of the pixels written on this scanline
+    uInt8* writtenEnd = myFramePointer;
+
     // Update as much of the scanline as we can
     if(clocksToUpdate != 0)
     {
+      if(myObjectTraceEnabled)
+        recordObjectTrace();
+
       updateFrameScanline(clocksToUpdate, clocksFromStartOfScanLine - HBLANK);
     }
 
@@ -1866,6 +1929,7 @@ inline void TIA::updateFrame(Int32 clock)
     {
       Int32 blanks = (HBLANK + 8) - clocksFromStartOfScanLine;
       memset(oldFramePointer, 0, blanks);
+      writtenEnd = oldFramePointer + blanks;
 
       if((clocksToUpdate + clocksFromStartOfScanLine) >= (HBLANK + 8))
       {
@@ -1873,6 +1937,16 @@ inline void TIA::updateFrame(Int32 clock)
       }
     }
 
+    // Compare the written pixels with the previous frame
+    if(myDirtyTrackingEnabled && !myDirtyAll)
+    {
+      if(myFramePointer > writtenEnd)
+        writtenEnd = myFramePointer;
+      if(writtenEnd > oldFramePointer)
+        updateDirtySpan(oldFramePointer - myCurrentFrameBuffer, 
+                        writtenEnd - oldFramePointer);
+    }
+
     // See if we're at the end of a scanline
     if(myClocksToEndOfScanLine == 228)
     {
@@ -1926,6 +2000,101 @@ inline void TIA::updateFrame(Int32 clock)
   while(myClockAtLastUpdate < clock);
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TIA::recordObjectTrace()
+{
+  // Nothing is drawn in the vertical blank region
+  if(myVBLANK & 0x02)
+    return;
+
+  uInt8 objects = myEnabledObjects & 
+      (myP0Bit | myP1Bit | myM0Bit | myM1Bit | myBLBit);
+  if(objects == 0)
+    return;
+
+  uInt32 row = (myFramePointer - myCurrentFrameBuffer) / myFrameWidth;
+  if(row >= 300)
+    return;
+
+  ObjectTraceLine& line = myObjectTrace[row];
+  if(objects & myP0Bit)
+  {
+    line.enabled |= (1 << P0);
+    line.x[P0] = myPOSP0 - myFrameXStart;
+    line.color[P0] = myCOLUP0 & 0xff;
+    line.grp[0] = myCurrentGRP0;
+    line.nusiz[0] = myNUSIZ0;
+  }
+  if(objects & myP1Bit)
+  {
+    line.enabled |= (1 << P1);
+    line.x[P1] = myPOSP1 - myFrameXStart;
+    line.color[P1] = myCOLUP1 & 0xff;
+    line.grp[1] = myCurrentGRP1;
+    line.nusiz[1] = myNUSIZ1;
+  }
+  if(objects & myM0Bit)
+  {
+    line.enabled |= (1 << M0);
+    line.x[M0] = myPOSM0 - myFrameXStart;
+    line.color[M0] = myCOLUP0 & 0xff;
+    line.nusiz[0] = myNUSIZ0;
+  }
+  if(objects & myM1Bit)
+  {
+    line.enabled |= (1 << M1);
+    line.x[M1] = myPOSM1 - myFrameXStart;
+    line.color[M1] = myCOLUP1 & 0xff;
+    line.nusiz[1] = myNUSIZ1;
+  }
+  if(objects & myBLBit)
+  {
+    line.enabled |= (1 << BL);
+    line.x[BL] = myPOSBL - myFrameXStart;
+    line.color[BL] = myCOLUPF & 0xff;
+    line.ctrlpf = myCTRLPF;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TIA::enableDirtyTracking(bool mode)
+{
+  if(mode && !myDirtyTrackingEnabled)
+    myDirtyAllPending = true;
+
+  myDirtyTrackingEnabled = mode;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+inline void TIA::updateDirtySpan(uInt32 offset, uInt32 length)
+{
+  const uInt8* current = myCurrentFrameBuffer + offset;
+  const uInt8* previous = myPreviousFrameBuffer + offset;
+
+  // Most of the pixels are the same as on the previous frame
+  if(memcmp(current, previous, length) == 0)
+    return;
+
+  uInt32 row = offset / myFrameWidth;
+  if(row >= 300)
+    return;
+
+  uInt32 first = 0;
+  while(current[first] == previous[first])
+    ++first;
+
+  uInt32 last = length - 1;
+  while(current[last] == previous[last])
+    --last;
+
+  uInt32 column = offset - row * myFrameWidth;
+  DirtySpan& span = myDirtySpans[row];
+  if(column + first < span.start)
+    span.start = column + first;
+  if(column + last + 1 > span.end)
+    span.end = column + last + 1;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 inline void TIA::waitHorizontalSync()
 {
@@ -213,6 +213,71 @@ class TIA : public Device , public MediaSource
     */
     void enableBits(bool mode) { for(uInt8 i = 0; i < 6; ++i) myBitEnabled[i] = mode; }
 
+    /**
+      The state of the movable objects (P0, P1, M0, M1 and BL, indexed
+      by TIABit) on one scanline of the frame, as recorded by the object 
+      trace.  When a register changes in the middle of the scanline, the 
+      values of the last part of the scanline that drew the object are kept.
+    */
+    struct ObjectTraceLine
+    {
+      uInt8 enabled;      // Bit (1 << TIABit) is set when the object is drawn
+      Int16 x[5];         // Frame column of the first pixel of each object
+      uInt8 color[5];     // Color of each object
+      uInt8 grp[2];       // Graphics of the players (already reflected)
+      uInt8 nusiz[2];     // Number and size of the players and missles
+      uInt8 ctrlpf;       // Playfield control register (size of the ball)
+    };
+
+    /**
+      Enables/disables the object trace.  While it is enabled, the TIA
+      records the movable objects of each scanline of the frame it draws.
+    */
+    void enableObjectTrace(bool mode) { myObjectTraceEnabled = mode; }
+
+    /**
+      Answers the object trace of the last frame, one line per row of the
+      frame buffer (height() lines).  Only valid while the trace is enabled.
+
+      @return Pointer to the first line of the trace
+    */
+    const ObjectTraceLine* objectTrace() const { return myObjectTrace; }
+
+    /**
+      The columns [start, end) of a row of the frame buffer that may differ
+      from the previous frame (the row is unchanged when start >= end)
+    */
+    struct DirtySpan
+    {
+      uInt16 start;
+      uInt16 end;
+    };
+
+    /**
+      Enables/disables the dirty span tracking.  While it is enabled, the
+      TIA compares each part of a scanline it draws with the previous frame 
+      buffer, and keeps the span of the changed pixels of each row.  The
+      first frame after the tracking is enabled, or after a state is loaded,
+      is all dirty.
+    */
+    void enableDirtyTracking(bool mode);
+
+    /**
+      Answers the dirty spans of the last frame, one span per row of the 
+      frame buffer (height() spans).  Only valid while the tracking is 
+      enabled.
+
+      @return Pointer to the span of the first row
+    */
+    const DirtySpan* dirtySpans() const { return myDirtySpans; }
+
+    /**
+      Answers the number of frames finished by this TIA
+
+      @return The number of frames
+    */
+    int frameCount() const { return myFrameCounter; }
+
 #ifdef DEBUGGER_SUPPORT
     /**
       This method should be called to update the media source with
@@ -277,6 +342,14 @@ class TIA : public Device , public MediaSource
     // Update bookkeeping at end of frame
     void endFrame();
 
+    // Record the movable objects drawn on the current scanline in the
+    // object trace
+    void recordObjectTrace();
+
+    // Add the pixels that differ from the previous frame in the given part
+    // of a row of the frame buffer to the dirty span of the row
+    void updateDirtySpan(uInt32 offset, uInt32 length);
+
   private:
     // Console the TIA is associated with
     const Console& myConsole;
@@ -509,6 +582,26 @@ class TIA : public Device , public MediaSource
 	 // Has current frame been "greyed out" (has updateScanline() been run?)
 	 bool myFrameGreyed;
 
+  private:
+    // Indicates if the object trace is recorded
+    bool myObjectTraceEnabled;
+
+    // The object trace of the current frame (one line per frame row)
+    ObjectTraceLine* myObjectTrace;
+
+    // Indicates if the dirty spans are tracked
+    bool myDirtyTrackingEnabled;
+
+    // Indicates if the next frame should be all dirty (the previous frame
+    // buffer does not hold the previous frame)
+    bool myDirtyAllPending;
+
+    // Indicates if the current frame is all dirty (nothing is compared)
+    bool myDirtyAll;
+
+    // The dirty span of each row of the current frame
+    DirtySpan* myDirtySpans;
+
   private:
     // Ball mask table (entries are true or false)
     static uInt8 ourBallMaskTable[4][4][320];
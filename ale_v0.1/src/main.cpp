@@ -17,6 +17,7 @@
 #include "OSystemUNIX.hxx"
 #include "fifo_controller.h"
 #include "internal_controller.h"
+#include "learning_workers.h"
 #include "common_constants.h"
 
 string str_ver = "0.1";
@@ -119,11 +120,22 @@ int main(int argc, char* argv[]) {
     // Set the Pallete 
     theOSystem->console().setPalette("standard");
     
+    // Fork the other learning workers (if any), now that the player agent 
+    // and its shared weights exist
+    int worker_id = spawn_learning_workers(theOSystem);
+    
     
 	
 	
 	// Start the main loop, and don't exit until the user issues a QUIT command
-	theOSystem->mainLoop();
+	if (worker_id == 0 && is_actor_learner_mode(theOSystem)) {
+		run_learner(theOSystem);	// the actors play
+	} else {
+		theOSystem->mainLoop();
+	}
+	if (worker_id == 0) {
+		join_learning_workers(theOSystem);
+	}
 	
 	// Cleanup time ...
 	Cleanup();
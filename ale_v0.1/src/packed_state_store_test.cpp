@@ -0,0 +1,102 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  packed_state_store_test.cpp
+ *
+ *  The entry point for packed_state_store_test (run by make check): checks
+ *  that PackedStateStore reuses the released bytes of its memory buffer
+ *  instead of spilling, and moves the spilled states back into memory when
+ *  they fit again. Exits with -1 on the first failed check
+ **************************************************************************** */
+#include <cstdlib>
+#include <deque>
+#include <sstream>
+#include "packed_state_store.h"
+
+#define STATE_BYTES 100			// Size of the test states
+#define MEM_STATES 10			// Number of states the memory buffer holds
+
+/* *********************************************************************
+	Exits with an error when the condition is false
+ ******************************************************************* */
+static void check(bool condition, const string& what) {
+	if (!condition) {
+		cerr << "packed_state_store_test: FAILED: " << what << endl;
+		exit(-1);
+	}
+}
+
+/* *********************************************************************
+	Returns the test state number i
+ ******************************************************************* */
+static string make_state(int i) {
+	ostringstream state;
+	state << "state " << i << " ";
+	string text = state.str();
+	text.resize(STATE_BYTES, (char)('a' + i % 26));
+	return text;
+}
+
+/* *********************************************************************
+	Keeps MEM_STATES - 2 states live while releasing and putting states in
+	a loop: the released bytes always make room, so nothing is spilled
+ ******************************************************************* */
+static void test_release_and_put(const string& spill_file) {
+	PackedStateStore store(MEM_STATES * STATE_BYTES,
+						   1000 * STATE_BYTES, spill_file);
+	deque< pair<int, int> > live;	// (handle, state number)
+	for (int i = 0; i < 10000; i++) {
+		if (live.size() == MEM_STATES - 2) {
+			store.release(live.front().first);
+			live.pop_front();
+		}
+		live.push_back(make_pair(store.put(make_state(i)), i));
+		check(store.get_spilled_bytes() == 0,
+			  "a state was spilled while the memory had released bytes");
+	}
+	for (unsigned int i = 0; i < live.size(); i++) {
+		check(store.get(live[i].first) == make_state(live[i].second),
+			  "a state changed after the memory buffer was packed");
+	}
+}
+
+/* *********************************************************************
+	Fills the memory buffer and spills some states, releases the states
+	in memory, and checks that the spilled states move back into memory
+ ******************************************************************* */
+static void test_spill_moves_back(const string& spill_file) {
+	PackedStateStore store(MEM_STATES * STATE_BYTES,
+						   1000 * STATE_BYTES, spill_file);
+	IntVect handles;
+	for (int i = 0; i < MEM_STATES + 5; i++) {
+		handles.push_back(store.put(make_state(i)));
+	}
+	check(store.get_spilled_bytes() == 5 * STATE_BYTES,
+		  "the states beyond the memory buffer were not spilled");
+	for (int i = 0; i < MEM_STATES; i++) {
+		store.release(handles[i]);
+	}
+	int handle = store.put(make_state(MEM_STATES + 5));
+	check(store.get_spilled_bytes() == 0,
+		  "the spilled states did not move back into memory");
+	check(store.get(handle) == make_state(MEM_STATES + 5),
+		  "the new state changed");
+	for (int i = MEM_STATES; i < MEM_STATES + 5; i++) {
+		check(store.get(handles[i]) == make_state(i),
+			  "a spilled state changed when moved back into memory");
+	}
+}
+
+int main(int argc, char* argv[]) {
+	string spill_file = "packed_state_store_test.spill";
+	test_release_and_put(spill_file);
+	test_spill_moves_back(spill_file);
+	cout << "packed_state_store_test: all checks passed" << endl;
+	return 0;
+}
@@ -0,0 +1,172 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  actor_learner_channel.cpp
+ *
+ *  Implementation of the ActorLearnerChannel class, the shared memory through
+ *  which actor processes send their transitions to the learner process, and
+ *  the learner publishes its weights to the actors
+ **************************************************************************** */
+
+#include "actor_learner_channel.h"
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define RING_FULL_SLEEP_USECS 100	// How long an actor sleeps when its
+									// ring is full
+
+/* *********************************************************************
+	Constructor
+	ring_bytes is the size of the ring of each actor. The snapshots
+	start as a copy of p_weights
+ ******************************************************************* */
+ActorLearnerChannel::ActorLearnerChannel(int num_actors, long long ring_bytes,
+										 const WeightVector* p_weights) :
+	i_num_actors(num_actors),
+	i_ring_ints(ring_bytes / sizeof(int)) {
+	i_map_bytes = sizeof(SharedControl) + sizeof(RingControl) * num_actors +
+				  i_ring_ints * sizeof(int) * num_actors;
+	// SharedControl is padded to the alignment of the RingControls
+	i_map_bytes += sizeof(RingControl);
+	void* map = mmap(NULL, i_map_bytes, PROT_READ | PROT_WRITE,
+					 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		cerr << "Cannot map " << i_map_bytes << " bytes of transition rings"
+			 << endl;
+		exit(-1);
+	}
+	p_map = (char*)map;
+	p_control = (SharedControl*)p_map;
+	p_rings = (RingControl*)(p_map + sizeof(RingControl));
+	p_ring_data = (int*)(p_rings + num_actors);
+	for (int i = 0; i < num_actors; i++) {
+		p_rings[i].head = 0;
+		p_rings[i].tail = 0;
+	}
+	for (int i = 0; i < 2; i++) {
+		pv_snapshots[i] = new WeightVector(p_weights->size(),
+										   p_weights->get_precision(), 0.0,
+										   p_weights->get_fixed_step(), true);
+		memcpy(pv_snapshots[i]->get_raw_data(), p_weights->get_raw_data(),
+			   p_weights->get_num_bytes());
+	}
+	p_control->published = 0;
+	p_control->learner_pid = getpid();
+}
+
+/* *********************************************************************
+	Deconstructor
+ ******************************************************************* */
+ActorLearnerChannel::~ActorLearnerChannel() {
+	delete pv_snapshots[0];
+	delete pv_snapshots[1];
+	munmap(p_map, i_map_bytes);
+}
+
+/* *********************************************************************
+	Actor side: appends a record to the ring of the given actor.
+	lists holds the first num_lists lists of features_map, with the
+	lengths in num_nonzero. Waits while the ring is full, and exits
+	when the learner process is gone (the actor is then re-parented)
+ ******************************************************************* */
+void ActorLearnerChannel::push(int actor, int type, int action, float reward,
+							   float final_value,
+							   const FeatureMap* features_map,
+							   const IntVect* num_nonzero, int num_lists) {
+	long long length = RECORD_HEADER_INTS;
+	for (int l = 0; l < num_lists; l++) {
+		length += 1 + (*num_nonzero)[l];
+	}
+	if (length > i_ring_ints) {
+		cerr << "A transition of " << length * sizeof(int) << " bytes does "
+			 << "not fit in the transition ring (actor_ring_bytes)" << endl;
+		exit(-1);
+	}
+	RingControl& ring = p_rings[actor];
+	while (i_ring_ints - (ring.head - ring.tail) < length) {
+		if (getppid() != p_control->learner_pid) {
+			cerr << "Actor " << actor << ": the learner process is gone, "
+				 << "exiting" << endl;
+			exit(-1);
+		}
+		usleep(RING_FULL_SLEEP_USECS);
+	}
+	int* data = p_ring_data + actor * i_ring_ints;
+	long long pos = ring.head;
+	int header[RECORD_HEADER_INTS];
+	header[RECORD_LENGTH] = length;
+	header[RECORD_TYPE] = type;
+	header[RECORD_ACTION] = action;
+	header[RECORD_REWARD] = float_to_int_bits(reward);
+	header[RECORD_FINAL_VALUE] = float_to_int_bits(final_value);
+	header[RECORD_NUM_LISTS] = num_lists;
+	for (int k = 0; k < RECORD_HEADER_INTS; k++, pos++) {
+		data[pos % i_ring_ints] = header[k];
+	}
+	for (int l = 0; l < num_lists; l++) {
+		int num_features = (*num_nonzero)[l];
+		data[pos % i_ring_ints] = num_features;
+		pos++;
+		const IntArr& features = (*features_map)[l];
+		for (int j = 0; j < num_features; j++, pos++) {
+			data[pos % i_ring_ints] = features[j];
+		}
+	}
+	__sync_synchronize();	// the record is complete before we publish it
+	ring.head = pos;
+}
+
+/* *********************************************************************
+	Learner side: copies the oldest record of the given actor into
+	record, and returns false if its ring is empty
+ ******************************************************************* */
+bool ActorLearnerChannel::pop(int actor, IntVect& record) {
+	RingControl& ring = p_rings[actor];
+	long long pos = ring.tail;
+	if (pos == ring.head) {
+		return false;
+	}
+	__sync_synchronize();	// read the record after seeing its head
+	const int* data = p_ring_data + actor * i_ring_ints;
+	int length = data[pos % i_ring_ints];
+	record.resize(length);
+	for (int k = 0; k < length; k++, pos++) {
+		record[k] = data[pos % i_ring_ints];
+	}
+	__sync_synchronize();	// done reading before the actor may overwrite
+	ring.tail = pos;
+	return true;
+}
+
+/* *********************************************************************
+	Learner side: publishes a snapshot of the given weights
+ ******************************************************************* */
+void ActorLearnerChannel::publish(const WeightVector* p_weights) {
+	int next = 1 - p_control->published;
+	memcpy(pv_snapshots[next]->get_raw_data(), p_weights->get_raw_data(),
+		   p_weights->get_num_bytes());
+	__sync_synchronize();
+	p_control->published = next;
+}
+
+/* *********************************************************************
+	Reads/Writes a float stored in the bits of an int
+ ******************************************************************* */
+float ActorLearnerChannel::int_bits_to_float(int bits) {
+	float value;
+	memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+int ActorLearnerChannel::float_to_int_bits(float value) {
+	int bits;
+	memcpy(&bits, &value, sizeof(float));
+	return bits;
+}
@@ -0,0 +1,128 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  actor_learner_channel.h
+ *
+ *  Implementation of the ActorLearnerChannel class, the shared memory through
+ *  which actor processes send their transitions to the learner process, and
+ *  the learner publishes its weights to the actors
+ **************************************************************************** */
+
+#ifndef ACTOR_LEARNER_CHANNEL_H
+#define ACTOR_LEARNER_CHANNEL_H
+
+#include <sys/types.h>
+#include "common_constants.h"
+#include "weight_vector.h"
+
+// Types of the transition records
+#define TRANSITION_START	0	// features and action of s0
+#define TRANSITION_STEP		1	// reward, then features and action of s'
+#define TRANSITION_END		2	// reward and value of the final state
+
+// Layout of a record (in ints): the header, followed by num_lists lists of
+// features, each preceded by its length
+#define RECORD_LENGTH		0	// Length of the whole record
+#define RECORD_TYPE			1
+#define RECORD_ACTION		2
+#define RECORD_REWARD		3	// float, stored in the bits of an int
+#define RECORD_FINAL_VALUE	4	// float, stored in the bits of an int
+#define RECORD_NUM_LISTS	5
+#define RECORD_HEADER_INTS	6
+
+class ActorLearnerChannel {
+    /* *************************************************************************
+        Everything the actors and the learner share, allocated in MAP_SHARED
+		mappings before the actor processes are forked:
+		 - One single-producer/single-consumer ring per actor, carrying
+		   compact transition records (see above). An actor blocks while
+		   its ring is full, so it never runs far ahead of the learner
+		   (and exits if the learner is gone while it waits).
+		 - Two weight snapshots. The learner copies its weights into the
+		   snapshot that is not published, then publishes it. The actors
+		   compute their Q-values straight from the published snapshot.
+		   If the learner publishes twice during one actor step, the actor
+		   may read a mix of two snapshots (which, as in Hogwild, only
+		   makes its action choice slightly stale)
+    ************************************************************************* */
+
+    public:
+		/* *********************************************************************
+            Constructor
+			ring_bytes is the size of the ring of each actor. The snapshots
+			start as a copy of p_weights
+         ******************************************************************* */
+		ActorLearnerChannel(int num_actors, long long ring_bytes,
+							const WeightVector* p_weights);
+
+		/* *********************************************************************
+            Deconstructor
+         ******************************************************************* */
+		~ActorLearnerChannel();
+
+		/* *********************************************************************
+            Actor side: appends a record to the ring of the given actor.
+			lists holds the first num_lists lists of features_map, with the
+			lengths in num_nonzero. Waits while the ring is full, and exits
+			when the learner process is gone
+         ******************************************************************* */
+		void push(int actor, int type, int action, float reward,
+				  float final_value, const FeatureMap* features_map,
+				  const IntVect* num_nonzero, int num_lists);
+
+		/* *********************************************************************
+            Learner side: copies the oldest record of the given actor into
+			record, and returns false if its ring is empty
+         ******************************************************************* */
+		bool pop(int actor, IntVect& record);
+
+		/* *********************************************************************
+            Learner side: publishes a snapshot of the given weights
+         ******************************************************************* */
+		void publish(const WeightVector* p_weights);
+
+		/* *********************************************************************
+            Actor side: returns the last published snapshot
+         ******************************************************************* */
+		WeightVector* get_snapshot(void) {
+			return pv_snapshots[p_control->published];
+		}
+
+		int get_num_actors(void) const {return i_num_actors;}
+
+		/* *********************************************************************
+            Reads/Writes a float stored in the bits of an int
+         ******************************************************************* */
+		static float int_bits_to_float(int bits);
+		static int float_to_int_bits(float value);
+
+	protected:
+		struct RingControl {
+			volatile long long head;	// Ints written by the actor
+			char pad1[56];				// (head and tail on separate lines)
+			volatile long long tail;	// Ints read by the learner
+			char pad2[56];
+		};
+		struct SharedControl {
+			volatile int published;		// Index of the published snapshot
+			pid_t learner_pid;			// The process that created the
+										// channel (the actors' parent)
+		};
+
+		int i_num_actors;
+		long long i_ring_ints;			// Capacity of each ring, in ints
+		long long i_map_bytes;			// Size of the rings mapping
+		char* p_map;					// The rings mapping
+		SharedControl* p_control;		// In the rings mapping
+		RingControl* p_rings;			// One per actor, in the rings mapping
+		int* p_ring_data;				// i_ring_ints ints per actor
+		WeightVector* pv_snapshots[2];	// The two weight snapshots
+};
+
+#endif
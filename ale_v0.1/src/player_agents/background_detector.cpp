@@ -13,21 +13,39 @@
  *  detecting the background from the given screens
  **************************************************************************** */
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <cstring>
 #include "background_detector.h"
 #include "game_controller.h"
 #include "export_tools.h"
 
 
-BackgroundDetector::BackgroundDetector(OSystem* _osystem) {
+BackgroundDetector::BackgroundDetector(OSystem* _osystem, 
+									   ScreenPlanes* screen_planes) {
 	p_osystem = _osystem;
 	i_frames_num = p_osystem->settings().getInt("bg_detect_frames_num", true);
+	i_stable_frames_num = p_osystem->settings().getInt(
+											"bg_detect_stable_frames", true);
 	i_frames_counter = 0;
+	i_stable_counter = 0;
 	MediaSource& mediasrc = p_osystem->console().mediaSource();
     i_screen_width  = mediasrc.width();
     i_screen_height = mediasrc.height();
-	v_color_counts.clear();
-	for (int i = 0; i < i_screen_height * i_screen_width * NUM_COLORS; i++) {
-		v_color_counts.push_back(0);
+	i_num_pixels = i_screen_height * i_screen_width;
+	i_padded_pixels = (i_num_pixels + 15) / 16 * 16;
+	v_screen_colors.assign(i_padded_pixels, 0);
+	v_curr_modes.assign(i_padded_pixels, 0);
+	v_slot_counts.assign(BG_NUM_SLOTS * i_padded_pixels, 0);
+	v_slot_colors.resize(BG_NUM_SLOTS * i_padded_pixels);
+	i_first_pixel = 0;
+	i_end_pixel = i_padded_pixels;
+	for (int s = 0; s < BG_NUM_SLOTS; s++) {
+		// the placeholder color of the empty slot s
+		for (int p = 0; p < i_padded_pixels; p++) {
+			v_slot_colors[s * i_padded_pixels + p] = s;
+		}
 	}
 }
 
@@ -37,30 +55,190 @@ BackgroundDetector::~BackgroundDetector() {
 }
 
 /* *********************************************************************
-	Recieves a new screen, and updates the color-counts
+	Recieves a new screen, and updates the color summaries
  ******************************************************************** */
-void BackgroundDetector::get_new_screen(const IntMatrix* pv_screen) {
+void BackgroundDetector::get_new_screen(ScreenPlanes* screen_planes) {
 	if (i_frames_counter > i_frames_num) {
 		return; // we've already extracted the background
 	}
-	int pixel_ind = 0;	// location for the current pixel in v_color_counts
+	const IntMatrix* screen_matrix = screen_planes->get_screen_matrix();
 	for (int i = 0; i < i_screen_height; i++) {
+		const IntVect& row = (*screen_matrix)[i];
+		uInt8* colors = &v_screen_colors[i * i_screen_width];
 		for (int j = 0; j < i_screen_width; j++) {
-			int color_ind = (*pv_screen)[i][j];
-			assert(color_ind < NUM_COLORS);
-			v_color_counts[pixel_ind + color_ind] += 1;
-			pixel_ind += NUM_COLORS;
+			assert(row[j] >= 0 && row[j] < NUM_COLORS);
+			colors[j] = row[j];
 		}
 	}
-	i_frames_counter++;
+	count_screen_colors();
+	if (i_frames_counter < i_frames_num && is_estimate_stable()) {
+		cout << "Background unchanged for " << i_stable_frames_num 
+			 << " frames, stopping after " << i_frames_counter << " frames."
+			 << endl;
+		i_frames_num = i_frames_counter;
+	}
 	if (i_frames_counter == i_frames_num) {
 		extract_and_save_background();
 	}
 }
 
 /* *********************************************************************
-	Extracts the background matrix from the color-counts and exports it
-	as .txt and .png files
+	Restricts the summaries (and the early stopping) to the rows
+	[first_row, end_row) of the screen. The summaries of the pixels of
+	the other rows are left as they are
+ ******************************************************************** */
+void BackgroundDetector::set_row_range(int first_row, int end_row) {
+	i_first_pixel = first_row * i_screen_width;
+	i_end_pixel = end_row * i_screen_width;
+	if (end_row >= i_screen_height) {
+		i_end_pixel = i_padded_pixels;
+	}
+}
+
+/* *********************************************************************
+	Adds the given screen (one color byte per pixel) to the color 
+	summaries. Unlike get_new_screen, this never stops the detection or
+	extracts the background
+ ******************************************************************** */
+void BackgroundDetector::count_screen(const uInt8* screen_colors) {
+	int end_pixel = min(i_end_pixel, i_num_pixels);
+	memcpy(&v_screen_colors[i_first_pixel], &screen_colors[i_first_pixel],
+		   end_pixel - i_first_pixel);
+	count_screen_colors();
+}
+
+/* *********************************************************************
+	Adds the colors of v_screen_colors to the summaries, and counts the
+	frame
+ ******************************************************************** */
+void BackgroundDetector::count_screen_colors(void) {
+	update_summaries();
+	i_frames_counter++;
+	if (i_frames_counter % BG_COUNT_HALVING_FRAMES == 0) {
+		halve_counts();
+	}
+}
+
+/* *********************************************************************
+	Adds the colors of v_screen_colors to the summaries. With SSE2, 16 
+	pixels are compared to each slot at once, and the count of each 
+	matching slot is incremented (a match is all-ones, i.e. -1). The 
+	pixels with no match (rare, once the summaries are filled) are then 
+	added one by one
+ ******************************************************************** */
+void BackgroundDetector::update_summaries(void) {
+	int p = i_first_pixel;
+#ifdef __SSE2__
+	for (; p + 16 <= i_end_pixel; p += 16) {
+		__m128i pixels = _mm_loadu_si128((const __m128i*)&v_screen_colors[p]);
+		__m128i matched = _mm_setzero_si128();
+		for (int s = 0; s < BG_NUM_SLOTS; s++) {
+			int ind = s * i_padded_pixels + p;
+			__m128i equal = _mm_cmpeq_epi8(pixels, 
+							_mm_loadu_si128((const __m128i*)&v_slot_colors[ind]));
+			if (_mm_movemask_epi8(equal) == 0) {
+				continue;
+			}
+			matched = _mm_or_si128(matched, equal);
+			__m128i* counts = (__m128i*)&v_slot_counts[ind];
+			_mm_storeu_si128(counts, _mm_sub_epi16(_mm_loadu_si128(counts), 
+										_mm_unpacklo_epi8(equal, equal)));
+			_mm_storeu_si128(counts + 1, 
+							 _mm_sub_epi16(_mm_loadu_si128(counts + 1), 
+										   _mm_unpackhi_epi8(equal, equal)));
+		}
+		int missed = ~_mm_movemask_epi8(matched) & 0xFFFF;
+		while (missed != 0) {
+			int q = p + __builtin_ctz(missed);
+			missed &= missed - 1;
+			replace_min_slot(q, v_screen_colors[q]);
+		}
+	}
+#endif
+	for (; p < i_end_pixel; p++) {
+		bool is_matched = false;
+		for (int s = 0; s < BG_NUM_SLOTS && !is_matched; s++) {
+			int ind = s * i_padded_pixels + p;
+			if (v_slot_colors[ind] == v_screen_colors[p]) {
+				v_slot_counts[ind]++;
+				is_matched = true;
+			}
+		}
+		if (!is_matched) {
+			replace_min_slot(p, v_screen_colors[p]);
+		}
+	}
+}
+
+/* *********************************************************************
+	Replaces the slot with the lowest count of pixel p with the given
+	color (the color is not in the summary of the pixel). The new color 
+	inherits the count of the slot, plus one, so its count is never 
+	lower than its true frequency
+ ******************************************************************** */
+void BackgroundDetector::replace_min_slot(int p, uInt8 color) {
+	int min_ind = p;
+	for (int s = 1; s < BG_NUM_SLOTS; s++) {
+		int ind = s * i_padded_pixels + p;
+		if (v_slot_counts[ind] < v_slot_counts[min_ind]) {
+			min_ind = ind;
+		}
+	}
+	v_slot_colors[min_ind] = color;
+	v_slot_counts[min_ind]++;
+}
+
+/* *********************************************************************
+	Halves all the counts. A count grows by at most one per frame, so 
+	halving every BG_COUNT_HALVING_FRAMES frames keeps them in 16 bits
+ ******************************************************************** */
+void BackgroundDetector::halve_counts(void) {
+	for (unsigned int i = 0; i < v_slot_counts.size(); i++) {
+		v_slot_counts[i] >>= 1;
+	}
+}
+
+/* *********************************************************************
+	Returns true when the most frequent colors have not changed for 
+	i_stable_frames_num frames
+ ******************************************************************** */
+bool BackgroundDetector::is_estimate_stable(void) {
+	if (i_stable_frames_num <= 0) {
+		return false;
+	}
+	if (update_modes()) {
+		i_stable_counter = 0;
+	} else {
+		i_stable_counter++;
+	}
+	return (i_stable_counter >= i_stable_frames_num);
+}
+
+/* *********************************************************************
+	Recomputes the most frequent color of each summarized pixel. Returns
+	true if any of them changed. When changed_pixels is given, the 
+	pixels that changed are added to it, with their previous color
+ ******************************************************************** */
+bool BackgroundDetector::update_modes(
+								vector< pair<int, uInt8> >* changed_pixels) {
+	bool is_changed = false;
+	int end_pixel = min(i_end_pixel, i_num_pixels);
+	for (int p = i_first_pixel; p < end_pixel; p++) {
+		uInt8 mode = get_most_frequent_color_ind(p);
+		if (mode != v_curr_modes[p]) {
+			if (changed_pixels) {
+				changed_pixels->push_back(make_pair(p, v_curr_modes[p]));
+			}
+			v_curr_modes[p] = mode;
+			is_changed = true;
+		}
+	}
+	return is_changed;
+}
+
+/* *********************************************************************
+	Extracts the background matrix from the color summaries and exports 
+	it as .txt and .png files
  ******************************************************************** */
 void BackgroundDetector::extract_and_save_background() {
 	// 1 - Extract the background matrix
@@ -68,35 +246,44 @@ void BackgroundDetector::extract_and_save_background() {
 	for (int i = 0; i < i_screen_height; i++) {
 		IntVect row;
 		for (int j = 0; j < i_screen_width; j++) {
-			int most_frq_ind = get_most_frequent_color_ind(i, j);
+			int most_frq_ind = get_most_frequent_color_ind(
+												i * i_screen_width + j);
 			row.push_back(most_frq_ind);
 		}
 		pm_background->push_back(row);
 	}
 	
 	// 2- Export the background matrix;
-	export_matrix(pm_background, "background_matrix.txt");
-	p_osystem->p_export_screen->export_any_matrix(pm_background, 
-													"background_matrix.png");
+	save_background(pm_background);
 	
 	delete pm_background;
 };
 
+/* *********************************************************************
+	Exports the given background matrix as .txt and .png files
+ ******************************************************************** */
+void BackgroundDetector::save_background(IntMatrix* pm_background) {
+	export_matrix(pm_background, "background_matrix.txt");
+	p_osystem->p_export_screen->export_any_matrix(pm_background, 
+													"background_matrix.png");
+}
+
 
 /* *********************************************************************
-	given a pixel coordination (i, j), returns the color index with 
-	highest value in v_color_counts
+	given a pixel number, returns the color index with highest count in
+	its summary (the lowest index, among equal counts)
  ******************************************************************** */
-int BackgroundDetector::get_most_frequent_color_ind(int i, int j) {
-	int pixel_num = (i * i_screen_width) + j;
-	int pixel_ind = pixel_num * NUM_COLORS;
+int BackgroundDetector::get_most_frequent_color_ind(int pixel_num) {
 	int highest_ind = 0;
-	int highest_val = v_color_counts[pixel_ind];
-	for (int i = 1; i < NUM_COLORS; i++ ) {
-		int val = v_color_counts[pixel_ind + i];
-		if (val > highest_val) {
+	int highest_val = 0;
+	for (int s = 0; s < BG_NUM_SLOTS; s++) {
+		int ind = s * i_padded_pixels + pixel_num;
+		int val = v_slot_counts[ind];
+		int color_ind = v_slot_colors[ind];
+		if (val > highest_val || 
+			(val == highest_val && val > 0 && color_ind < highest_ind)) {
 			highest_val = val;
-			highest_ind = i;
+			highest_ind = color_ind;
 		}
 	}
 	return highest_ind;
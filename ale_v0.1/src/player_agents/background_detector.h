@@ -18,36 +18,74 @@
 
 #include "common_constants.h"
 #include "OSystem.hxx"
-#define NUM_COLORS 256
+#include "screen_planes.h"
+
+#define BG_NUM_SLOTS 8					// Colors kept in the summary of 
+										// each pixel
+#define BG_COUNT_HALVING_FRAMES 32768	// The counts are halved after this 
+										// many frames, so they fit 16 bits
 
 class BackgroundDetector  {
     /* *************************************************************************
         Responsible for detecting the background from the given screens
 		In the current implementation we use a simple frequency method, i.e.
-		we choose the most frequent color for each pixel as the background
+		we choose the most frequent color for each pixel as the background.
+		Instead of a full color histogram per pixel, each pixel keeps a 
+		Space-Saving summary of its BG_NUM_SLOTS most frequent colors: a 
+		color already in the summary has its count incremented, and a new 
+		color replaces the slot with the lowest count, inheriting that count
+		plus one. Any color seen in more than 1 / BG_NUM_SLOTS of the 
+		frames stays in the summary, so the most frequent color is found
+		whenever the background covers a pixel that often. 
+		The summaries are stored slot by slot (the colors of slot s of all
+		the pixels are contiguous), so that 16 pixels are compared and 
+		counted at once with SSE2. Empty slots have a count of 0, and slot
+		s starts with the placeholder color s, so that the colors of the 
+		slots of a pixel are always different.
+		When bg_detect_stable_frames is positive, the detection stops early,
+		as soon as the most frequent colors have not changed for that many
+		frames.
+		The summaries of different pixels are independent, so the detection
+		can be split between processes by rows (see set_row_range and
+		class_disc_tool)
         
         Instance variabls:
         - i_frames_num			Number of frames to use for background detection
 		- i_frames_counter		Counts the number of frames we have seen
-		- v_color_counts		In this vector, each pixel has NUM_COLORS
-								digits assigned to it, each of which counts the 
-								number of frames that had the particular color 
-								in this pixel
 		- i_screen_width		Width of the screen
 		- i_screen_height		Height of the screen
+		- i_num_pixels			Number of pixels on the screen
+		- i_padded_pixels		i_num_pixels, rounded up to a multiple of 16
+		- v_screen_colors		The colors of the current screen, one byte 
+								per pixel
+		- v_slot_colors			The colors of the slots: slot s of pixel p
+								is at s * i_padded_pixels + p
+		- v_slot_counts			The counts of the slots, in the same layout
+		- i_stable_frames_num	Stop after this many frames without a change
+								of the most frequent colors (0: never)
+		- i_stable_counter		Number of frames since the last change
+		- v_curr_modes			The most frequent color of each pixel, for
+								the early stopping
+		- i_first_pixel			First pixel of the summarized rows
+		- i_end_pixel			One past the last pixel of the summarized
+								rows (i_padded_pixels for the whole screen)
     ************************************************************************* */
 
     public:
-        BackgroundDetector(OSystem* _osystem);
+        /* *********************************************************************
+            Constructor
+         ******************************************************************** */
+        BackgroundDetector(OSystem* _osystem, ScreenPlanes* screen_planes);
         virtual ~BackgroundDetector();
 
 		/* *********************************************************************
-            Recieves a new screen, and updates the color counts
+            Recieves a new screen, and updates the color summaries
          ******************************************************************** */
-		virtual void get_new_screen(const IntMatrix* pv_screen);
+		virtual void get_new_screen(ScreenPlanes* screen_planes);
 
 		/* *********************************************************************
-            Extracts the background matrix from the color-counts and exports it
+            Extracts the background matrix from the color summaries and 
+			exports it
 			as .txt and .png files
          ******************************************************************** */
 		virtual void extract_and_save_background();
@@ -58,21 +96,92 @@ class BackgroundDetector  {
 		bool is_bg_extraction_complete() {
 			return (i_frames_counter > i_frames_num);
 		}
+
+		/* *********************************************************************
+            Restricts the summaries (and the early stopping) to the rows
+			[first_row, end_row) of the screen
+         ******************************************************************** */
+		void set_row_range(int first_row, int end_row);
+
+		/* *********************************************************************
+            Adds the given screen (one color byte per pixel) to the color 
+			summaries. Unlike get_new_screen, this never stops the detection
+			or extracts the background
+         ******************************************************************** */
+		void count_screen(const uInt8* screen_colors);
+
+		/* *********************************************************************
+            Recomputes the most frequent color of each summarized pixel. 
+			Returns true if any of them changed. When changed_pixels is 
+			given, the pixels that changed are added to it, with their 
+			previous color
+         ******************************************************************** */
+		bool update_modes(vector< pair<int, uInt8> >* changed_pixels = NULL);
+
+		/* *********************************************************************
+            Returns the most frequent color of the given pixel, as found by 
+			the last update_modes
+         ******************************************************************** */
+		uInt8 get_mode(int pixel_num) const {
+			return v_curr_modes[pixel_num];
+		}
+
+		/* *********************************************************************
+            Exports the given background matrix as .txt and .png files
+         ******************************************************************** */
+		void save_background(IntMatrix* pm_background);
 		
 	protected:
 		/* *********************************************************************
-            given a pixel coordination (i, j), returns the color index with 
-			highest value in v_color_counts
+            Adds the colors of v_screen_colors to the summaries, and counts
+			the frame
          ******************************************************************** */
-		int get_most_frequent_color_ind(int i, int j);
+		void count_screen_colors(void);
+
+		/* *********************************************************************
+            Adds the colors of v_screen_colors to the summaries
+         ******************************************************************** */
+		void update_summaries(void);
+
+		/* *********************************************************************
+            Replaces the slot with the lowest count of pixel p with the given
+			color (the color is not in the summary of the pixel)
+         ******************************************************************** */
+		void replace_min_slot(int p, uInt8 color);
+
+		/* *********************************************************************
+            Halves all the counts, so that they never overflow
+         ******************************************************************** */
+		void halve_counts(void);
+
+		/* *********************************************************************
+            given a pixel number, returns the color index with highest count
+			in its summary (the lowest index, among equal counts)
+         ******************************************************************** */
+		int get_most_frequent_color_ind(int pixel_num);
+
+		/* *********************************************************************
+            Returns true when the most frequent colors have not changed for 
+			i_stable_frames_num frames
+         ******************************************************************** */
+		bool is_estimate_stable(void);
 		
 		OSystem* p_osystem;
 		int i_frames_num;
 		int i_frames_counter; 
-		IntVect v_color_counts;
 		int i_screen_width;
 		int i_screen_height;
-		
+		int i_num_pixels;
+		int i_padded_pixels;
+		vector<uInt8> v_screen_colors;
+		vector<uInt8> v_slot_colors;
+		vector<uInt16> v_slot_counts;
+		int i_stable_frames_num;
+		int i_stable_counter;
+		vector<uInt8> v_curr_modes;
+		int i_first_pixel;
+		int i_end_pixel;
+
 };
 
 #endif
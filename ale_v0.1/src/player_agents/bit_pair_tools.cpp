@@ -0,0 +1,86 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  bit_pair_tools.cpp
+ *
+ *   A number of utility functions to generate the bit and bit-pair features
+ *   of a binary vector from its set bits only
+ **************************************************************************** */
+#include "bit_pair_tools.h"
+
+/* *****************************************************************************
+	Returns the given byte with its bits in reverse order
+ **************************************************************************** */
+static BitWord reverse_byte(int byte_val) {
+	BitWord reversed = 0;
+	for (int k = 0; k < 8; k++) {
+		if ((byte_val >> k) & 1) {
+			reversed |= (BitWord)1 << (7 - k);
+		}
+	}
+	return reversed;
+}
+
+/* *****************************************************************************
+	Packs the RAM content into bit-words, such that bit (i * 8 + 7 - k) of 
+	the result is bit k of byte i (i.e. the most significant bit first, 
+	which is the order used by RAMAgent)
+ **************************************************************************** */
+void pack_ram_bits(const IntVect* ram_content, BitWordVect& words) {
+	static BitWord reversed_bytes[256];
+	static bool table_ready = false;
+	if (!table_ready) {
+		for (int b = 0; b < 256; b++) {
+			reversed_bytes[b] = reverse_byte(b);
+		}
+		table_ready = true;
+	}
+	int num_bytes = ram_content->size();
+	int bytes_per_word = BITS_PER_WORD / 8;
+	words.assign((num_bytes + bytes_per_word - 1) / bytes_per_word, 0);
+	for (int i = 0; i < num_bytes; i++) {
+		words[i / bytes_per_word] |= 
+			reversed_bytes[(*ram_content)[i] & 0xFF] << ((i % bytes_per_word) * 8);
+	}
+}
+
+/* *****************************************************************************
+	Fills active_bits with the (sorted) indices of the set bits
+ **************************************************************************** */
+void extract_active_bits(const BitWordVect& words, IntVect& active_bits) {
+	active_bits.clear();
+	for (unsigned int w = 0; w < words.size(); w++) {
+		BitWord word = words[w];
+		while (word != 0) {
+			active_bits.push_back(w * BITS_PER_WORD + __builtin_ctzll(word));
+			word &= word - 1;	// clear the lowest set bit
+		}
+	}
+}
+
+/* *****************************************************************************
+	Appends the feature indices of the given set bits, followed by the
+	indices of all their pairs, to feature_inds. The indices are appended
+	in increasing order. The cost is O(k^2) in the number of set bits.
+ **************************************************************************** */
+void generate_bit_pair_features(const IntVect& active_bits, int num_bits, 
+								IntVect& feature_inds) {
+	int num_active = active_bits.size();
+	for (int a = 0; a < num_active; a++) {
+		feature_inds.push_back(active_bits[a]);
+	}
+	for (int a = 0; a < num_active; a++) {
+		int i = active_bits[a];
+		// index of the pair (i, j) is row_start + j
+		int row_start = bit_pair_index(i, i + 1, num_bits) - (i + 1);
+		for (int b = a + 1; b < num_active; b++) {
+			feature_inds.push_back(row_start + active_bits[b]);
+		}
+	}
+}
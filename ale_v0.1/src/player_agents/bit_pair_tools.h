@@ -0,0 +1,77 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  bit_pair_tools.h
+ *
+ *   A number of utility functions to generate the bit and bit-pair features
+ *   of a binary vector from its set bits only
+ **************************************************************************** */
+#ifndef BIT_PAIR_TOOLS_H
+#define BIT_PAIR_TOOLS_H
+
+#include "common_constants.h"
+
+typedef unsigned long long BitWord;
+typedef vector<BitWord> BitWordVect;
+#define BITS_PER_WORD 64
+
+/* *****************************************************************************
+	Packs the RAM content into bit-words, such that bit (i * 8 + 7 - k) of 
+	the result is bit k of byte i (i.e. the most significant bit first, 
+	which is the order used by RAMAgent)
+ **************************************************************************** */
+void pack_ram_bits(const IntVect* ram_content, BitWordVect& words);
+
+/* *****************************************************************************
+	Sets the given bit in the bit-words
+ **************************************************************************** */
+inline void set_bit(BitWordVect& words, int bit_index) {
+	words[bit_index / BITS_PER_WORD] |= (BitWord)1 << (bit_index % BITS_PER_WORD);
+}
+
+/* *****************************************************************************
+	Returns the number of set bits in the word. Without the popcnt 
+	instruction, __builtin_popcountll is a library call, so the bits are
+	counted in parallel instead (the sums of 2, 4 and 8 bits, then one 
+	multiply adds the 8 bytes)
+ **************************************************************************** */
+inline int count_bits(BitWord word) {
+#ifdef __POPCNT__
+	return __builtin_popcountll(word);
+#else
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* *****************************************************************************
+	Fills active_bits with the (sorted) indices of the set bits
+ **************************************************************************** */
+void extract_active_bits(const BitWordVect& words, IntVect& active_bits);
+
+/* *****************************************************************************
+	Returns the index of the pair (i, j), i < j, in a feature vector that 
+	holds the num_bits bits followed by all their pairs in the order 
+	(0,1), (0,2), ..., (0,n-1), (1,2), ...
+ **************************************************************************** */
+inline int bit_pair_index(int i, int j, int num_bits) {
+	return num_bits + i * (num_bits - 1) - (i * (i - 1)) / 2 + (j - i - 1);
+}
+
+/* *****************************************************************************
+	Appends the feature indices of the given set bits, followed by the
+	indices of all their pairs, to feature_inds. The indices are appended
+	in increasing order. The cost is O(k^2) in the number of set bits.
+ **************************************************************************** */
+void generate_bit_pair_features(const IntVect& active_bits, int num_bits, 
+								IntVect& feature_inds);
+
+#endif
@@ -23,6 +23,7 @@
 
 BlobClass::BlobClass() {
 	pv_reg_objects = new RegionObjectList;
+	pv_flipped_objects = new RegionObjectList;
 	i_num_frames_on_scr = 0;
 	i_screen_pos_x_min = -1;
 	i_screen_pos_x_max = -1;
@@ -34,6 +35,8 @@ BlobClass::BlobClass() {
 BlobClass::~BlobClass() {
 	clear_list_of_pointers(pv_reg_objects);
 	delete pv_reg_objects;
+	clear_list_of_pointers(pv_flipped_objects);
+	delete pv_flipped_objects;
 }
 
 /* *********************************************************************
@@ -47,9 +50,24 @@ void BlobClass::add_object(RegionObject*  reg_object, int frame_num,
 	new_object->i_num_frames_on = 1;
 	new_object->str_disc_text = discovery_txt;
 	pv_reg_objects->push_back(new_object);
+	add_flipped_versions(new_object);
 	update_screen_boudnaries(reg_object);
 }
  
+/* *********************************************************************
+ * Adds the horizontally, vertically, and doubly flipped versions of the
+ * given object (in that order) to pv_flipped_objects
+ ******************************************************************** */
+void BlobClass::add_flipped_versions(const RegionObject* reg_object) {
+	for (int flip_ind = 1; flip_ind <= 3; flip_ind++) {
+		RegionObject* flipped_obj = new RegionObject(*reg_object);
+		flip_shape(reg_object->pm_shape_matrix, flipped_obj->pm_shape_matrix, 
+				   (flip_ind & 1) != 0, (flip_ind & 2) != 0);
+		flipped_obj->calc_signature();
+		pv_flipped_objects->push_back(flipped_obj);
+	}
+}
+
 /* *********************************************************************
  * Given a new object that belongs to this class, updates our on-screen
  * boundaries.
@@ -78,42 +96,43 @@ void BlobClass::update_screen_boudnaries(const RegionObject* reg_object) {
  * When check_flipped_horizentally is true, we check if the flipped 
  * version of the object belongs to this class. Same deal with
  *  check_flipped_vertically, and allow_different_size
+ * Instead of flipping the object, the object is compared to the cached
+ * flipped versions of the shapes of the class (the distance is the same
+ * when both shapes are flipped). The shapes whose size and number of 
+ * pixels rule out a distance of 0 are skipped, and the shapes of the 
+ * same size need the same hash too
  ******************************************************************** */
 bool BlobClass::belongs(const RegionObject* reg_object, 
 						bool allow_different_size,
 						bool check_flipped_horizentally, 
 						bool check_flipped_vertically, 
 						float max_shape_area_dif) const {
-	RegionObject*  flipped_obj = NULL;
-	if (check_flipped_vertically || check_flipped_horizentally) {
-		flipped_obj = new RegionObject(*reg_object);
-		flip_shape(reg_object->pm_shape_matrix, flipped_obj->pm_shape_matrix, 
-					check_flipped_horizentally, check_flipped_vertically);
-	}
-	bool do_belong = false;
+	int flip_ind = (int)check_flipped_horizentally + 
+				   2 * (int)check_flipped_vertically;
 	for (unsigned int i = 0; i < pv_reg_objects->size(); i++) {
-		RegionObject* curr_object = (*pv_reg_objects)[i];
+		const RegionObject* curr_object = (*pv_reg_objects)[i];
+		if (flip_ind > 0) {
+			curr_object = (*pv_flipped_objects)[i * 3 + flip_ind - 1];
+		}
+		if (curr_object->get_min_pixel_distance(reg_object, 
+							allow_different_size, max_shape_area_dif) != 0) {
+			continue;
+		}
+		if (curr_object->i_width == reg_object->i_width &&
+			curr_object->i_height == reg_object->i_height &&
+			!curr_object->may_have_same_shape(reg_object)) {
+			continue;
+		}
 		int pixel_distance = -1;
 		float perc_distance = -1.0;
-		bool dist_valid;
-		if (flipped_obj) {
-			dist_valid = curr_object->calc_distance(flipped_obj, 
-										allow_different_size, max_shape_area_dif,
-										pixel_distance, perc_distance); 
-		} else {
-			dist_valid = curr_object->calc_distance(reg_object, 
+		bool dist_valid = curr_object->calc_distance(reg_object, 
 										allow_different_size, max_shape_area_dif,
-										pixel_distance, perc_distance); 
-		}
+										pixel_distance, perc_distance, 0); 
         if (dist_valid && pixel_distance == 0) {
-			do_belong = true;
-			break;
+			return true;
 		}
 	}
-	if (flipped_obj) {
-		delete flipped_obj;
-	}
-	return do_belong; 
+	return false; 
 }
 
 /* *********************************************************************
@@ -123,11 +142,14 @@ bool BlobClass::belongs(const RegionObject* reg_object,
 void BlobClass::increase_obj_onscreen_count(const RegionObject* reg_object) {
 	for (unsigned int i = 0; i < pv_reg_objects->size(); i++) {
 		RegionObject* curr_object = (*pv_reg_objects)[i];
+		if (!curr_object->may_have_same_shape(reg_object)) {
+			continue;
+		}
 		int pixel_distance = -1;
 		float perc_distance = -1.0;
 		bool dist_valid = curr_object->calc_distance(reg_object, 
 									false, 0.0,
-									pixel_distance, perc_distance); 
+									pixel_distance, perc_distance, 0); 
 		if (dist_valid && pixel_distance == 0) {
 			assert (curr_object->i_num_frames_on > 0);
 			curr_object->i_num_frames_on++;
@@ -149,6 +171,7 @@ void BlobClass::merge_with(const BlobClass* other_class) {
 	for (unsigned int i = 0; i < other_objects->size(); i++) {
 		RegionObject* new_object = new RegionObject(*((*other_objects)[i]));
 		pv_reg_objects->push_back(new_object);
+		add_flipped_versions(new_object);
 	}
 	i_screen_pos_x_max = max(i_screen_pos_x_max, 
 							 other_class->i_screen_pos_x_max);
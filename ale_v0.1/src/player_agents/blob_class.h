@@ -39,6 +39,10 @@ class BlobClass {
               i_screen_pos_y_max    out classes that do not really move onscreen
             - i_discovered_on_frame  The frame number on which the first shape 
                                     of this class was discovered
+            - pv_flipped_objects    The flipped versions of pv_reg_objects:
+                                    pv_flipped_objects[3 * i + f - 1] is 
+                                    object i, flipped horizontally (f = 1),
+                                    vertically (f = 2) or both (f = 3)
     ************************************************************************* */
 
     public:
@@ -114,6 +118,15 @@ class BlobClass {
 		int i_screen_pos_y_max;
 		int i_discovered_on_frame;
 
+	protected:
+		/* *********************************************************************
+		 * Adds the horizontally, vertically, and doubly flipped versions of 
+		 * the given object (in that order) to pv_flipped_objects
+		 ******************************************************************** */
+		void add_flipped_versions(const RegionObject* reg_object);
+
+		RegionObjectList* pv_flipped_objects;
+
 };
 		
 		
@@ -13,6 +13,7 @@
  **************************************************************************** */
 
 #include <sstream>
+#include <algorithm>
 #include "blob_object.h"
 #include "vector_matrix_tools.h"
 #include "shape_tools.h"
@@ -58,6 +59,9 @@ RegionObject::RegionObject() :
 	i_num_frames_on = -1;
 	str_disc_text = "";
 	i_width = i_height = -1;
+	i_num_pixels = 0;
+	i_shape_hash = 0;
+	pm_packed_shape = NULL;
 	
 }
 
@@ -82,6 +86,12 @@ RegionObject::RegionObject(const RegionObject& other_obj) :
 	i_disc_frame_num = other_obj.i_disc_frame_num;
 	i_num_frames_on = other_obj.i_num_frames_on;
 	str_disc_text = other_obj.str_disc_text;
+	i_num_pixels = other_obj.i_num_pixels;
+	i_shape_hash = other_obj.i_shape_hash;
+	pm_packed_shape = NULL;
+	if (other_obj.pm_packed_shape) {
+		pm_packed_shape = new PackedBitMatrix(*other_obj.pm_packed_shape);
+	}
 }
 
 /* *********************************************************************
@@ -98,6 +108,9 @@ RegionObject::~RegionObject() {
 	if (pm_shape_matrix) {
 		delete pm_shape_matrix;
 	}
+	if (pm_packed_shape) {
+		delete pm_packed_shape;
+	}
 }
 
 /* *********************************************************************
@@ -156,46 +169,192 @@ bool RegionObject::extract_from_region_matrix(	const IntMatrix* region_matrix,
 	i_region_number = region_num;
 	i_center_x = x_min + (int)(i_width / 2);
 	i_center_y = y_min + (int)(i_height / 2);
+	calc_signature();
 	b_is_valid = true;
 	delete pv_row_inds;
 	delete pv_col_inds;
 	return true;
 }
 				
+/* *********************************************************************
+	Same as extract_from_region_matrix, for a region given as a list
+	of runs: the object is made of runs[run_inds[0]], runs[run_inds[1]],
+	etc.
+ ******************************************************************** */
+bool RegionObject::extract_from_runs(	const PixelRunVect& runs, 
+										const IntVect& run_inds,
+										int region_num) {
+	// if we had assigned an old shape, delete it
+	if (pm_shape_matrix) {
+		delete pm_shape_matrix;
+		pm_shape_matrix = NULL;
+	}
+	if (run_inds.empty()) {
+		b_is_valid = false;
+		return false;
+	}
+	
+	// find the shape of the region
+	const PixelRun& first_run = runs[run_inds[0]];
+	int x_min = first_run.start;
+	int x_max = first_run.end - 1;
+	int y_min = first_run.y;
+	int y_max = first_run.y;
+	for (unsigned int r = 1; r < run_inds.size(); r++) {
+		const PixelRun& run = runs[run_inds[r]];
+		x_min = min(x_min, run.start);
+		x_max = max(x_max, run.end - 1);
+		y_min = min(y_min, run.y);
+		y_max = max(y_max, run.y);
+	}
+	i_width = x_max - x_min + 1;
+	i_height = y_max - y_min + 1;
+	
+	// Full the shape matrix with the runs
+	pm_shape_matrix = new IntMatrix(i_height, IntVect(i_width, 0));
+	for (unsigned int r = 0; r < run_inds.size(); r++) {
+		const PixelRun& run = runs[run_inds[r]];
+		IntVect& row = (*pm_shape_matrix)[run.y - y_min];
+		for (int x = run.start; x < run.end; x++) {
+			row[x - x_min] = 1;
+		}
+	}
+	
+	// Set the rest of variables
+	i_region_number = region_num;
+	i_center_x = x_min + (int)(i_width / 2);
+	i_center_y = y_min + (int)(i_height / 2);
+	calc_signature();
+	b_is_valid = true;
+	return true;
+}
+				
 /* *********************************************************************
 	Calculates the pixel and percentage distance between the two 
 	objects. Returns true if the distance is computable (i.e. the 
 	objects have compatible shapes).
+	When max_pixel_distance is not negative, the pixel distances above
+	it are not calculated exactly (some value above max_pixel_distance
+	is returned instead)
  ******************************************************************** */
 bool RegionObject::calc_distance(	const RegionObject* other_object, 
 							bool allow_different_size, float max_shape_area_dif,
-							int& pixel_distance, float& perc_distance) {
-	bool success = calc_shape_distance(	pm_shape_matrix, 
-									other_object->pm_shape_matrix, 
+							int& pixel_distance, float& perc_distance,
+							int max_pixel_distance) const {
+	bool success = calc_packed_shape_distance(pm_packed_shape, 
+									other_object->pm_packed_shape, 
 									allow_different_size, max_shape_area_dif,
-									pixel_distance, perc_distance);
+									pixel_distance, perc_distance, 
+									max_pixel_distance);
 	return success;
 }
 
 
+/* *********************************************************************
+	Returns a lower bound of the pixel distance to the given object (as 
+	calculated by calc_distance), from the sizes and the numbers of 
+	pixels of the two shapes only. Returns -1 if the distance is not 
+	computable (the same conditions as calc_shape_distance).
+	Each pixel of the smaller shape is compared to one pixel of a window
+	of the bigger shape, so the distance is at least the difference 
+	between the pixels of the smaller shape and the pixels the window 
+	can have (between the pixels of the bigger shape, minus those outside
+	the window, and all of them)
+ ******************************************************************** */
+int RegionObject::get_min_pixel_distance(	const RegionObject* other_object, 
+											bool allow_different_size, 
+											float max_shape_area_dif) const {
+	if (i_width == other_object->i_width && 
+		i_height == other_object->i_height) {
+		return abs(i_num_pixels - other_object->i_num_pixels);
+	}
+	if (!allow_different_size) {
+		return -1;
+	}
+	int area = i_width * i_height;
+	int other_area = other_object->i_width * other_object->i_height;
+	if  (	( (float)area > (max_shape_area_dif * other_area) ) || 
+			( (float)other_area > (max_shape_area_dif * area) )	) {
+		return -1; // size difference is too big
+	}
+	const RegionObject *bigger_obj, *smaller_obj;
+	if (i_width <= other_object->i_width && 
+		i_height <= other_object->i_height) {
+		bigger_obj = other_object;
+		smaller_obj = this;
+	} else if (	i_width >= other_object->i_width && 
+				i_height >= other_object->i_height) {
+		bigger_obj = this;
+		smaller_obj = other_object;
+	} else {
+		return -1; // incompatible shapes
+	}
+	int outside_window = max(bigger_obj->i_width * bigger_obj->i_height - 
+							 smaller_obj->i_width * smaller_obj->i_height, 0);
+	int min_window_pixels = max(bigger_obj->i_num_pixels - outside_window, 0);
+	int max_window_pixels = bigger_obj->i_num_pixels;
+	return max(0, max(smaller_obj->i_num_pixels - max_window_pixels,
+					  min_window_pixels - smaller_obj->i_num_pixels));
+}
+
+/* *********************************************************************
+	Recalculates i_num_pixels, i_shape_hash and pm_packed_shape from the
+	shape matrix. Should be called after the shape matrix is changed
+ ******************************************************************** */
+void RegionObject::calc_signature(void) {
+	i_num_pixels = 0;
+	i_shape_hash = 2166136261u;	// FNV-1a, over the entries
+	for (int i = 0; i < i_height; i++) {
+		for (int j = 0; j < i_width; j++) {
+			int val = (*pm_shape_matrix)[i][j];
+			i_num_pixels += (val != 0);
+			i_shape_hash = (i_shape_hash ^ (uInt32)val) * 16777619u;
+		}
+	}
+	i_shape_hash = (i_shape_hash ^ (uInt32)i_width) * 16777619u;
+	if (pm_packed_shape) {
+		delete pm_packed_shape;
+	}
+	pm_packed_shape = new PackedBitMatrix(pm_shape_matrix);
+}
+
 /* *********************************************************************
 	Returns the Region-Object closest to this object in the given list of 
 	objects.
 	We do this by collecting a set of 'similar' objects that apear 
 	'close' to the given object in the previous frame, and then return
 	the one that is most similar.
+	When obj_grid is given, only the objects in the cells around this 
+	object are compared to it (the objects farther away are too far to
+	pass the velocity test). The candidates are visited in list order, so
+	that the ties are broken as in a scan of the whole list. The objects 
+	whose numbers of pixels differ too much are skipped before their 
+	shapes are compared
   ******************************************************************** */
 RegionObject* RegionObject::get_closest_obj_in_list(
 											const RegionObjectList* pv_obj_list,
 											int list_length,
 											float max_shape_area_dif,
 											float max_perc_difference,
-											int max_obj_velocity) {
+											int max_obj_velocity,
+											const SpatialGrid* obj_grid) {
 	RegionObject* closest_prev_obj = NULL;	// closest object found so far
 	int closest_pixel_distance	= -1;		// Their pixel differecne 
 	int closest_sq_distance	= -1; // The square of their actual distance
 	
-	for (int i = 0; i < list_length; i++) {
+	IntVect candidates;
+	if (obj_grid != NULL) {
+		obj_grid->get_nearby_points(i_center_x, i_center_y, candidates);
+	} else {
+		for (int i = 0; i < list_length; i++) {
+			candidates.push_back(i);
+		}
+	}
+	for (unsigned int c = 0; c < candidates.size(); c++) {
+		int i = candidates[c];
+		if (i >= list_length) {
+			continue;
+		}
 		RegionObject* prev_obj = (*pv_obj_list)[i];
 		if (prev_obj == NULL || prev_obj->b_is_valid == false) {
 			continue; // invalid object
@@ -207,12 +366,30 @@ RegionObject* RegionObject::get_closest_obj_in_list(
 		
 		if (horizental_dist < max_obj_velocity && 
 			vertical_dist < max_obj_velocity) {
+			// the largest pixel distance below max_perc_difference
+			int num_pixels = i_width * i_height + 
+							 prev_obj->i_width * prev_obj->i_height;
+			int max_pixel_distance = (int)(max_perc_difference * num_pixels);
+			while (max_pixel_distance >= 0 && float(max_pixel_distance) / 
+						float(num_pixels) >= max_perc_difference) {
+				max_pixel_distance--;
+			}
+			while (float(max_pixel_distance + 1) / float(num_pixels) < 
+												max_perc_difference) {
+				max_pixel_distance++;
+			}
+			int min_distance = get_min_pixel_distance(prev_obj, true, 
+													  max_shape_area_dif);
+			if (min_distance < 0 || min_distance > max_pixel_distance) {
+				continue; // the shapes cannot be similar enough
+			}
 			int pixel_distance = -1;
 			float perc_distance = -1.0;
 			
 			bool distance_valid = calc_distance(prev_obj, true, 
 												max_shape_area_dif, 
-												pixel_distance, perc_distance);
+												pixel_distance, perc_distance,
+												max_pixel_distance);
 			if (!distance_valid) { 
 				continue;
 			}
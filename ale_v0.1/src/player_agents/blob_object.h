@@ -17,6 +17,8 @@
 
 #include "common_constants.h"
 #include "export_screen.h"
+#include "spatial_grid.h"
+#include "packed_bit_matrix.h"
 
 class BlobObject {
     /* *************************************************************************
@@ -46,6 +48,17 @@ class BlobObject {
         
 };
 
+/* *************************************************************************
+	A run of pixels of one color, on one row of the screen
+ ************************************************************************* */
+struct PixelRun {
+	int y;
+	int start;		// First column of the run
+	int end;		// One past the last column of the run
+	int color;
+};
+typedef vector<PixelRun> PixelRunVect;
+
 class RegionObject : public BlobObject {
     /* *************************************************************************
         Represents an object detected in the region matrix.
@@ -69,6 +82,11 @@ class RegionObject : public BlobObject {
             - str_disc_text         A text string, containing the reason for
 									assignment of this object to the class
 									it was assigned to. 
+			- i_num_pixels			Number of pixels (ones) in the shape
+			- i_shape_hash			A hash of the shape matrix: objects with
+									different hashes have different shapes
+			- pm_packed_shape		The shape matrix, packed in bit rows (the
+									distances are calculated on this one)
     ************************************************************************* */
 
     public:
@@ -91,15 +109,56 @@ class RegionObject : public BlobObject {
          ******************************************************************** */
 		bool extract_from_region_matrix(const IntMatrix* region_matrix, 
 										int region_num);
+
+		/* *********************************************************************
+			Same as extract_from_region_matrix, for a region given as a list
+			of runs: the object is made of runs[run_inds[0]], 
+			runs[run_inds[1]], etc.
+         ******************************************************************** */
+		bool extract_from_runs(const PixelRunVect& runs, const IntVect& run_inds,
+							   int region_num);
 		
         /* *********************************************************************
 			Calculates the pixel and percentage distance between the two 
 			objects. Returns true if the distance is computable (i.e. the 
 			objects have compatible shapes).
+			When max_pixel_distance is not negative, the pixel distances 
+			above it are not calculated exactly (some value above 
+			max_pixel_distance is returned instead)
          ******************************************************************** */
 		bool calc_distance(	const RegionObject* other_object, 
 							bool allow_different_size, float max_shape_area_dif,
-							int& pixel_distance, float& perc_distance);
+							int& pixel_distance, float& perc_distance,
+							int max_pixel_distance = -1) const;
+							
+		/* *********************************************************************
+			Returns a lower bound of the pixel distance to the given object 
+			(as calculated by calc_distance), from the sizes and the numbers
+			of pixels of the two shapes only. Returns -1 if the distance is
+			not computable
+         ******************************************************************** */
+		int get_min_pixel_distance(	const RegionObject* other_object, 
+									bool allow_different_size, 
+									float max_shape_area_dif) const;
+
+		/* *********************************************************************
+			Returns true if the shape of the given object can be the same as
+			this shape, i.e. they have the same size, number of pixels and
+			hash
+         ******************************************************************** */
+		bool may_have_same_shape(const RegionObject* other_object) const {
+			return (i_width == other_object->i_width &&
+					i_height == other_object->i_height &&
+					i_num_pixels == other_object->i_num_pixels &&
+					i_shape_hash == other_object->i_shape_hash);
+		}
+
+		/* *********************************************************************
+			Recalculates i_num_pixels, i_shape_hash and pm_packed_shape from 
+			the shape matrix. Should be called after the shape matrix is 
+			changed
+         ******************************************************************** */
+		void calc_signature(void);
 							
 		/* *********************************************************************
 			Returns the Region-Object closest to this object in the given list of 
@@ -107,13 +166,17 @@ class RegionObject : public BlobObject {
 			We do this by collecting a set of 'similar' objects that apear 
 			'close' to the given object in the previous frame, and then return
 			the one that is most similar.
+			When obj_grid is given, it should hold the (center of) the valid
+			objects of the list, and only the objects in the cells around
+			this object are compared to it
 		  ******************************************************************** */
 		RegionObject* get_closest_obj_in_list(
 											const RegionObjectList* pv_obj_list,
 											int list_length,
 											float max_shape_area_dif,
 											float max_perc_difference,
-											int max_obj_velocity);
+											int max_obj_velocity,
+											const SpatialGrid* obj_grid = NULL);
 		
 		/* *********************************************************************
 			Save the shape_matrix as a PNG file
@@ -145,6 +208,9 @@ class RegionObject : public BlobObject {
 		int i_num_frames_on;
 		string str_disc_text;
 		int i_width, i_height;
+		int i_num_pixels;
+		uInt32 i_shape_hash;
+		PackedBitMatrix* pm_packed_shape;
 		
 }; 
 
@@ -34,6 +34,7 @@ ClassAgent::ClassAgent(GameSettings* _game_settings, OSystem* _osystem) :
 	i_max_num_detected_instaces = settings.getInt("max_num_detected_instaces", 
 																		true); 
 	i_max_obj_vel_half = i_max_obj_velocity / 2;
+	i_max_pair_distance = settings.getInt("max_pair_distance", true);
     pv_sorted_shape_list = ClassShape::import_shape_list("class_shapes.txt", 
                                                             i_num_classes);
 
@@ -55,13 +56,14 @@ ClassAgent::ClassAgent(GameSettings* _game_settings, OSystem* _osystem) :
 	cout << "Full Feature-Vector Length: " << i_full_feature_vec_length << endl;
 	
 	p_sarsa_lambda_solver = RLSarsaLambda::generate_rl_sarsa_lambda_instance(
-						p_osystem, i_full_feature_vec_length, i_num_actions);
+						p_osystem, i_full_feature_vec_length, i_num_actions,
+						i_base_length);
 	
     // Initilize the feaure-map
     pv_curr_feature_map  = new FeatureMap();
 	pv_num_nonzero_in_f = new IntVect();
     for (int i = 0; i < i_num_actions; i++) {
-        IntArr feature_vec = IntArr(-1, i_full_feature_vec_length);
+        IntArr feature_vec = IntArr(-1, i_base_length);
         pv_curr_feature_map->push_back(feature_vec);
 		pv_num_nonzero_in_f->push_back(0);
     }
@@ -69,6 +71,8 @@ ClassAgent::ClassAgent(GameSettings* _game_settings, OSystem* _osystem) :
     // Load the Background matrix
     pm_background_marix = new IntMatrix;
     import_matrix(pm_background_marix, "background_matrix.txt");
+    p_screen_planes->set_background(pm_background_marix);
+    p_screen_planes->use_parts(FORGROUND_PLANE);
     
     // Initilize  the ClassInstace maps
     pv_curr_cls_inst_map = new ClassInstancesMap;
@@ -81,13 +85,9 @@ ClassAgent::ClassAgent(GameSettings* _game_settings, OSystem* _osystem) :
     }
     
     // Initilize the forground matrix
-    for (int i = 0; i < i_screen_height; i++) {
-        vector<int> row;
-        for (int j = 0; j < i_screen_width; j++) {
-            row.push_back(0);
-        }
-        m_forground_matrix.push_back(row);
-    }
+    pm_forground_matrix = new PackedBitMatrix(i_screen_height, i_screen_width);
+    p_prev_instances_grid = new SpatialGrid(i_screen_height, i_screen_width,
+                                            i_max_obj_velocity);
     
     // Initilize the scale factors
     f_abs_pos_scale_factor_x = (float)i_num_rectangles / (float)i_screen_width;
@@ -101,7 +101,10 @@ ClassAgent::ClassAgent(GameSettings* _game_settings, OSystem* _osystem) :
     // Initlize the temporary vectors used for tile-coding
     pv_tmp_abs_ind = new IntArr(-1, i_num_tilings);
     pv_tmp_rel_ind = new IntArr(-1, i_num_tilings); 
-	
+	v_abs_tiles_cache.assign(i_screen_height * i_screen_width * i_num_tilings,
+							 -1);
+	v_rel_tiles_cache.assign((2 * i_screen_height + 1) * 
+							 (2 * i_screen_width + 1) * i_num_tilings, -1);
 }
 
     
@@ -111,6 +114,8 @@ ClassAgent::~ClassAgent() {
     }
     delete pv_sorted_shape_list;
     delete pm_background_marix;
+    delete pm_forground_matrix;
+    delete p_prev_instances_grid;
     delete pv_curr_cls_inst_map;
     delete pv_prev_cls_inst_map;
     delete pv_curr_feature_map;
@@ -124,12 +129,12 @@ ClassAgent::~ClassAgent() {
 	Calculates the size of the full feature-vector
  ******************************************************************** */
 void ClassAgent::calc_feature_vec_size(void) {
-	i_full_feature_vec_length = 0;
+	i_base_length = 0;
     if (b_inc_abs_positions) { 
-        i_full_feature_vec_length += (	i_num_classes * 
-										(i_mem_size_2d + i_num_actions));
+        i_base_length += (i_num_classes * (i_mem_size_2d + 1));
     }
-	i_full_feature_vec_length += (i_num_class_pairs * i_mem_size_2d * 4);
+	i_base_length += (i_num_class_pairs * i_mem_size_2d * 4);
+	i_full_feature_vec_length = i_base_length * i_num_actions;
 }
         
 /* *********************************************************************
@@ -222,85 +227,121 @@ void ClassAgent::on_end_of_game(void) {
 	depending on whether the objects are moving toward each other in x or y
 	axis or not.
     if include_abs_positions is false, we will ignore the first part
+	The features do not depend on the action: they are generated once, for 
+	action 0, and copied to the other actions with an offset of 
+	a * i_base_length. The tiles of each position are computed once and 
+	cached. Pairs further apart than max_pair_distance are left out.
  ******************************************************************** */
 void ClassAgent::generate_feature_vec(void) {
-    for (int a = 0; a < i_num_actions; a++) {
-        int start_ind = 0;
-        (*pv_num_nonzero_in_f)[a] = 0;
-        if (b_inc_abs_positions) {
-            // Generate the absolute position part of the vector
-            for (int m = 0; m < i_num_classes; m++) {
-				int num_instances_in_class = (*pv_curr_cls_inst_map)[m].size();
-				if (num_instances_in_class == 0) {
-					// No intances of this class found. The first i_num_actions
-					// bits of the feature subvector are reserved to indicate 
-					// this
-					int one_ind = a;
-					one_ind += start_ind;
-					add_one_index_to_feature_map(one_ind, a);
-				}
-				start_ind += i_num_actions;
-                for(int obj_cntr = 0; 
-                    obj_cntr < num_instances_in_class; obj_cntr++) {
-                    BlobObject& obj = (*pv_curr_cls_inst_map)[m][obj_cntr];
-                    float scaled_x, scaled_y;
-                    get_scaled_position(obj, scaled_x, scaled_y);
-                    pf_tmp_float_arr[0] = scaled_x;
-                    pf_tmp_float_arr[1] = scaled_y;
-                    GetTiles(pv_tmp_abs_ind, i_num_tilings, i_mem_size_2d,
-                            pf_tmp_float_arr, 2, a); 
-                    (*pv_tmp_abs_ind) += start_ind;
-					append_to_feature_vec(pv_tmp_abs_ind, i_num_tilings, a);
-                }
-				start_ind += i_mem_size_2d;
-            }
-        }
-		// Generate the relative position/velocity part of the vector
- 		for (int m_a = 0; m_a < i_num_classes; m_a++ ) {
-			int num_instances_in_a = (*pv_curr_cls_inst_map)[m_a].size();
-			if (num_instances_in_a > i_max_num_detected_instaces) {
-				num_instances_in_a = i_max_num_detected_instaces;
+	int start_ind = 0;
+	(*pv_num_nonzero_in_f)[0] = 0;
+	if (b_inc_abs_positions) {
+		// Generate the absolute position part of the vector
+		for (int m = 0; m < i_num_classes; m++) {
+			int num_instances_in_class = (*pv_curr_cls_inst_map)[m].size();
+			if (num_instances_in_class == 0) {
+				// No intances of this class found. The first bit of the 
+				// feature subvector is reserved to indicate this
+				add_one_index_to_feature_map(start_ind, 0);
 			}
-			for (int m_b = m_a + 1; m_b < i_num_classes; m_b++) {
-				int num_instances_in_b = (*pv_curr_cls_inst_map)[m_b].size();
-				if (num_instances_in_b > i_max_num_detected_instaces) {
-					num_instances_in_b = i_max_num_detected_instaces;
+			start_ind += 1;
+			for(int obj_cntr = 0; 
+				obj_cntr < num_instances_in_class; obj_cntr++) {
+				BlobObject& obj = (*pv_curr_cls_inst_map)[m][obj_cntr];
+				float scaled_x, scaled_y;
+				get_scaled_position(obj, scaled_x, scaled_y);
+				int cell = obj.i_center_y * i_screen_width + obj.i_center_x;
+				const int* tiles = get_cached_tiles(v_abs_tiles_cache, cell, 
+													scaled_x, scaled_y);
+				for (int t = 0; t < i_num_tilings; t++) {
+					add_one_index_to_feature_map(tiles[t] + start_ind, 0);
 				}
-				for(int obj_cnt_a = 0; 
-					obj_cnt_a < num_instances_in_a; obj_cnt_a++) {
-					BlobObject& obj_a = (*pv_curr_cls_inst_map)[m_a][obj_cnt_a];
-					for(int obj_cnt_b = 0; 
-						obj_cnt_b < num_instances_in_b; obj_cnt_b++) {
-						BlobObject& obj_b = (*pv_curr_cls_inst_map)[m_b]
-																	[obj_cnt_b];
-						float x_rel_scaled, y_rel_scaled;
-						get_scaled_relative_position(obj_a, obj_b, 
-													x_rel_scaled, y_rel_scaled);
-						bool is_approaching_x, is_approaching_y;
-						get_binary_relative_velocity(obj_a, obj_b, 
-											is_approaching_x, is_approaching_y);
-						int vel_offset = 0;
-						if (is_approaching_x) {
-							vel_offset += 1;
-						} 
-						if (is_approaching_y) {
-							vel_offset += 2;
-						}
-						assert(vel_offset >= 0 && vel_offset <= 3);
-						vel_offset = vel_offset * i_mem_size_2d;
-						pf_tmp_float_arr[0] = x_rel_scaled;
-						pf_tmp_float_arr[1] = y_rel_scaled;
-						GetTiles(pv_tmp_rel_ind, i_num_tilings, i_mem_size_2d,
-								pf_tmp_float_arr, 2, a); 
-						(*pv_tmp_rel_ind) += (start_ind + vel_offset);
-						append_to_feature_vec(pv_tmp_rel_ind, i_num_tilings, a);
+			}
+			start_ind += i_mem_size_2d;
+		}
+	}
+	// Generate the relative position/velocity part of the vector
+	for (int m_a = 0; m_a < i_num_classes; m_a++ ) {
+		int num_instances_in_a = (*pv_curr_cls_inst_map)[m_a].size();
+		if (num_instances_in_a > i_max_num_detected_instaces) {
+			num_instances_in_a = i_max_num_detected_instaces;
+		}
+		for (int m_b = m_a + 1; m_b < i_num_classes; m_b++) {
+			int num_instances_in_b = (*pv_curr_cls_inst_map)[m_b].size();
+			if (num_instances_in_b > i_max_num_detected_instaces) {
+				num_instances_in_b = i_max_num_detected_instaces;
+			}
+			for(int obj_cnt_a = 0; 
+				obj_cnt_a < num_instances_in_a; obj_cnt_a++) {
+				BlobObject& obj_a = (*pv_curr_cls_inst_map)[m_a][obj_cnt_a];
+				for(int obj_cnt_b = 0; 
+					obj_cnt_b < num_instances_in_b; obj_cnt_b++) {
+					BlobObject& obj_b = (*pv_curr_cls_inst_map)[m_b]
+																[obj_cnt_b];
+					if (i_max_pair_distance > 0 && 
+						obj_a.calc_distance_max_xy(&obj_b) > 
+													i_max_pair_distance) {
+						continue;
+					}
+					float x_rel_scaled, y_rel_scaled;
+					get_scaled_relative_position(obj_a, obj_b, 
+												x_rel_scaled, y_rel_scaled);
+					bool is_approaching_x, is_approaching_y;
+					get_binary_relative_velocity(obj_a, obj_b, 
+										is_approaching_x, is_approaching_y);
+					int vel_offset = 0;
+					if (is_approaching_x) {
+						vel_offset += 1;
+					} 
+					if (is_approaching_y) {
+						vel_offset += 2;
+					}
+					assert(vel_offset >= 0 && vel_offset <= 3);
+					vel_offset = vel_offset * i_mem_size_2d;
+					int cell = (obj_a.i_center_y - obj_b.i_center_y + 
+								i_screen_height) * (2 * i_screen_width + 1) + 
+								obj_a.i_center_x - obj_b.i_center_x + 
+								i_screen_width;
+					const int* tiles = get_cached_tiles(v_rel_tiles_cache, 
+									cell, x_rel_scaled, y_rel_scaled);
+					for (int t = 0; t < i_num_tilings; t++) {
+						add_one_index_to_feature_map(
+									tiles[t] + start_ind + vel_offset, 0);
 					}
 				}
-				start_ind += (4 * i_mem_size_2d);
-			 }
-		 }
-		assert (start_ind == i_full_feature_vec_length);
-    }
+			}
+			start_ind += (4 * i_mem_size_2d);
+		}
+	}
+	assert (start_ind == i_base_length);
+	// Copy the base features to the other actions
+	int num_base_features = (*pv_num_nonzero_in_f)[0];
+	IntArr& base_features = (*pv_curr_feature_map)[0];
+	for (int a = 1; a < i_num_actions; a++) {
+		IntArr& action_features = (*pv_curr_feature_map)[a];
+		int offset = a * i_base_length;
+		for (int f = 0; f < num_base_features; f++) {
+			action_features[f] = base_features[f] + offset;
+		}
+		(*pv_num_nonzero_in_f)[a] = num_base_features;
+	}
+}
+
+/* *********************************************************************
+	Returns the i_num_tilings tiles of the given scaled position, from 
+	the given cell of the tiles cache. The tiles are computed the first 
+	time the cell is used (the tiles are never negative)
+ ******************************************************************** */
+const int* ClassAgent::get_cached_tiles(IntVect& tiles_cache, int cell, 
+										float x_scaled, float y_scaled) {
+	assert(cell >= 0 && (cell + 1) * i_num_tilings <= (int)tiles_cache.size());
+	int* tiles = &tiles_cache[cell * i_num_tilings];
+	if (tiles[0] == -1) {
+		pf_tmp_float_arr[0] = x_scaled;
+		pf_tmp_float_arr[1] = y_scaled;
+		GetTiles(tiles, i_num_tilings, i_mem_size_2d, pf_tmp_float_arr, 2, 0);
+	}
+	return tiles;
 }
 
 /* *********************************************************************
@@ -311,54 +352,48 @@ void ClassAgent::generate_feature_vec(void) {
 void ClassAgent::get_class_instances_on_screen() { 
     swap_curr_and_prev_class_instances(); // prev_class_inst = curr_class_inst
     extract_forground();
-    int num_forg_pix = v_forground_x_ind.size();    
     for (   int shape_counter = 0; shape_counter < pv_sorted_shape_list->size(); 
             shape_counter++) {
         ClassShape* curr_shape = (*pv_sorted_shape_list)[shape_counter];
-        IntMatrix* shape_matrix = curr_shape->pm_shape;
-            
-        int row_range_start = 0;
-        int row_range_end   = curr_shape->i_height;
-        int col_range_start = 0 - curr_shape->i_first_one_ind;
-        int col_range_end   = curr_shape->i_width - curr_shape->i_first_one_ind;
+        PackedBitMatrix* packed_shape = curr_shape->pm_packed_shape;
         int half_height = curr_shape->i_height / 2;
         int half_width  = curr_shape->i_width / 2;
-        for (int ind = 0; ind < num_forg_pix; ind++) {
-            int y = v_forground_y_ind[ind];
-            int x = v_forground_x_ind[ind];
-            if (y + row_range_start < 0             || 
-                y + row_range_end   > i_screen_height || 
-                x + col_range_start < 0             || 
-                x + col_range_end   > i_screen_width) {
-                continue;
+        int max_x = i_screen_width - curr_shape->i_width;  // top-left corner
+        int max_y = i_screen_height - curr_shape->i_height;
+        // Check 64 top-left corners at a time, in the order of the rows, 
+        // then the columns (which is the order of the forground pixels
+        // under the first 1 of the shape). The first row of the shape has a 
+        // 1, so it can only be on a row with forground pixels
+        for (unsigned int r = 0; r < v_forground_rows.size(); r++) {
+            int y = v_forground_rows[r];
+            if (y > max_y) {
+                break;
             }
-            int shape_matches = 1;
-            for (int row_ind = 0; row_ind < curr_shape->i_height; row_ind++) {
-                for (int col_ind = 0; col_ind < curr_shape->i_width; col_ind++) {
-                    if (m_forground_matrix[y + row_ind + row_range_start]
-                                          [x + col_ind + col_range_start] !=
-                        (*shape_matrix)[row_ind][col_ind] ) {
-                        shape_matches = 0;
+            for (int x0 = 0; x0 <= max_x; x0 += BITS_PER_WORD) {
+                BitWord positions = pm_forground_matrix->match_positions(
+                                            *packed_shape, y, x0, 
+                                            curr_shape->i_first_one_ind);
+                while (positions != 0) {
+                    // we have found an instance of this class
+                    int offset = __builtin_ctzll(positions);
+                    int x = x0 + offset;
+                    BlobObject new_obj(x + half_width, y + half_height);
+                    new_obj.i_instance_of_class = 
+                                            curr_shape->i_instance_of_class;
+                    (*pv_curr_cls_inst_map)[curr_shape->i_instance_of_class].push_back(new_obj);
+                    // make sure we don't match this to a smaller class
+                    pm_forground_matrix->clear_rect(y, x, 
+                                                    curr_shape->i_height, 
+                                                    curr_shape->i_width);
+                    // clearing may have changed the positions to the right
+                    // (either way)
+                    if (offset == BITS_PER_WORD - 1) {
                         break;
                     }
-                }
-                if (!shape_matches) {
-                    break;
-                }
-            }
-            if (shape_matches) {
-                // we have found an instance of this class
-                int center_x = x + col_range_start + half_width;
-                int center_y = y + row_range_start + half_height;
-                BlobObject new_obj(center_x, center_y);
-                new_obj.i_instance_of_class = curr_shape->i_instance_of_class;
-                (*pv_curr_cls_inst_map)[curr_shape->i_instance_of_class].push_back(new_obj);
-                // make sure we don't match this to a smaller class
-                for (int row_ind = 0; row_ind < curr_shape->i_height; row_ind++) {
-                    for (int col_ind = 0; col_ind < curr_shape->i_width; col_ind++){
-                        m_forground_matrix[y + row_ind + row_range_start]
-                                          [x + col_ind + col_range_start] = 0;
-                    }
+                    positions = pm_forground_matrix->match_positions(
+                                            *packed_shape, y, x0, 
+                                            curr_shape->i_first_one_ind);
+                    positions &= ~(((BitWord)2 << offset) - 1);
                 }
             }
         }
@@ -372,21 +407,34 @@ void ClassAgent::get_class_instances_on_screen() {
     screen and finding the closest object. The displacement will then
     indicate the object velocity
 	
+	The previous instances of each class are put in a grid of 
+	i_max_obj_velocity cells, so that only the ones in the 3x3 cells
+	around the object are looked at (visited in list order, as before)
+	
 	NOTE: We should be looking at object similarities here too.
   ******************************************************************** */
 void ClassAgent::calc_object_velocities(void) {
     for (int class_cntr = 0; class_cntr < i_num_classes; class_cntr++) {
+        vector<BlobObject>& prev_instances = (*pv_prev_cls_inst_map)[class_cntr];
+        if (prev_instances.empty()) {
+            continue;
+        }
+        p_prev_instances_grid->clear();
+        for (unsigned int i = 0; i < prev_instances.size(); i++) {
+            p_prev_instances_grid->add_point(prev_instances[i].i_center_x,
+                                             prev_instances[i].i_center_y, i);
+        }
         for(int obj_cntr = 0; 
             obj_cntr < (*pv_curr_cls_inst_map)[class_cntr].size();
             obj_cntr++) {
             BlobObject& curr_obj = (*pv_curr_cls_inst_map)[class_cntr][obj_cntr];
             // Now, find the closest object to curr-obj in the previous frame
             int closest_distance_sq = 999;
-            for (   int prev_obj_cntr = 0; 
-                    prev_obj_cntr < (*pv_prev_cls_inst_map)[class_cntr].size();
-                    prev_obj_cntr++ ) {
-                BlobObject prev_obj = (*pv_prev_cls_inst_map)[class_cntr]
-                                                                [prev_obj_cntr];
+            p_prev_instances_grid->get_nearby_points(curr_obj.i_center_x, 
+                                                     curr_obj.i_center_y,
+                                                     v_nearby_instances);
+            for (unsigned int n = 0; n < v_nearby_instances.size(); n++) {
+                BlobObject& prev_obj = prev_instances[v_nearby_instances[n]];
                 int dist = curr_obj.calc_distance_max_xy(&prev_obj);
                 assert (dist >= 0);
                 if (dist <= i_max_obj_velocity &&
@@ -417,23 +465,29 @@ void ClassAgent::swap_curr_and_prev_class_instances() {
 }   
 
 /* *********************************************************************
-    Extracts the foreground by subtracting the background matrix from
-    the screen matrix, and fills the m_forground_matrix, 
-    v_forground_x_ind, and v_forground_y_ind vectors
+    Copies the foreground bitmap of the shared screen planes (the 
+    screen matrix minus the background matrix), and fills the pm_forground_matrix, 
+    v_forground_x_ind, v_forground_y_ind and v_forground_rows 
+    vectors
   ******************************************************************** */
 void ClassAgent::extract_forground() {
     v_forground_x_ind.clear();
     v_forground_y_ind.clear();
+    v_forground_rows.clear();
+    // our copy is modified, when the detected instances are cleared
+    *pm_forground_matrix = *p_screen_planes->get_forground();
     for (int i = 0; i < i_screen_height; i++) {
-        for(int j = 0; j < i_screen_width; j++) {
-            if ((*pm_curr_screen_matrix)[i][j] != (*pm_background_marix)[i][j]){
+        for(int x0 = 0; x0 < i_screen_width; x0 += BITS_PER_WORD) {
+            BitWord fg_bits = pm_forground_matrix->get_bits(i, x0);
+            while (fg_bits != 0) {
                 v_forground_y_ind.push_back(i);
-                v_forground_x_ind.push_back(j);
-                m_forground_matrix[i][j] = 1;
-            } else {
-                m_forground_matrix[i][j] = 0;
+                v_forground_x_ind.push_back(x0 + __builtin_ctzll(fg_bits));
+                fg_bits &= fg_bits - 1;
             }
         }
+        if (!v_forground_y_ind.empty() && v_forground_y_ind.back() == i) {
+            v_forground_rows.push_back(i);
+        }
     }
 }               
 
@@ -23,6 +23,7 @@
 #include "blob_object.h"
 #include "rl_sarsa_lambda.h"
 #include "class_shape.h"
+#include "packed_bit_matrix.h"
 
 typedef vector< vector<BlobObject> > ClassInstancesMap;   
 
@@ -51,6 +52,9 @@ class ClassAgent : public PlayerAgent {
                                 vector. Note that the feature-map that we 
                                 generate only holds the one-indecies of this 
                                 vector
+        - i_base_length         Length of the feature-vector of one action.
+                                All actions share the same base features:
+                                feature f of action a is a * i_base_length + f
         - pm_background_marix   Matrix contaiing the background color inds
         - i_num_classes         Number of blob classes
         - i_num_class_pairs     How many class pairs (c1, c2) there is
@@ -62,10 +66,11 @@ class ClassAgent : public PlayerAgent {
         - pv_prev_cls_inst_map  pv_prev_cls_inst_map[c] is a vector of 
                                 BlobObjects, indicating the instance of class
                                 c in the previous screen
-        - m_forground_matrix    m_forground_matrix[i][j] = 1 if the (i,j) pixel
-                                is in the forground, 0 if it is in background
+        - pm_forground_matrix   Bit (i,j) is 1 if the (i,j) pixel is in the 
+                                forground, 0 if it is in background
         - v_forground_y_ind     Y indecies of the forground pixels
         - v_forground_x_ind     X indecies of the forground pixels
+        - v_forground_rows      The rows with at least one forground pixel
         - i_screen_height       Height of the screen
         - i_screen_width        Width of the screen
         - f_abs_pos_scale_factor_x  Precomputed factors (_x,_y) for scaling
@@ -85,8 +90,17 @@ class ClassAgent : public PlayerAgent {
 		- i_max_obj_velocity    Maximum velocity (pixel/sec) of objects on 
 								screen
 		- i_max_obj_vel_half	i_max_obj_velocity / 2 
+		- p_prev_instances_grid	The previous instances of one class, in 
+								cells of i_max_obj_velocity pixels
 		- i_max_num_detected_instaces	Maximum number of instances that will be
 								detected from each class
+		- i_max_pair_distance	Pairs of instances further apart than this
+								(in pixels, in x or y) are left out of the 
+								feature-vector (0 means never)
+		- v_abs_tiles_cache		The tiles of each absolute position on the 
+								screen (-1 when not computed yet)
+		- v_rel_tiles_cache		The tiles of each relative position of two
+								instances (-1 when not computed yet)
     ************************************************************************* */
 
     public:
@@ -160,9 +174,10 @@ class ClassAgent : public PlayerAgent {
         void swap_curr_and_prev_class_instances();
         
         /* *********************************************************************
-            Extracts the foreground by subtracting the background matrix from
-            the screen matrix, and fills the m_forground_matrix, 
-            v_forground_x_ind, and v_forground_y_ind vectors
+            Copies the foreground bitmap of the shared screen planes (the 
+            screen matrix minus the background matrix), and fills the pm_forground_matrix, 
+            v_forground_x_ind, v_forground_y_ind and v_forground_rows 
+            vectors
          ******************************************************************** */
         void extract_forground();
 
@@ -209,6 +224,14 @@ class ClassAgent : public PlayerAgent {
                                           bool& is_approaching_y);
 
         
+        /* *********************************************************************
+            Returns the i_num_tilings tiles of the given scaled position, 
+            from the given cell of the tiles cache. The tiles are computed 
+            the first time the cell is used
+         ******************************************************************** */
+        const int* get_cached_tiles(IntVect& tiles_cache, int cell, 
+                                    float x_scaled, float y_scaled);
+
         /* *********************************************************************
             Appends a new subvector of length size to feature_map[a]
          ******************************************************************** */
@@ -240,9 +263,10 @@ class ClassAgent : public PlayerAgent {
         ShapeList* pv_sorted_shape_list;
         ClassInstancesMap* pv_curr_cls_inst_map;
         ClassInstancesMap* pv_prev_cls_inst_map;
-        IntMatrix m_forground_matrix;
+        PackedBitMatrix* pm_forground_matrix;
         IntVect v_forground_y_ind;
         IntVect v_forground_x_ind;
+        IntVect v_forground_rows;
         int i_screen_height;
         int i_screen_width;
         float f_abs_pos_scale_factor_x;
@@ -257,7 +281,13 @@ class ClassAgent : public PlayerAgent {
 		bool b_end_episode_with_reward;
 		int i_max_obj_velocity;
 		int i_max_obj_vel_half;
+		SpatialGrid* p_prev_instances_grid;
+		IntVect v_nearby_instances;
 		int i_max_num_detected_instaces;
+		int i_base_length;
+		int i_max_pair_distance;
+		IntVect v_abs_tiles_cache;
+		IntVect v_rel_tiles_cache;
 };
 
 
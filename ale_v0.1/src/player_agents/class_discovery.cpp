@@ -21,7 +21,8 @@
 #include "game_controller.h"
 #include "class_discovery.h"
 
-ClassDiscovery::ClassDiscovery(OSystem* _osystem) {
+ClassDiscovery::ClassDiscovery(OSystem* _osystem, 
+								ScreenPlanes* screen_planes) {
 	p_osystem = _osystem;
 	MediaSource& mediasrc = p_osystem->console().mediaSource();
     i_screen_width  = mediasrc.width();
@@ -40,12 +41,16 @@ ClassDiscovery::ClassDiscovery(OSystem* _osystem) {
 	// Load the background matrix
 	pm_background_matrix = new IntMatrix;
 	import_matrix(pm_background_matrix, "background_matrix.txt");
+	screen_planes->set_background(pm_background_matrix);
+	screen_planes->use_parts(FORGROUND_PLANE);
 	// Initialize the Rigion-Manager
 	p_region_manager = new RegionManager(p_osystem, pm_background_matrix);
 	// Initilize object/class lists
 	pv_curr_screen_objects = NULL;
 	pv_prev_screen_objects = NULL;
 	pv_discovered_classes = new BlobClassList;
+	p_prev_objects_grid = new SpatialGrid(i_screen_height, i_screen_width, 
+										  i_max_obj_velocity);
 }
 
 ClassDiscovery::~ClassDiscovery() {
@@ -53,24 +58,55 @@ ClassDiscovery::~ClassDiscovery() {
 	delete pm_background_matrix;
 	clear_list_of_pointers(pv_discovered_classes);
 	delete pv_discovered_classes;
+	delete p_prev_objects_grid;
 }
 
 
 /* *********************************************************************
 	Recieves a new screen for class discovery
  ******************************************************************** */
-void ClassDiscovery::get_new_screen(const IntMatrix* screen_matrix, 
+void ClassDiscovery::get_new_screen(ScreenPlanes* screen_planes, 
 									int frame_number) {
-	if (frame_number < 1000) {
-		return; // ignore the first 1000 frames, since some games act wiered
+	if (!is_screen_needed(frame_number)) {
+		return;
+	}
+	// RegionManager takes care of the clean-up of the objects
+	add_screen_objects(p_region_manager->extract_objects_from_new_screen(
+												screen_planes, frame_number), 
+					   frame_number);
+}
+
+/* *********************************************************************
+	Returns true if the screen of the given frame is still used for class
+	discovery
+ ******************************************************************** */
+bool ClassDiscovery::is_screen_needed(int frame_number) const {
+	if (frame_number < CLS_DISC_FIRST_FRAME) {
+		return false; // ignore the first frames, since some games act wiered
 	}
 	if (i_num_screens > i_max_num_screens || pv_discovered_classes->size() > 200) {
-		return; // we are done with class discovery
+		return false; // we are done with class discovery
+	}
+	return true;
+}
+
+/* *********************************************************************
+	Assigns the objects extracted from a new screen to the classes 
+	(discovering new classes as needed), and exports the classes after 
+	the last screen
+ ******************************************************************** */
+void ClassDiscovery::add_screen_objects(const RegionObjectList* screen_objects,
+										int frame_number) {
+	pv_prev_screen_objects = pv_curr_screen_objects;
+	pv_curr_screen_objects = screen_objects;
+	p_prev_objects_grid->clear();
+	if (pv_prev_screen_objects) {
+		for (unsigned int i = 0; i < pv_prev_screen_objects->size(); i++) {
+			const RegionObject* prev_obj = (*pv_prev_screen_objects)[i];
+			p_prev_objects_grid->add_point(prev_obj->i_center_x, 
+										   prev_obj->i_center_y, i);
+		}
 	}
-	pv_prev_screen_objects = pv_curr_screen_objects; // RegionManager takes care
-													 // of their clean-up
-	pv_curr_screen_objects = p_region_manager->extract_objects_from_new_screen(
-												screen_matrix, frame_number);
 
 	for (unsigned int i = 0; i <  pv_curr_screen_objects->size(); i++) {
 		RegionObject* obj = (*pv_curr_screen_objects)[i];
@@ -110,7 +146,7 @@ void ClassDiscovery::get_new_screen(const IntMatrix* screen_matrix,
 			prev_obj = obj->get_closest_obj_in_list(
 							pv_prev_screen_objects, pv_prev_screen_objects->size(), 
 							f_max_shape_area_dif, f_max_perc_difference, 
-							i_max_obj_velocity);
+							i_max_obj_velocity, p_prev_objects_grid);
 		}
 		if (prev_obj) {
 			// There was a similar object in the previous frame
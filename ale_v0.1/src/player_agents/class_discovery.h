@@ -22,6 +22,9 @@
 #include "blob_object.h"
 #include "blob_class.h"
 
+#define CLS_DISC_FIRST_FRAME 1000	// The screens before this frame are 
+									// ignored, since some games act wiered
+
 typedef vector < BlobClass* > BlobClassList;
 
 class ClassDiscovery  {
@@ -43,6 +46,8 @@ class ClassDiscovery  {
 									shapes still be considered similar
 		- i_max_obj_velocity		Maximum velocity (pixel/sec) of objects on 
 									screen 
+		- p_prev_objects_grid		The objects of the previous screen, in 
+									cells of i_max_obj_velocity pixels
 		- f_max_shape_area_dif		How much two shape areas can differ, and 
 									the distance between them still be 
 									meaningful. 
@@ -61,15 +66,36 @@ class ClassDiscovery  {
     ************************************************************************* */
 
     public:
-        ClassDiscovery(OSystem* _osystem);
+        /* *********************************************************************
+            Constructor. Sets the background of the given screen planes to 
+			the detected background, and asks them for the foreground
+         ******************************************************************** */
+        ClassDiscovery(OSystem* _osystem, ScreenPlanes* screen_planes);
         virtual ~ClassDiscovery();
 
 		/* *********************************************************************
             Recieves a new screen for class discovery
          ******************************************************************** */
-		virtual void get_new_screen(const IntMatrix* screen_matrix, 
+		virtual void get_new_screen(ScreenPlanes* screen_planes, 
 									int frame_number);
 
+		/* *********************************************************************
+            Returns true if the screen of the given frame is still used for
+			class discovery
+         ******************************************************************** */
+		bool is_screen_needed(int frame_number) const;
+
+		/* *********************************************************************
+            Assigns the objects extracted from a new screen to the classes
+			(discovering new classes as needed), and exports the classes 
+			after the last screen. The objects must stay valid until the 
+			objects of the next screen are added. This is the sequential part
+			of get_new_screen: class_disc_tool extracts the objects of the
+			screens in parallel and adds them here in order
+         ******************************************************************** */
+		void add_screen_objects(const RegionObjectList* screen_objects, 
+								int frame_number);
+
 		/* *********************************************************************
             Returns true when the classes are extracted and saved
          ******************************************************************** */
@@ -124,6 +150,7 @@ class ClassDiscovery  {
 		RegionManager* p_region_manager;
 		const RegionObjectList* pv_curr_screen_objects;
 		const RegionObjectList* pv_prev_screen_objects;
+		SpatialGrid* p_prev_objects_grid;
 		BlobClassList* pv_discovered_classes;
 		int i_screen_width;
 		int i_screen_height;
@@ -80,6 +80,7 @@ ClassShape::ClassShape( string& imported_txt) {
     if (i_first_one_ind == -1) {
         complain_and_exit(imported_txt);
     }
+    pm_packed_shape = new PackedBitMatrix(pm_shape);
     
     cout << "shape imported successfully :)" << endl;
 }
@@ -91,6 +92,7 @@ ClassShape::~ClassShape() {
     if (pm_shape) {
         delete pm_shape;
     }
+    delete pm_packed_shape;
 }
 
 /* *********************************************************************
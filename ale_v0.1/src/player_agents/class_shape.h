@@ -19,6 +19,7 @@
 
 #include <vector>
 #include "common_constants.h"
+#include "packed_bit_matrix.h"
 
 class ClassShape;
 typedef vector<ClassShape*> ShapeList;
@@ -30,6 +31,7 @@ class ClassShape {
         Member variables:
             - pm_shape_matrix           2D binary shape matrix. 
                                         0 means background color. 
+            - pm_packed_shape           The shape matrix, as packed bit rows
             - i_width, i_height         Shape of the shape matrix
             - i_first_one_ind           The location of the first 1 in the 
                                         first row of the shape. This is used
@@ -72,6 +74,7 @@ class ClassShape {
         static ShapeList* import_shape_list(string filename, int& num_classes);
         
         IntMatrix* pm_shape;
+        PackedBitMatrix* pm_packed_shape;
         int i_width, i_height;
         int i_first_one_ind;
         int i_instance_of_class;
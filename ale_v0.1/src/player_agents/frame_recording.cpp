@@ -0,0 +1,154 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  frame_recording.cpp
+ *
+ *  Implementation of the FrameRecorder and FrameReader classes, which write
+ *  and read the compact recordings of the screens seen by a player agent
+ **************************************************************************** */
+
+#include <cstring>
+#include "frame_recording.h"
+
+FrameRecorder::FrameRecorder(const string& filename, int height, int width) {
+	i_height = height;
+	i_width = width;
+	i_num_frames = 0;
+	v_prev_colors.assign(i_height * i_width, 0);
+	v_curr_colors.assign(i_height * i_width, 0);
+	v_row_mask.assign((i_height + 7) / 8, 0);
+	// Fast compression: most of the saving comes from the skipped rows
+	p_file = gzopen(filename.c_str(), "wb1");
+	if (p_file == NULL) {
+		cerr << "Cannot create the frames recording " << filename << endl;
+		exit(-1);
+	}
+	FrameRecordingHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, FRAME_RECORDING_MAGIC, 8);
+	header.version = FRAME_RECORDING_VERSION;
+	header.height = i_height;
+	header.width = i_width;
+	gzwrite(p_file, &header, sizeof(header));
+}
+
+FrameRecorder::~FrameRecorder() {
+	gzclose(p_file);
+}
+
+/* *********************************************************************
+	Adds the given screen to the recording: its frame number, the mask
+	of its changed rows, and then the changed rows
+ ******************************************************************** */
+void FrameRecorder::add_frame(const IntMatrix* screen_matrix,
+							  int frame_number) {
+	for (int y = 0; y < i_height; y++) {
+		const IntVect& row = (*screen_matrix)[y];
+		uInt8* colors = &v_curr_colors[y * i_width];
+		for (int x = 0; x < i_width; x++) {
+			assert(row[x] >= 0 && row[x] < NUM_COLORS);
+			colors[x] = row[x];
+		}
+	}
+	for (int y = 0; y < i_height; y++) {
+		bool is_changed = (i_num_frames == 0 ||
+						   memcmp(&v_curr_colors[y * i_width],
+								  &v_prev_colors[y * i_width], i_width) != 0);
+		if (is_changed) {
+			v_row_mask[y / 8] |= (1 << (y % 8));
+		} else {
+			v_row_mask[y / 8] &= ~(1 << (y % 8));
+		}
+	}
+	gzwrite(p_file, &frame_number, sizeof(frame_number));
+	gzwrite(p_file, &v_row_mask[0], v_row_mask.size());
+	for (int y = 0; y < i_height; y++) {
+		if (v_row_mask[y / 8] & (1 << (y % 8))) {
+			gzwrite(p_file, &v_curr_colors[y * i_width], i_width);
+		}
+	}
+	v_prev_colors.swap(v_curr_colors);
+	i_num_frames++;
+}
+
+FrameReader::FrameReader(const string& filename) {
+	s_filename = filename;
+	i_frame_number = -1;
+	i_num_frames = 0;
+	p_file = gzopen(filename.c_str(), "rb");
+	if (p_file == NULL) {
+		cerr << "Cannot open the frames recording " << filename << endl;
+		exit(-1);
+	}
+	FrameRecordingHeader header;
+	if (gzread(p_file, &header, sizeof(header)) != sizeof(header) ||
+		memcmp(header.magic, FRAME_RECORDING_MAGIC, 8) != 0 ||
+		header.version != FRAME_RECORDING_VERSION) {
+		cerr << filename << " is not a version " << FRAME_RECORDING_VERSION
+			 << " frames recording" << endl;
+		exit(-1);
+	}
+	i_height = header.height;
+	i_width = header.width;
+	v_colors.assign(i_height * i_width, 0);
+	v_row_mask.assign((i_height + 7) / 8, 0);
+}
+
+FrameReader::~FrameReader() {
+	gzclose(p_file);
+}
+
+/* *********************************************************************
+	Reads the next screen. Returns false at the end of the recording.
+	A frame cut short (e.g. when the recording agent was killed) ends
+	the recording
+ ******************************************************************** */
+bool FrameReader::read_frame(void) {
+	int frame_number;
+	int num_read = gzread(p_file, &frame_number, sizeof(frame_number));
+	if (num_read == 0) {
+		return false;
+	}
+	bool is_complete = (num_read == sizeof(frame_number) &&
+						gzread(p_file, &v_row_mask[0], v_row_mask.size()) ==
+												(int)v_row_mask.size());
+	for (int y = 0; y < i_height && is_complete; y++) {
+		if (v_row_mask[y / 8] & (1 << (y % 8))) {
+			is_complete = (gzread(p_file, &v_colors[y * i_width], i_width) ==
+																	i_width);
+		}
+	}
+	if (!is_complete) {
+		cerr << "Warning: the frames recording " << s_filename
+			 << " is truncated after " << i_num_frames << " frames" << endl;
+		return false;
+	}
+	i_frame_number = frame_number;
+	i_num_frames++;
+	return true;
+}
+
+/* *********************************************************************
+	Copies the current screen into the given matrix (of the size of the
+	screens). When only_changed_rows is true, only the rows that changed
+	since the previous screen are copied
+ ******************************************************************** */
+void FrameReader::get_screen_matrix(IntMatrix* screen_matrix,
+									bool only_changed_rows) const {
+	for (int y = 0; y < i_height; y++) {
+		if (only_changed_rows && !(v_row_mask[y / 8] & (1 << (y % 8)))) {
+			continue;
+		}
+		IntVect& row = (*screen_matrix)[y];
+		const uInt8* colors = &v_colors[y * i_width];
+		for (int x = 0; x < i_width; x++) {
+			row[x] = colors[x];
+		}
+	}
+}
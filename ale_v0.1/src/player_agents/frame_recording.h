@@ -0,0 +1,133 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  frame_recording.h
+ *
+ *  Implementation of the FrameRecorder and FrameReader classes, which write
+ *  and read the compact recordings of the screens seen by a player agent
+ **************************************************************************** */
+
+#ifndef FRAME_RECORDING_H
+#define FRAME_RECORDING_H
+
+#include <zlib.h>
+#include "common_constants.h"
+#include "screen_planes.h"
+
+#define FRAME_RECORDING_MAGIC "ALEFRMS"
+#define FRAME_RECORDING_VERSION 1
+
+/* *************************************************************************
+	The header at the start of a (gzipped) recording. Each frame follows as:
+		the frame number (int)
+		a mask of the rows that changed since the previous frame, one bit
+		per row ((height + 7) / 8 bytes, the first frame has all rows set)
+		the colors of the changed rows, one byte per pixel
+ ************************************************************************* */
+struct FrameRecordingHeader {
+	char magic[8];			// FRAME_RECORDING_MAGIC
+	int version;			// FRAME_RECORDING_VERSION
+	int height;				// Height of the screens
+	int width;				// Width of the screens
+};
+
+class FrameRecorder {
+    /* *************************************************************************
+        Records screens into a gzipped file, so that the background
+		detection and the class discovery can be run offline on them
+		(see class_disc_tool). Only the rows that changed since the
+		previous screen are written.
+
+        Instance variabls:
+		- i_height, i_width		Size of the screens
+		- p_file				The gzipped recording
+		- v_prev_colors			The colors of the previous screen
+		- v_curr_colors			The colors of the current screen
+		- v_row_mask			The mask of the changed rows
+		- i_num_frames			Number of frames recorded so far
+    ************************************************************************* */
+
+    public:
+		/* *********************************************************************
+			Creates the recording. Exits when the file cannot be created
+		 ******************************************************************** */
+        FrameRecorder(const string& filename, int height, int width);
+        virtual ~FrameRecorder();
+
+		/* *********************************************************************
+			Adds the given screen to the recording
+		 ******************************************************************** */
+		void add_frame(const IntMatrix* screen_matrix, int frame_number);
+
+	protected:
+		int i_height;
+		int i_width;
+		gzFile p_file;
+		vector<uInt8> v_prev_colors;
+		vector<uInt8> v_curr_colors;
+		vector<uInt8> v_row_mask;
+		int i_num_frames;
+};
+
+class FrameReader {
+    /* *************************************************************************
+        Reads back, frame by frame, a recording made by FrameRecorder
+
+        Instance variabls:
+		- i_height, i_width		Size of the screens
+		- p_file				The gzipped recording
+		- s_filename			Name of the recording, for the error messages
+		- v_colors				The colors of the current screen
+		- v_row_mask			The mask of the rows changed in the current
+								screen
+		- i_frame_number		Frame number of the current screen
+		- i_num_frames			Number of frames read so far
+    ************************************************************************* */
+
+    public:
+		/* *********************************************************************
+			Opens the recording. Exits when it is not a valid recording
+		 ******************************************************************** */
+        FrameReader(const string& filename);
+        virtual ~FrameReader();
+
+		/* *********************************************************************
+			Reads the next screen. Returns false at the end of the recording
+		 ******************************************************************** */
+		bool read_frame(void);
+
+		/* *********************************************************************
+			Copies the current screen into the given matrix (of the size of
+			the screens). When only_changed_rows is true, only the rows that
+			changed since the previous screen are copied
+		 ******************************************************************** */
+		void get_screen_matrix(IntMatrix* screen_matrix,
+							   bool only_changed_rows = false) const;
+
+		/* *********************************************************************
+			Accessor methods
+		 ******************************************************************** */
+		const uInt8* get_colors(void) const {return &v_colors[0];}
+		int get_frame_number(void) const {return i_frame_number;}
+		int get_num_frames(void) const {return i_num_frames;}
+		int get_height(void) const {return i_height;}
+		int get_width(void) const {return i_width;}
+
+	protected:
+		int i_height;
+		int i_width;
+		gzFile p_file;
+		string s_filename;
+		vector<uInt8> v_colors;
+		vector<uInt8> v_row_mask;
+		int i_frame_number;
+		int i_num_frames;
+};
+
+#endif
@@ -39,9 +39,7 @@ ClassAgent(_game_settings, _osystem) {
 	if (optimistic_init) {
 		float weight_init = 1.0 / (float)(i_num_tilings * 11);
 		cout << "Setting all weights to " << weight_init << endl;
-		for (int i = 0; i < i_full_feature_vec_length; i++ ) {
-			(*(p_sarsa_lambda_solver->get_weights()))[i] = weight_init;
-		}
+		p_sarsa_lambda_solver->set_all_weights(weight_init);
 	}
 
 	pm_debug_best_val = new FloatMatrix();
@@ -214,7 +212,8 @@ void FreewayAgent::plot_best_value_per_state(void) {
 		for (int a = 0; a < i_num_actions; a++) {
 			v_Q[a] = 0;
 			for (int j = 0; j < (*pv_num_nonzero_in_f)[a]; j++) {
-				v_Q[a] += (*p_sarsa_lambda_solver->get_weights())[(*pv_curr_feature_map)[a][j]];
+				v_Q[a] += p_sarsa_lambda_solver->get_feature_weight(
+											(*pv_curr_feature_map)[a][j]);
 			}
 		}
 		// find the maximum
@@ -250,7 +249,8 @@ void FreewayAgent::plot_best_value_per_state(void) {
 		add_one_index_to_feature_map(one_ind, a);
 		v_Q[a] = 0;
 		for (int j = 0; j < (*pv_num_nonzero_in_f)[a]; j++) {
-			v_Q[a] += (*p_sarsa_lambda_solver->get_weights())[(*pv_curr_feature_map)[a][j]];
+			v_Q[a] += p_sarsa_lambda_solver->get_feature_weight(
+											(*pv_curr_feature_map)[a][j]);
 		}
 	}
 	double best_value = v_Q[0];	
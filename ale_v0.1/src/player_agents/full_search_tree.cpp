@@ -25,15 +25,30 @@
 	max_frame_num is reached.
  ******************************************************************* */
 FullSearchTree::FullSearchTree(SearchAgent* search_agent) :
-	SearchTree(search_agent) {
-	
+	SearchTree(search_agent),
+	p_state_store(NULL),
+	i_state_size(0) {
+	Settings& settings = p_search_agent->p_osystem->settings();
+	b_reuse_tree = settings.getBool("fulltree_reuse_tree", true);
+	long long max_mem_mb = settings.getInt("fulltree_max_mem_mb", true);
+	long long max_spill_mb = settings.getInt("fulltree_max_spill_mb", true);
+	if (max_mem_mb > 0) {
+		cout << "FullSearchTree: keeping " << max_mem_mb << "MB of states "
+			 << "in memory, and spilling up to " << max_spill_mb 
+			 << "MB to disk" << endl;
+		p_state_store = new PackedStateStore(max_mem_mb << 20, 
+							max_spill_mb << 20, 
+							settings.getString("fulltree_spill_file", true));
+	}
 }
 
 /* *********************************************************************
 	Deconstructor
  ******************************************************************* */
 FullSearchTree::~FullSearchTree() {
-
+	if (p_state_store) {
+		delete p_state_store;
+	}
 }
 
 /* *********************************************************************
@@ -44,6 +59,7 @@ void FullSearchTree::build(	const string start_state,
 	assert(p_root == NULL);
 	p_root = new TreeNode(NULL, start_state, start_frame_num, 
 						  p_search_agent, 0, UNDEFINED);
+	store_node_state(p_root);
 	update_tree();
 	is_built = true;				
 }
@@ -53,29 +69,90 @@ void FullSearchTree::build(	const string start_state,
 	leaf nodes
  ******************************************************************* */
 void FullSearchTree::update_tree() {
+	if (p_root->is_leaf() && p_root->i_state_handle == -1 && 
+		p_root->str_state.empty()) {
+		// A dead leaf whose state was dropped became the root. Its state is
+		// the current state of the game
+		p_root->str_state = p_search_agent->str_curr_state;
+	}
 	expand_tree(p_root);
 }
 
+/* *********************************************************************
+	Deletes the search-tree
+ ******************************************************************* */
+void FullSearchTree::clear() {
+	if (p_state_store) {
+		p_state_store->clear();
+	}
+	SearchTree::clear();
+}
+
+/* *********************************************************************
+	Moves the best sub-branch of the root to be the new root of the 
+	tree, and drops the states of the deleted branches
+ ******************************************************************* */
+void FullSearchTree::move_to_best_sub_branch(void) {
+	SearchTree::move_to_best_sub_branch();
+	if (p_state_store == NULL) {
+		return;
+	}
+	// Only the leaves of the new tree still hold a state
+	queue<TreeNode*> q;
+	q.push(p_root);
+	IntVect live_handles;
+	while (!q.empty()) {
+		TreeNode* node = q.front();
+		q.pop();
+		if (node->i_state_handle != -1) {
+			live_handles.push_back(node->i_state_handle);
+		}
+		for (unsigned int c = 0; c < node->v_children.size(); c++) {
+			q.push(node->v_children[c]);
+		}
+	}
+	p_state_store->compact(live_handles);
+}
+
+/* *********************************************************************
+	Returns the number of nodes in the tree, the bytes of state they 
+	hold (including the state-store), and the maximum and mean depth 
+	of the leaves
+ ******************************************************************* */
+void FullSearchTree::get_tree_stats(int& num_nodes, long long& state_bytes,
+									int& max_depth, float& mean_depth) const {
+	SearchTree::get_tree_stats(num_nodes, state_bytes, max_depth, mean_depth);
+	if (p_state_store) {
+		state_bytes += p_state_store->get_mem_bytes() + 
+					   p_state_store->get_spilled_bytes();
+	}
+}
+
 /* *********************************************************************
 	Expands the tree from the given node until i_max_sim_steps_per_tree 
-	is reached
-	
-	TODO: this is depth first. Change it back to breadth first!
+	is reached (or the state-store runs out of room). 
+	The expansion is breadth first, starting from the current leaves.
  ******************************************************************* */
 void FullSearchTree::expand_tree(TreeNode* start_node) { 
-
 	queue<TreeNode*> q;
-	q.push(start_node);
+	push_frontier_leaves(start_node, q);
+	int num_actions = p_search_agent->i_num_actions;
+	bool expanded_any = false;
 	while(!q.empty()) {
 		if (p_search_agent->get_num_simulated_steps() > i_max_sim_steps_per_tree) {
 			break;
 		}
+		if (expanded_any && p_state_store != NULL && 
+			!p_state_store->has_room(num_actions * i_state_size)) {
+			break;
+		}
 		TreeNode* curr_node = q.front();
 		q.pop();
-		for (int a = 0; a < p_search_agent->i_num_actions; a++) {
+		string curr_state = take_node_state(curr_node);
+		for (int a = 0; a < num_actions; a++) {
 			Action act = (*p_search_agent->p_game_settings->pv_possible_actions)[a];
 			TreeNode* new_child = new TreeNode(	curr_node,
-												curr_node->str_state, 
+												curr_state, 
 												curr_node->i_frame_num, 
 												p_search_agent, 
 												i_sim_steps_per_node, 
@@ -85,46 +162,71 @@ void FullSearchTree::expand_tree(TreeNode* start_node) {
 				i_deepest_node_frame_num = new_child->i_frame_num;
 			}
 			if (!new_child->b_is_dead) {
+				store_node_state(new_child);
 				q.push(new_child);
+			} else if (p_state_store != NULL) {
+				// dead nodes are never expanded
+				string().swap(new_child->str_state);
 			}
 		}
+		expanded_any = true;
+		p_search_agent->p_telemetry->i_iterations++;
 	}
-/*	
-	start_node->b_is_dead = true;
 	if (!start_node->v_children.empty()) {
-		// This is not a leaf node
-		for (unsigned int c = 0; c < start_node->v_children.size(); c++) {
-			TreeNode* curr_child = start_node->v_children[c];
-			expand_tree(curr_child);
-			start_node->b_is_dead = ( start_node->b_is_dead && 
-									  curr_child->b_is_dead );
-		}
-	} else {
-		// This is a leaf node. Expand it.
-		for (int a = 0; a < p_search_agent->i_num_actions; a++) {
-			Action act = (*p_search_agent->p_game_settings->pv_possible_actions)[a];
-			TreeNode* new_child = new TreeNode(	start_node,
-												start_node->str_state, 
-												start_node->i_frame_num, 
-												p_search_agent, 
-												i_sim_steps_per_node, 
-												act);
-			start_node->v_children.push_back(new_child);
-			if (new_child->i_frame_num > i_deepest_node_frame_num) {
-				i_deepest_node_frame_num = new_child->i_frame_num;
-			}
-			if (!new_child->b_is_dead) {
-				expand_tree(new_child);
+		update_branch_reward(start_node);
+	}
+}
+
+/* *********************************************************************
+	Pushes the leaves of the given branch that are not dead to the 
+	queue, in breadth-first order
+ ******************************************************************* */
+void FullSearchTree::push_frontier_leaves(TreeNode* start_node, 
+										  queue<TreeNode*>& q) {
+	queue<TreeNode*> bfs;
+	bfs.push(start_node);
+	while (!bfs.empty()) {
+		TreeNode* node = bfs.front();
+		bfs.pop();
+		if (node->is_leaf()) {
+			if (!node->b_is_dead || node == start_node) {
+				q.push(node);
 			}
-			start_node->b_is_dead = ( start_node->b_is_dead && 
-									  new_child->b_is_dead );
+			continue;
+		}
+		for (unsigned int c = 0; c < node->v_children.size(); c++) {
+			bfs.push(node->v_children[c]);
 		}
 	}
-*/
-	update_branch_reward(start_node);
 }
 
+/* *********************************************************************
+	Moves the state of the given node to the state-store (when we are
+	running with a memory budget)
+ ******************************************************************* */
+void FullSearchTree::store_node_state(TreeNode* node) {
+	if (p_state_store == NULL) {
+		return;
+	}
+	assert(node->i_state_handle == -1);
+	i_state_size = node->str_state.size();
+	node->i_state_handle = p_state_store->put(node->str_state);
+	string().swap(node->str_state);
+}
 
+/* *********************************************************************
+	Returns the state of the given node. Since the node is about to be
+	expanded, its state is dropped from the state-store.
+ ******************************************************************* */
+string FullSearchTree::take_node_state(TreeNode* node) {
+	if (node->i_state_handle == -1) {
+		return node->str_state;
+	}
+	string state = p_state_store->get(node->i_state_handle);
+	p_state_store->release(node->i_state_handle);
+	node->i_state_handle = -1;
+	return state;
+}
 
 /* *********************************************************************
 	Updates the branch reward for the given node
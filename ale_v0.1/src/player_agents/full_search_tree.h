@@ -18,6 +18,7 @@
 #define FULL_SEARCH_TREE_H
 
 #include "search_tree.h"
+#include "packed_state_store.h"
 
 
 
@@ -49,6 +50,33 @@ class FullSearchTree : public SearchTree {
 			Re-Expands the tree until i_max_sim_steps_per_tree is reached
          ******************************************************************* */
 		virtual void update_tree();
+
+		/* *********************************************************************
+            Deletes the search-tree
+         ******************************************************************* */
+		virtual void clear();
+
+		/* *********************************************************************
+			Moves the best sub-branch of the root to be the new root of the 
+			tree, and drops the states of the deleted branches
+         ******************************************************************* */
+		virtual void move_to_best_sub_branch(void);
+
+		/* *********************************************************************
+			Returns true when the tree is kept across decisions, and expanded
+			from its leaves (fulltree_reuse_tree)
+         ******************************************************************* */
+		virtual bool is_reused(void) const {
+			return b_reuse_tree;
+		}
+
+		/* *********************************************************************
+			Returns the number of nodes in the tree, the bytes of state they 
+			hold (including the state-store), and the maximum and mean depth 
+			of the leaves
+         ******************************************************************* */
+		virtual void get_tree_stats(int& num_nodes, long long& state_bytes,
+									int& max_depth, float& mean_depth) const;
 		
 	protected:	
 
@@ -64,6 +92,33 @@ class FullSearchTree : public SearchTree {
          ******************************************************************* */
 		void update_branch_reward(TreeNode* node);
 
+		/* *********************************************************************
+			Pushes the leaves of the given branch that are not dead to the 
+			queue, in breadth-first order
+         ******************************************************************* */
+		void push_frontier_leaves(TreeNode* start_node, queue<TreeNode*>& q);
+
+		/* *********************************************************************
+			Moves the state of the given node to the state-store (when we are
+			running with a memory budget)
+         ******************************************************************* */
+		void store_node_state(TreeNode* node);
+
+		/* *********************************************************************
+			Returns the state of the given node. Since the node is about to be
+			expanded, its state is dropped from the state-store.
+         ******************************************************************* */
+		string take_node_state(TreeNode* node);
+
+
+		PackedStateStore* p_state_store;// Holds the states of the frontier 
+									// nodes. NULL means every node keeps its
+									// own state (no memory budget)
+		int i_state_size;			// Size of the last stored state, used to
+									// tell if there is room for more children
+		bool b_reuse_tree;			// When true, the tree is kept across 
+									// decisions, and expanded from its leaves
+
 
 };
 
@@ -51,7 +51,8 @@ GridScrAgent::GridScrAgent(GameSettings* _game_settings, OSystem* _osystem) :
     i_full_feature_vec_length = i_base_length * i_num_actions;
 	cout << "Full Feature-Vector Length: " << i_full_feature_vec_length << endl;
 	p_sarsa_lambda_solver = RLSarsaLambda::generate_rl_sarsa_lambda_instance(
-						p_osystem, i_full_feature_vec_length, i_num_actions);
+						p_osystem, i_full_feature_vec_length, i_num_actions,
+						i_base_length);
     pv_curr_feature_map  = new FeatureMap();
     pv_num_nonzero_in_f = new IntVect();
     for (int i = 0; i < i_num_actions; i++) {
@@ -59,7 +60,11 @@ GridScrAgent::GridScrAgent(GameSettings* _game_settings, OSystem* _osystem) :
         pv_curr_feature_map->push_back(feature_vec);
         pv_num_nonzero_in_f->push_back(0);
     }
-    pv_tmp_fv_first_part = new IntArr(-1, i_blocks_bits_length);
+    pv_tmp_bit_words = new BitWordVect;
+    pv_tmp_active_bits = new IntVect;
+    pv_tmp_feature_inds = new IntVect;
+	p_screen_planes->set_block_size(i_block_height, i_block_width);
+	p_screen_planes->use_parts(BLOCK_COLOR_MASKS);
 	pv_tmp_color_bits = new IntVect;
 	for (int c = 0; c < i_num_colors; c++) {
 		pv_tmp_color_bits->push_back(0);
@@ -77,6 +82,7 @@ GridScrAgent::GridScrAgent(GameSettings* _game_settings, OSystem* _osystem) :
 		// Load the background matrix
 		pm_background_matrix = new IntMatrix;
 		import_matrix(pm_background_matrix, "background_matrix.txt");
+		p_screen_planes->set_background(pm_background_matrix);
 	} else {
 		pm_background_matrix = NULL;
 	}
@@ -86,7 +92,9 @@ GridScrAgent::~GridScrAgent() {
     delete p_sarsa_lambda_solver;
     delete pv_curr_feature_map;
     delete pv_num_nonzero_in_f;
-    delete pv_tmp_fv_first_part;
+    delete pv_tmp_bit_words;
+    delete pv_tmp_active_bits;
+    delete pv_tmp_feature_inds;
 	delete pv_tmp_color_bits;
     delete pv_subvector_positions;
 	if (pm_background_matrix) {
@@ -166,41 +174,31 @@ void GridScrAgent::generate_feature_vec(void) {
         (*pv_num_nonzero_in_f)[a] = 0;
     }
     int full_vect_index = 0;
-    int i, j, c, bit_val;
-    // Get the color-bits for all blocks into our temp array,
-    // Also, generate the first part of the feature-vector
-	for (c = 0; c < i_num_colors; c++) {
-		(*pv_tmp_color_bits)[c] = 0;
-	} 
+    int i, j, c;
+    // Get the color-bits for all blocks into our bit-words
+	pv_tmp_bit_words->assign(
+		(i_blocks_bits_length + BITS_PER_WORD - 1) / BITS_PER_WORD, 0);
     for (i = 0; i < i_num_block_per_row; i++) {
 		for (j = 0; j < i_num_block_per_col; j++) {	
 			get_color_ind_from_block(i, j, pv_tmp_color_bits);
 			for (c = 0; c < i_num_colors; c++) {
-				bit_val = (*pv_tmp_color_bits)[c];
-				(*pv_tmp_fv_first_part)[full_vect_index] = bit_val;
-				if (bit_val == 1) {
-					add_one_index_to_feature_map(full_vect_index);
+				if ((*pv_tmp_color_bits)[c] == 1) {
+					set_bit(*pv_tmp_bit_words, full_vect_index);
 				}
 				full_vect_index++;
             }
 		}
 	}
-   // Now we'll get the crossproduct of all the bits
-    for (int i = 0; i < i_blocks_bits_length; i++) {
-//      Possible major oprimization:
-//        if ((*pv_tmp_fv_first_part)[i]  == 0) {
-//            full_vect_index += (i_ram_bits_length - (i + 1));
-//            continue;
-//        }
-        for (int j = i + 1; j < i_blocks_bits_length; j++) {
-            if ((*pv_tmp_fv_first_part)[i]  == 1 &&
-                (*pv_tmp_fv_first_part)[j] == 1) { 
-                add_one_index_to_feature_map(full_vect_index);
-            }
-            full_vect_index++;
-        }
+	assert(full_vect_index == i_blocks_bits_length);
+    // Now we generate the bits and their crossproduct, from the set bits only
+    extract_active_bits(*pv_tmp_bit_words, *pv_tmp_active_bits);
+    pv_tmp_feature_inds->clear();
+    generate_bit_pair_features(*pv_tmp_active_bits, i_blocks_bits_length, 
+                               *pv_tmp_feature_inds);
+    for (unsigned int f = 0; f < pv_tmp_feature_inds->size(); f++) {
+        assert((*pv_tmp_feature_inds)[f] < i_base_length);
+        add_one_index_to_feature_map((*pv_tmp_feature_inds)[f]);
     }
-    assert(full_vect_index == i_base_length);
 }
 
 
@@ -209,7 +207,8 @@ void GridScrAgent::generate_feature_vec(void) {
 /* *********************************************************************
 	Given the [i,j] indecies of a block, generates a integer vector 
 	color_inds, such that color_inds[c] = 1 if the color c exists in 
-	the block.
+	the block. The colors of the block are read from its color mask in 
+	the shared screen planes
 ******************************************************************** */
 void GridScrAgent::get_color_ind_from_block(int i, int j, IntVect* color_bits) {
 	// reset the given vector all to zero
@@ -218,20 +217,13 @@ void GridScrAgent::get_color_ind_from_block(int i, int j, IntVect* color_bits) {
 	}
 	assert (i >= 0 && i < i_num_block_per_row);
 	assert (j >= 0 && j < i_num_block_per_col);
-	int img_i = i * i_block_height;
-	int img_j = j * i_block_width;
-	for (int block_row = 0; block_row < i_block_height; block_row++) {
-		for (int block_col = 0; block_col < i_block_width; block_col++) {
-			int y = img_i + block_row;
-			int x = img_j + block_col;
-			assert (y >= 0 && y < i_screen_height);
-			assert (x >= 0 && x < i_screen_width);
-			int color_ind = (*pm_curr_screen_matrix)[y][x];
-			if (b_do_subtract_bg && 
-				color_ind == (*pm_background_matrix)[y][x] ) {
-				continue;	// background pixel
-			}
-			assert(color_ind >= 0 && color_ind < 256);
+	const BitWord* block_colors = p_screen_planes->get_block_colors(i, j, 
+															b_do_subtract_bg);
+	for (int w = 0; w < COLOR_MASK_WORDS; w++) {
+		BitWord bits = block_colors[w];
+		while (bits != 0) {
+			int color_ind = w * BITS_PER_WORD + __builtin_ctzll(bits);
+			bits &= bits - 1;
 			assert(color_ind % 2 == 0);
 			int color_bit = pi_eight_bit_pallete[color_ind];
 			(*color_bits)[color_bit] = 1;
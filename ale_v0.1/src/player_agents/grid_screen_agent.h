@@ -19,6 +19,7 @@
 #include "common_constants.h"
 #include "player_agent.h"
 #include "rl_sarsa_lambda.h"
+#include "bit_pair_tools.h"
 
 class GridScrAgent : public PlayerAgent {
     /* *************************************************************************
@@ -29,8 +30,11 @@ class GridScrAgent : public PlayerAgent {
         - pv_curr_feature_map   pv_curr_feature_map[a] is the feature-vector 
                                 for action a.
         - pv_num_nonzero_in_f   Number of non-zero values in each feature-vector 
-        - pv_tmp_fv_first_part  An array containing the first part of the 
-                                feature-vector (this is only used internally)
+        - pv_tmp_bit_words      The color-bits of all blocks packed in 
+                                bit-words
+        - pv_tmp_active_bits    Indices of the set color-bits
+        - pv_tmp_feature_inds   Indices of the set bits and set bit-pairs
+                                (these three are only used internally)
 		- pv_tmp_color_bits		Temp array that  keeps color-bits for one block
         - p_sarsa_lambda_solver Pointer to the SARSA-Lambda solver object
 		- pm_background_matrix	Background matrix
@@ -127,7 +131,9 @@ class GridScrAgent : public PlayerAgent {
         FeatureMap* pv_curr_feature_map;
         IntVect* pv_num_nonzero_in_f;
         RLSarsaLambda* p_sarsa_lambda_solver;
-        IntArr* pv_tmp_fv_first_part;
+        BitWordVect* pv_tmp_bit_words;
+        IntVect* pv_tmp_active_bits;
+        IntVect* pv_tmp_feature_inds;
 		IntVect* pv_tmp_color_bits;
 		IntMatrix* pm_background_matrix;
 		float f_alpha_multiplier;
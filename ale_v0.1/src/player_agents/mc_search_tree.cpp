@@ -9,13 +9,14 @@
  * *****************************************************************************
  *  mc_search_tree.cpp
  *
- *  Implementation of the MCSearchTree class, an implementation of the 
- *  Upper Confidence Bound for Trees algorithm for the Rollout agent
+ *  Implementation of the MCSearchTree class, a flat Monte Carlo search 
+ *  for the Rollout agent
  **************************************************************************** */
 
 #include "mc_search_tree.h"
 #include "search_agent.h"
 #include "random_tools.h"
+#include "Deserializer.hxx"
 
 /* *********************************************************************
 	Constructor
@@ -24,6 +25,11 @@ MCSearchTree::MCSearchTree(SearchAgent* search_agent) :
 	SearchTree(search_agent) {
 	Settings& settings = p_search_agent->p_osystem->settings();
 	i_uct_monte_carlo_steps = settings.getInt("uct_monte_carlo_steps", true);
+	i_mc_rollouts_per_batch = settings.getInt("mc_rollouts_per_batch", true);
+	if (i_mc_rollouts_per_batch < 1) {
+		cerr << "mc_rollouts_per_batch must be at least 1" << endl;
+		exit(-1);
+	}
 	f_uct_exploration_const = settings.getFloat("uct_exploration_const", true);
 	i_uct_min_death_count = settings.getInt("uct_min_death_count", true);
 	if (settings.getString("uct_branch_value_method", true) == "average") {
@@ -69,55 +75,71 @@ void MCSearchTree::build(	const string start_state, int start_frame_num) {
 	Re-Expands the tree until i_max_sim_steps_per_tree is reached
  ******************************************************************* */
 void MCSearchTree::update_tree(void) {
-	int i = 0;
 	while(true) {
-		i++;
-		single_uct_iteration();
+		run_rollout_batch();
 		if (p_search_agent->get_num_simulated_steps() > 
 			i_max_sim_steps_per_tree) {
-			cout << "Perfomred " << i << " MC iterations, " 
-                << " k = " << i/p_root->v_children.size() << endl;
 			break;
 		}
 	}
-    //print();
-
 }
 
 
 /* *********************************************************************
-	Performs a single UCT iteration, starting from the root
+	Runs one batch of rollouts: i_mc_rollouts_per_batch rollouts from 
+	every child of the root. The batch is scheduled first, and the 
+	values are only updated once all its rollouts are done, so the 
+	rollouts of different children do not depend on each other.
  ******************************************************************* */
-void MCSearchTree::single_uct_iteration(void) {
-	TreeNode* curr_node = p_root;
-
+void MCSearchTree::run_rollout_batch(void) {
 	if(p_root->is_leaf()) {
         expand_node(p_root);
     }
-    // get next child
-    int next_child = get_next_child(p_root);
-
-	do {
-        curr_node = p_root->v_children[next_child];
-		
-	
-        // Do a manto-carlo search for i_uct_monte_carlo_steps steps 
-        float new_reward;
-        bool is_dead;
-        do_monte_carlo(curr_node, new_reward, is_dead);
-        is_dead = is_dead || curr_node->b_is_dead;	// death either during 
-        // monte carlo rt node itself
-        if (b_avg_reward_per_frame) {
-            int frames_from_root = curr_node->i_frame_num - p_root->i_frame_num;
-            assert (frames_from_root > 0);
-            frames_from_root += i_uct_monte_carlo_steps;
-            new_reward /= frames_from_root;
-        }
-        update_values(curr_node, new_reward, is_dead);
+	int num_children = p_root->v_children.size();
+	vector<FloatVect> batch_rewards(num_children);
+	vector<IntVect> batch_deaths(num_children);
+	// Each child's rollouts are an independent unit of work: they only 
+	// read the child's state, and only write their own result vectors
+	for (int c = 0; c < num_children; c++) {
+		rollout_child(p_root->v_children[c], i_mc_rollouts_per_batch, 
+					  batch_rewards[c], batch_deaths[c]);
+	}
+	for (int c = 0; c < num_children; c++) {
+		TreeNode* curr_node = p_root->v_children[c];
+		for (unsigned int r = 0; r < batch_rewards[c].size(); r++) {
+			float new_reward = batch_rewards[c][r];
+			// death either during monte carlo or at the node itself
+			bool is_dead = batch_deaths[c][r] || curr_node->b_is_dead;
+			if (b_avg_reward_per_frame) {
+				int frames_from_root = curr_node->i_frame_num - 
+														p_root->i_frame_num;
+				assert (frames_from_root > 0);
+				frames_from_root += i_uct_monte_carlo_steps;
+				new_reward /= frames_from_root;
+			}
+			update_values(curr_node, new_reward, is_dead);
+		}
+	}
+}
 
-        next_child = get_next_child(p_root);
-    }while(next_child != 0);
-	
+/* *********************************************************************
+	Runs num_rollouts Monte Carlo rollouts from the given node. The 
+	node's state is deserialized once, and restored before each 
+	rollout. Rewards and deaths are appended to the given vectors.
+ ******************************************************************* */
+void MCSearchTree::rollout_child(TreeNode* child, int num_rollouts, 
+								 FloatVect& rewards, IntVect& deaths) {
+	Deserializer deser(child->str_state);
+	for (int r = 0; r < num_rollouts; r++) {
+		float reward;
+		bool is_dead;
+		p_search_agent->load_state(deser);
+		p_search_agent->simulate_game(RANDOM, i_uct_monte_carlo_steps, 
+									  child->i_frame_num, reward, is_dead);
+		rewards.push_back(reward);
+		deaths.push_back(is_dead);
+		p_search_agent->p_telemetry->i_iterations++;
+	}
 }
 
 /* *********************************************************************
@@ -145,9 +167,7 @@ Action MCSearchTree::get_best_action(void) {
 		cout << "is now: " << best_branch << endl;
 	}
 	p_root->i_best_branch = best_branch;
-	Action best_act = (*p_search_agent->p_game_settings->
-											pv_possible_actions)[best_branch];
-	return best_act;
+	return p_root->v_children[best_branch]->e_action;
 }
 
 /* *********************************************************************
@@ -163,18 +183,6 @@ int MCSearchTree::get_child_with_count_zero(const TreeNode* node)  const {
 	return -1;
 }
 
-/* *********************************************************************
-	Returns the index of the next child 
- ******************************************************************* */
-int MCSearchTree::get_next_child(TreeNode* node)  {
-    //cout << "i_mc_current_child: " << node->i_mc_current_child << endl;
-    //cout << "node->v_children.size(): " << node->v_children.size() << endl;
-    node->i_mc_current_child ++;
-    node->i_mc_current_child = node->i_mc_current_child % node->v_children.size();
-    //cout << "i_mc_current_child: " << node->i_mc_current_child << endl;
-    return node->i_mc_current_child;
-}
-
 /* *********************************************************************
 	Returns the sub-branch with the highest value
 	if add_exp_explt_val is true, we will add the UCT's
@@ -262,19 +270,6 @@ void MCSearchTree::expand_node(TreeNode* node) {
 }
 
 
-/* *********************************************************************
-	Performs a Monte Carlo simulation from the given node, for
-	i_uct_monte_carlo_steps steps. Returns the reward recieved, and 
-	wether the agent died or not
- ******************************************************************* */
-void MCSearchTree::do_monte_carlo(TreeNode* start_node, 
-									float& reward, bool& is_dead) {
-	p_search_agent->load_state(start_node->str_state);
-	p_search_agent->simulate_game(RANDOM, i_uct_monte_carlo_steps, 
-								 start_node->i_frame_num, 
-								 reward, is_dead);
-
-}
 /* *********************************************************************
 	Update the node values and counters from the current node, all the
 	 way up to the root
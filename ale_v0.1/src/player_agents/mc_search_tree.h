@@ -9,8 +9,8 @@
  * *****************************************************************************
  *  mc_search_tree.h
  *
- *  Implementation of the MCSearchTree class, an implementation of the 
- *  Upper Confidence Bound for Trees algorithm for the Rollout agent
+ *  Implementation of the MCSearchTree class, a flat Monte Carlo search 
+ *  for the Rollout agent
  **************************************************************************** */
 
 #ifndef MC_SEARCH_TREE_H
@@ -22,8 +22,9 @@
 
 class MCSearchTree : public SearchTree {
     /* *************************************************************************
-        Represents search a Full-Search-Tree (i.e. a search-tree taht expands 
-		all its nodes until the give ndebth), used by the Search Agent
+        Represents a flat Monte Carlo search (i.e. only the root is 
+		expanded, and its children are valued by batches of random 
+		rollouts), used by the Search Agent
     ************************************************************************* */
 	
     public:
@@ -61,9 +62,20 @@ class MCSearchTree : public SearchTree {
 	protected:	
 
 		/* *********************************************************************
-			Performs a single UCT iteration, starting from the root
+			Runs one batch of rollouts: i_mc_rollouts_per_batch rollouts from 
+			every child of the root. The batch is scheduled first, and the 
+			values are only updated once all its rollouts are done, so the 
+			rollouts of different children do not depend on each other.
          ******************************************************************* */
-		virtual void single_uct_iteration(void);
+		virtual void run_rollout_batch(void);
+
+		/* *********************************************************************
+			Runs num_rollouts Monte Carlo rollouts from the given node. The 
+			node's state is deserialized once, and restored before each 
+			rollout. Rewards and deaths are appended to the given vectors.
+		 ******************************************************************* */
+		void rollout_child(TreeNode* child, int num_rollouts, 
+						   FloatVect& rewards, IntVect& deaths);
 
 		/* *********************************************************************
 			Returns the index of the first child with zero count
@@ -71,13 +83,6 @@ class MCSearchTree : public SearchTree {
 		 ******************************************************************* */
 		int get_child_with_count_zero(const TreeNode* node) const;
         
-        /* *********************************************************************
-			Returns the index of the first child with zero count
-			Returns -1 if no such child is found
-		 ******************************************************************* */
-		int get_next_child(TreeNode* node);
-		
-
 		
 		/* *********************************************************************
 			Returns the sub-branch with the highest value
@@ -91,12 +96,6 @@ class MCSearchTree : public SearchTree {
 		 ******************************************************************* */
 		void expand_node(TreeNode* node);
 
-		/* *********************************************************************
-			Performs a Monte Carlo simulation from the given node, for
-			i_uct_monte_carlo_steps steps 
-		 ******************************************************************* */
-		void do_monte_carlo(TreeNode* start_node, float& reward, bool& is_dead);
-
 		/* *********************************************************************
 			Update the node values and counters from the current node, all the
 			 way up to the root
@@ -106,6 +105,8 @@ class MCSearchTree : public SearchTree {
 
 		int i_uct_monte_carlo_steps;// Number of simulated Monte Carlo steps 
 									// that will be run on each UCT iteration
+		int i_mc_rollouts_per_batch;// Number of rollouts from each child of
+									// the root in one batch
 		float f_uct_exploration_const;	// Exploration Constant
 		int i_uct_min_death_count;	// Minimum number of simulations that should
 									// end up dead from a node, before we mark 
@@ -5,9 +5,18 @@ MODULE_OBJS := \
 	src/player_agents/player_agent.o \
 	src/player_agents/random_agent.o \
 	src/player_agents/rl_sarsa_lambda.o \
+	src/player_agents/weight_vector.o \
+	src/player_agents/trace_store.o \
+	src/player_agents/weight_checkpoint.o \
+	src/player_agents/actor_learner_channel.o \
 	src/player_agents/tiles2.o \
 	src/player_agents/mountain_car_test.o \
 	src/player_agents/ram_agent.o \
+	src/player_agents/bit_pair_tools.o \
+	src/player_agents/packed_bit_matrix.o \
+	src/player_agents/screen_planes.o \
+	src/player_agents/spatial_grid.o \
+	src/player_agents/tia_objects.o \
 	src/player_agents/class_agent.o \
 	src/player_agents/blob_object.o \
 	src/player_agents/class_shape.o \
@@ -15,15 +24,19 @@ MODULE_OBJS := \
 	src/player_agents/common_constants.o \
 	src/player_agents/freeway_agent.o \
 	src/player_agents/background_detector.o \
+	src/player_agents/frame_recording.o \
+	src/player_agents/offline_class_discovery.o \
 	src/player_agents/class_discovery.o \
 	src/player_agents/region_manager.o \
 	src/player_agents/shape_tools.o \
 	src/player_agents/blob_class.o \
 	src/player_agents/grid_screen_agent.o \
 	src/player_agents/search_agent.o \
+	src/player_agents/search_telemetry.o \
 	src/player_agents/tree_node.o \
 	src/player_agents/search_tree.o \
 	src/player_agents/full_search_tree.o \
+	src/player_agents/packed_state_store.o \
 	src/player_agents/uct_search_tree.o \
 	src/player_agents/mc_search_tree.o \
 	src/player_agents/actions_summary_agent.o \
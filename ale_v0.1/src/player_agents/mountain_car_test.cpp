@@ -21,7 +21,8 @@
 /* *********************************************************************
     Constructor
  ******************************************************************** */
-MountanCar::MountanCar(OSystem* _osystem) {
+MountanCar::MountanCar(OSystem* _osystem, int _memory_size, 
+                       float trace_vec_size_ratio) {
     min_position       = -1.2;
     max_position       = 0.6;
     goal_position      = 0.5;
@@ -36,7 +37,7 @@ MountanCar::MountanCar(OSystem* _osystem) {
     curr_step_num      = 0;
     // Tiling Properties
     num_tilings        = 14;
-    memory_size        = 10000;
+    memory_size        = _memory_size;
     pos_scale          = 1.7 / 8.0;
     vel_scale          = 0.14 / 8.0;
     state_position     = 0.0;
@@ -54,7 +55,7 @@ MountanCar::MountanCar(OSystem* _osystem) {
     _osystem->settings().setFloat("gamma", 1.0);
 	_osystem->settings().setFloat("alpha", alpha);
     _osystem->settings().setBool("optimistic_init", true);
-    _osystem->settings().setFloat("trace_vec_size_ratio", 0.1);
+    _osystem->settings().setFloat("trace_vec_size_ratio", trace_vec_size_ratio);
     _osystem->settings().setFloat("minimum_trace_value", 0.01);
 	sarsa_lambda_solver = RLSarsaLambda::generate_rl_sarsa_lambda_instance(
 										_osystem, memory_size, num_actions);
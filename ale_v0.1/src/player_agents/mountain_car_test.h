@@ -25,8 +25,12 @@ class MountanCar {
     public:
         /* *********************************************************************
             Constructor
+            memory_size is the number of tile-coding features, and 
+            trace_vec_size_ratio caps the number of non-zero traces (as a
+            fraction of memory_size)
          ******************************************************************** */
-        MountanCar(OSystem* _osystem);
+        MountanCar(OSystem* _osystem, int _memory_size = 10000, 
+                   float trace_vec_size_ratio = 0.1);
         
         /* *********************************************************************
             Deconstructor
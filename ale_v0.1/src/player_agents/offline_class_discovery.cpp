@@ -0,0 +1,586 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  offline_class_discovery.cpp
+ *
+ *  Functions that run the background detection and the class discovery on a
+ *  recording of frames (see FrameRecorder), in several processes
+ **************************************************************************** */
+
+#include <cstdio>
+#include <sstream>
+#include <deque>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "offline_class_discovery.h"
+#include "frame_recording.h"
+#include "background_detector.h"
+#include "class_discovery.h"
+#include "region_manager.h"
+#include "screen_planes.h"
+#include "export_tools.h"
+#include "vector_matrix_tools.h"
+
+#define BG_WORKER_IDLE_USECS 200	// How long a background worker sleeps
+									// while waiting for the other workers
+#define BG_MAX_WORKER_LEAD 1024		// How many frames a background worker
+									// may get ahead of the slowest one
+#define WORKER_POLL_USECS 10000		// How often the calling process checks
+									// its workers while it waits for one
+
+/* *********************************************************************
+	A change of the most frequent color of a pixel, kept by a background
+	worker until it knows that the detection does not stop before it
+ ******************************************************************* */
+struct ModeChange {
+	int frame;
+	int pixel;
+	uInt8 prev_mode;		// The most frequent color before the frame
+};
+
+/* *********************************************************************
+	Returns the number of processes to use (class_disc_num_workers, or
+	the number of cores when it is 0)
+ ******************************************************************* */
+int get_class_disc_num_workers(OSystem* osystem) {
+	int num_workers = osystem->settings().getInt("class_disc_num_workers",
+												 true);
+	if (num_workers <= 0) {
+		num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	return max(num_workers, 1);
+}
+
+/* *********************************************************************
+	Returns a zeroed MAP_SHARED mapping of the given size, which the
+	forked workers share
+ ******************************************************************* */
+static void* map_shared(size_t num_bytes) {
+	void* map = mmap(NULL, num_bytes, PROT_READ | PROT_WRITE,
+					 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		cerr << "Cannot map " << num_bytes << " shared bytes" << endl;
+		exit(-1);
+	}
+	return map;
+}
+
+/* *********************************************************************
+	Forks a worker. Returns its pid in the calling process, and 0 in the
+	worker
+ ******************************************************************* */
+static pid_t fork_worker(int worker_id) {
+	cout.flush();	// or the worker prints our buffered output again
+	pid_t pid = fork();
+	if (pid == -1) {
+		cerr << "Failed to fork class-discovery worker " << worker_id << endl;
+		exit(-1);
+	}
+	return pid;
+}
+
+/* *********************************************************************
+	Ends a worker, without running the clean-up of the calling process
+	(the emulator and the files it shares with the calling process)
+ ******************************************************************* */
+static void end_worker(void) {
+	cout.flush();
+	cerr.flush();
+	_exit(0);
+}
+
+/* *********************************************************************
+	Exits a worker whose calling process is gone (the worker is then
+	reparented), instead of waiting for the other workers forever
+ ******************************************************************* */
+static void check_calling_process(pid_t parent_pid, int worker_id) {
+	if (getppid() != parent_pid) {
+		cerr << "Class-discovery worker " << worker_id
+			 << ": the calling process is gone, exiting" << endl;
+		_exit(-1);
+	}
+}
+
+/* *********************************************************************
+	Kills the workers that are still running
+ ******************************************************************* */
+static void kill_workers(vector<pid_t>& worker_pids) {
+	for (unsigned int w = 0; w < worker_pids.size(); w++) {
+		if (worker_pids[w] != 0) {
+			kill(worker_pids[w], SIGKILL);
+			int status;
+			waitpid(worker_pids[w], &status, 0);
+			worker_pids[w] = 0;
+		}
+	}
+}
+
+/* *********************************************************************
+	Waits for the given worker, and checks all the other workers while
+	waiting: a worker can wait for its siblings, so any of them failing
+	would block it. When a worker failed, kills the other workers and
+	exits
+ ******************************************************************* */
+static void wait_for_worker(vector<pid_t>& worker_pids, int worker_id) {
+	while (worker_pids[worker_id] != 0) {
+		for (unsigned int w = 0; w < worker_pids.size(); w++) {
+			if (worker_pids[w] == 0) {
+				continue;
+			}
+			int status;
+			pid_t pid = waitpid(worker_pids[w], &status, WNOHANG);
+			if (pid == 0) {
+				continue;	// still running
+			}
+			worker_pids[w] = 0;
+			if (pid == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				cerr << "Class-discovery worker " << w << " failed";
+				if (pid != -1 && WIFSIGNALED(status)) {
+					cerr << " (signal " << WTERMSIG(status) << ")";
+				}
+				cerr << endl;
+				kill_workers(worker_pids);
+				exit(-1);
+			}
+		}
+		if (worker_pids[worker_id] != 0) {
+			usleep(WORKER_POLL_USECS);
+		}
+	}
+}
+
+/* *********************************************************************
+	Advances the check of the early stopping of the background
+	detection, over the frames that all the workers have summarized
+	(and up to last_frame). checked_frame is the last checked frame, and
+	stable_counter the number of frames since the last change of the
+	most frequent colors, as in BackgroundDetector::is_estimate_stable.
+	Returns the frame on which the detection stops, or -1
+ ******************************************************************* */
+static int check_bg_stable(volatile int* progress, const uInt8* changed,
+						   int num_workers, int num_frames,
+						   int stable_frames_num, int last_frame,
+						   int& checked_frame, int& stable_counter) {
+	while (checked_frame < last_frame) {
+		int frame = checked_frame + 1;
+		for (int w = 0; w < num_workers; w++) {
+			if (progress[w] < frame) {
+				return -1;	// not summarized by all the workers yet
+			}
+		}
+		__sync_synchronize();	// read the flags after seeing the progress
+		bool is_changed = false;
+		for (int w = 0; w < num_workers; w++) {
+			if (changed[w * (num_frames + 1) + frame]) {
+				is_changed = true;
+			}
+		}
+		checked_frame = frame;
+		if (is_changed) {
+			stable_counter = 0;
+		} else {
+			stable_counter++;
+		}
+		if (stable_counter >= stable_frames_num) {
+			return frame;
+		}
+	}
+	return -1;
+}
+
+/* *********************************************************************
+	The background worker: summarizes the colors of the rows
+	[first_row, end_row) of the first num_frames recorded frames, and
+	writes the most frequent colors of these rows to bg_modes.
+	When the early stopping is used, the worker publishes, for each
+	frame, whether the most frequent colors of its rows changed, and
+	stops on the first frame after which no worker has seen a change for
+	bg_detect_stable_frames frames. The frames on which this is decided
+	can be behind the frames the worker summarized, so the worker keeps
+	the changes of its colors until it is decided, and undoes the ones
+	after the stop frame. The worker also writes the number of frames
+	it read and the stop frame (-1 when none) to its results.
+	The calling process (parent_pid) kills the workers when one of them
+	fails, and the workers exit when it is gone
+ ******************************************************************* */
+static void run_bg_worker(OSystem* osystem, const string& frames_file,
+						  pid_t parent_pid, int worker_id, int num_workers,
+						  int first_row, int end_row, int num_frames,
+						  int stable_frames_num, volatile int* progress,
+						  uInt8* changed, uInt8* bg_modes, int* results) {
+	BackgroundDetector detector(osystem, NULL);
+	detector.set_row_range(first_row, end_row);
+	FrameReader reader(frames_file);
+	int width = reader.get_width();
+	vector< pair<int, uInt8> > frame_changes;
+	deque<ModeChange> mode_changes;
+	int checked_frame = 0;
+	int stable_counter = 0;
+	int stop_frame = -1;
+	int num_read = 0;
+	while (num_read < num_frames && stop_frame < 0) {
+		if (!reader.read_frame()) {
+			break;
+		}
+		num_read++;
+		detector.count_screen(reader.get_colors());
+		if (stable_frames_num <= 0 || num_read == num_frames) {
+			continue;
+		}
+		// Publish the changes of our colors, and check the early stopping
+		frame_changes.clear();
+		changed[worker_id * (num_frames + 1) + num_read] =
+									detector.update_modes(&frame_changes);
+		__sync_synchronize();	// the flag is set before we publish it
+		progress[worker_id] = num_read;
+		for (unsigned int i = 0; i < frame_changes.size(); i++) {
+			ModeChange change;
+			change.frame = num_read;
+			change.pixel = frame_changes[i].first;
+			change.prev_mode = frame_changes[i].second;
+			mode_changes.push_back(change);
+		}
+		do {
+			stop_frame = check_bg_stable(progress, changed, num_workers,
+									num_frames, stable_frames_num, num_read,
+									checked_frame, stable_counter);
+			if (stop_frame < 0 &&
+				num_read - checked_frame >= BG_MAX_WORKER_LEAD) {
+				check_calling_process(parent_pid, worker_id);
+				usleep(BG_WORKER_IDLE_USECS);
+			}
+		} while (stop_frame < 0 &&
+				 num_read - checked_frame >= BG_MAX_WORKER_LEAD);
+		// The detection goes on after the checked frames
+		while (stop_frame < 0 && !mode_changes.empty() &&
+			   mode_changes.front().frame <= checked_frame) {
+			mode_changes.pop_front();
+		}
+	}
+	// The slower workers can still stop the detection on a frame we read
+	int last_checked_frame = min(num_read, num_frames - 1);
+	while (stable_frames_num > 0 && stop_frame < 0 &&
+		   checked_frame < last_checked_frame) {
+		stop_frame = check_bg_stable(progress, changed, num_workers,
+								num_frames, stable_frames_num,
+								last_checked_frame, checked_frame,
+								stable_counter);
+		if (stop_frame < 0 && checked_frame < last_checked_frame) {
+			check_calling_process(parent_pid, worker_id);
+			usleep(BG_WORKER_IDLE_USECS);
+		}
+	}
+	if (stop_frame < 0) {
+		detector.update_modes();
+	}
+	for (int p = first_row * width; p < end_row * width; p++) {
+		bg_modes[p] = detector.get_mode(p);
+	}
+	// Undo the changes of our colors after the stop frame
+	while (stop_frame >= 0 && !mode_changes.empty() &&
+		   mode_changes.back().frame > stop_frame) {
+		bg_modes[mode_changes.back().pixel] = mode_changes.back().prev_mode;
+		mode_changes.pop_back();
+	}
+	results[0] = num_read;
+	results[1] = stop_frame;
+}
+
+/* *********************************************************************
+	Runs the background detection on the recorded frames, and saves the
+	background as BackgroundDetector does, with the same result
+ ******************************************************************* */
+void detect_background_offline(OSystem* osystem, const string& frames_file,
+							   int num_workers) {
+	Settings& settings = osystem->settings();
+	int num_frames = settings.getInt("bg_detect_frames_num", true);
+	int stable_frames_num = settings.getInt("bg_detect_stable_frames", true);
+	MediaSource& mediasrc = osystem->console().mediaSource();
+	int height = mediasrc.height();
+	int width = mediasrc.width();
+	num_workers = min(num_workers, height);
+	// The progress and the results of the workers, the colors of the 
+	// background, and the changed flags (one per worker and frame)
+	size_t ints_bytes = 3 * num_workers * sizeof(int);
+	size_t shared_bytes = ints_bytes + height * width + 
+						  num_workers * (num_frames + 1);
+	char* shared = (char*)map_shared(shared_bytes);
+	volatile int* progress = (volatile int*)shared;
+	int* results = (int*)shared + num_workers;
+	uInt8* bg_modes = (uInt8*)(shared + ints_bytes);
+	uInt8* changed = bg_modes + height * width;
+	cout << "Detecting the background of " << frames_file << " in "
+		 << num_workers << " processes..." << endl;
+	pid_t parent_pid = getpid();
+	vector<pid_t> worker_pids;
+	for (int w = 0; w < num_workers; w++) {
+		int first_row = w * height / num_workers;
+		int end_row = (w + 1) * height / num_workers;
+		pid_t pid = fork_worker(w);
+		if (pid == 0) {
+			run_bg_worker(osystem, frames_file, parent_pid, w, num_workers,
+						  first_row, end_row, num_frames, stable_frames_num,
+						  progress, changed, bg_modes, results + 2 * w);
+			end_worker();
+		}
+		worker_pids.push_back(pid);
+	}
+	for (int w = 0; w < num_workers; w++) {
+		wait_for_worker(worker_pids, w);
+	}
+	int num_read = results[0];
+	int stop_frame = results[1];
+	if (num_read == 0) {
+		cerr << "The recording " << frames_file << " has no frames" << endl;
+		exit(-1);
+	}
+	if (stop_frame > 0) {
+		cout << "Background unchanged for " << stable_frames_num
+			 << " frames, stopping after " << stop_frame << " frames."
+			 << endl;
+	} else if (num_read < num_frames) {
+		cout << "Warning: the recording has only " << num_read
+			 << " frames (bg_detect_frames_num is " << num_frames
+			 << "). The background is detected on these frames" << endl;
+	}
+	IntMatrix* pm_background = new IntMatrix(height, IntVect(width, 0));
+	for (int i = 0; i < height; i++) {
+		for (int j = 0; j < width; j++) {
+			(*pm_background)[i][j] = bg_modes[i * width + j];
+		}
+	}
+	BackgroundDetector detector(osystem, NULL);
+	detector.save_background(pm_background);
+	delete pm_background;
+	munmap(shared, shared_bytes);
+	cout << "Background Detection Complete." << endl;
+}
+
+/* *********************************************************************
+	Returns the name of the objects file of the given worker
+ ******************************************************************* */
+static string objects_filename(int worker_id) {
+	ostringstream filename;
+	filename << "class_disc_objects__worker_" << worker_id << ".bin";
+	return filename.str();
+}
+
+/* *********************************************************************
+	Writes the objects of a screen to the given file
+ ******************************************************************* */
+static void write_screen_objects(FILE* file, int frame_number,
+								 const RegionObjectList* objects) {
+	int header[2] = {frame_number, (int)objects->size()};
+	fwrite(header, sizeof(int), 2, file);
+	vector<uInt8> shape;
+	for (unsigned int i = 0; i < objects->size(); i++) {
+		const RegionObject* obj = (*objects)[i];
+		int fields[7] = {obj->i_region_number, obj->i_center_x,
+						 obj->i_center_y, obj->i_velocity_x,
+						 obj->i_velocity_y, obj->i_width, obj->i_height};
+		fwrite(fields, sizeof(int), 7, file);
+		shape.clear();
+		for (int y = 0; y < obj->i_height; y++) {
+			for (int x = 0; x < obj->i_width; x++) {
+				shape.push_back((*obj->pm_shape_matrix)[y][x]);
+			}
+		}
+		fwrite(&shape[0], 1, shape.size(), file);
+	}
+}
+
+/* *********************************************************************
+	Reads the objects of the next screen of the given file. Returns
+	false at the end of the file
+ ******************************************************************* */
+static bool read_screen_objects(FILE* file, int& frame_number,
+								RegionObjectList* objects) {
+	int header[2];
+	if (fread(header, sizeof(int), 2, file) != 2) {
+		return false;
+	}
+	frame_number = header[0];
+	vector<uInt8> shape;
+	for (int i = 0; i < header[1]; i++) {
+		int fields[7];
+		if (fread(fields, sizeof(int), 7, file) != 7) {
+			cerr << "The objects of frame " << frame_number
+				 << " are truncated" << endl;
+			exit(-1);
+		}
+		RegionObject* obj = new RegionObject();
+		obj->i_region_number = fields[0];
+		obj->i_center_x = fields[1];
+		obj->i_center_y = fields[2];
+		obj->i_velocity_x = fields[3];
+		obj->i_velocity_y = fields[4];
+		obj->i_width = fields[5];
+		obj->i_height = fields[6];
+		shape.resize(obj->i_width * obj->i_height);
+		if (fread(&shape[0], 1, shape.size(), file) != shape.size()) {
+			cerr << "The objects of frame " << frame_number
+				 << " are truncated" << endl;
+			exit(-1);
+		}
+		obj->pm_shape_matrix = new IntMatrix(obj->i_height,
+											 IntVect(obj->i_width, 0));
+		for (int y = 0; y < obj->i_height; y++) {
+			for (int x = 0; x < obj->i_width; x++) {
+				(*obj->pm_shape_matrix)[y][x] = shape[y * obj->i_width + x];
+			}
+		}
+		obj->calc_signature();
+		obj->b_is_valid = true;
+		objects->push_back(obj);
+	}
+	return true;
+}
+
+/* *********************************************************************
+	The class-discovery worker: extracts the objects of the screens
+	[first_screen, end_screen) (counted from the first screen used by
+	the class discovery) and writes them to its objects file. The
+	screen before first_screen is extracted too, for the velocities
+ ******************************************************************* */
+static void run_objects_worker(OSystem* osystem, const string& frames_file,
+							   int worker_id, int first_screen,
+							   int end_screen) {
+	FrameReader reader(frames_file);
+	int height = reader.get_height();
+	int width = reader.get_width();
+	IntMatrix* pm_background = new IntMatrix;
+	import_matrix(pm_background, "background_matrix.txt");
+	ScreenPlanes* screen_planes = new ScreenPlanes(height, width);
+	screen_planes->set_background(pm_background);
+	screen_planes->use_parts(FORGROUND_PLANE);
+	RegionManager* region_manager = new RegionManager(osystem, pm_background);
+	IntMatrix* pm_screen = new IntMatrix(height, IntVect(width, 0));
+	FILE* file = fopen(objects_filename(worker_id).c_str(), "wb");
+	if (file == NULL) {
+		cerr << "Cannot create " << objects_filename(worker_id) << endl;
+		exit(-1);
+	}
+	int screen_num = -1;
+	while (reader.read_frame()) {
+		// every frame is read, so only the changed rows need a copy
+		reader.get_screen_matrix(pm_screen, true);
+		int frame_number = reader.get_frame_number();
+		if (frame_number < CLS_DISC_FIRST_FRAME) {
+			continue;
+		}
+		screen_num++;
+		if (screen_num < first_screen - 1) {
+			continue;
+		}
+		if (screen_num >= end_screen) {
+			break;
+		}
+		screen_planes->set_screen(pm_screen);
+		const RegionObjectList* objects =
+				region_manager->extract_objects_from_new_screen(screen_planes,
+															frame_number);
+		if (screen_num >= first_screen) {
+			write_screen_objects(file, frame_number, objects);
+		}
+	}
+	fclose(file);
+	delete pm_screen;
+	delete region_manager;
+	delete screen_planes;
+	delete pm_background;
+}
+
+/* *********************************************************************
+	Runs the class discovery on the recorded frames, and exports the
+	classes as ClassDiscovery does, with the same result
+ ******************************************************************* */
+void discover_classes_offline(OSystem* osystem, const string& frames_file,
+							  int num_workers) {
+	// get_new_screen uses the screens 0 to cls_disc_frames_num
+	int num_screens = osystem->settings().getInt("cls_disc_frames_num",
+												 true) + 1;
+	num_workers = max(1, min(num_workers, num_screens));
+	MediaSource& mediasrc = osystem->console().mediaSource();
+	ScreenPlanes* screen_planes = new ScreenPlanes(mediasrc.height(),
+												   mediasrc.width());
+	ClassDiscovery* class_discovery = new ClassDiscovery(osystem,
+														 screen_planes);
+	cout << "Extracting the objects of " << frames_file << " in "
+		 << num_workers << " processes..." << endl;
+	vector<pid_t> worker_pids;
+	for (int w = 0; w < num_workers; w++) {
+		int first_screen = (int)((long long)w * num_screens / num_workers);
+		int end_screen = (int)((long long)(w + 1) * num_screens / num_workers);
+		pid_t pid = fork_worker(w);
+		if (pid == 0) {
+			run_objects_worker(osystem, frames_file, w, first_screen,
+							   end_screen);
+			end_worker();
+		}
+		worker_pids.push_back(pid);
+	}
+	// Add the objects to the classes, in order, as the workers finish
+	RegionObjectList* prev_objects = NULL;
+	RegionObjectList* curr_objects = NULL;
+	bool is_complete = false;
+	int num_done_workers = 0;	// the workers whose objects we added
+	for (int w = 0; w < num_workers && !is_complete; w++) {
+		wait_for_worker(worker_pids, w);
+		num_done_workers++;
+		FILE* file = fopen(objects_filename(w).c_str(), "rb");
+		if (file == NULL) {
+			cerr << "Cannot open " << objects_filename(w) << endl;
+			exit(-1);
+		}
+		while (!is_complete) {
+			RegionObjectList* objects = new RegionObjectList;
+			int frame_number;
+			if (!read_screen_objects(file, frame_number, objects) ||
+				!class_discovery->is_screen_needed(frame_number)) {
+				delete objects;
+				break;
+			}
+			// The previous objects are still used by this screen
+			if (prev_objects) {
+				clear_list_of_pointers(prev_objects);
+				delete prev_objects;
+			}
+			prev_objects = curr_objects;
+			curr_objects = objects;
+			class_discovery->add_screen_objects(curr_objects, frame_number);
+			is_complete = class_discovery->is_class_discovery_complete() ||
+						  !class_discovery->is_screen_needed(frame_number);
+		}
+		fclose(file);
+		remove(objects_filename(w).c_str());
+	}
+	// The remaining workers extract objects that are no longer needed
+	kill_workers(worker_pids);
+	for (int w = num_done_workers; w < num_workers; w++) {
+		remove(objects_filename(w).c_str());
+	}
+	if (is_complete) {
+		cout << "Class Discovery Complete." << endl;
+	} else {
+		cout << "Warning: the recording ended before the class discovery "
+			 << "was complete (cls_disc_frames_num is " << num_screens - 1
+			 << "). No classes were exported" << endl;
+	}
+	delete class_discovery;
+	delete screen_planes;
+	for (int l = 0; l < 2; l++) {
+		RegionObjectList* objects = (l == 0) ? prev_objects : curr_objects;
+		if (objects) {
+			clear_list_of_pointers(objects);
+			delete objects;
+		}
+	}
+}
@@ -0,0 +1,51 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  offline_class_discovery.h
+ *
+ *  Functions that run the background detection and the class discovery on a
+ *  recording of frames (see FrameRecorder), in several processes
+ **************************************************************************** */
+
+#ifndef OFFLINE_CLASS_DISCOVERY_H
+#define OFFLINE_CLASS_DISCOVERY_H
+
+#include "common_constants.h"
+#include "OSystem.hxx"
+
+/* *************************************************************************
+	Returns the number of processes to use (class_disc_num_workers, or
+	the number of cores when it is 0)
+ ************************************************************************* */
+int get_class_disc_num_workers(OSystem* osystem);
+
+/* *************************************************************************
+	Runs the background detection on the recorded frames, and saves the
+	background as BackgroundDetector does, with the same result. Each
+	process summarizes the colors of a band of rows of the screen. When
+	bg_detect_stable_frames is positive, the processes share the frames
+	in which the colors of their band changed, so that they all stop on
+	the frame on which one BackgroundDetector would have stopped
+ ************************************************************************* */
+void detect_background_offline(OSystem* osystem, const string& frames_file,
+							   int num_workers);
+
+/* *************************************************************************
+	Runs the class discovery on the recorded frames (using the saved
+	background), and exports the classes as ClassDiscovery does, with
+	the same result. The screens are split in ranges of consecutive
+	frames, and each process extracts the objects of one range (the
+	objects of a screen only depend on the screen and the one before
+	it). The objects are then assigned to the classes, in order, by the
+	calling process
+ ************************************************************************* */
+void discover_classes_offline(OSystem* osystem, const string& frames_file,
+							  int num_workers);
+
+#endif
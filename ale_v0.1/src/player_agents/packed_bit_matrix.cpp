@@ -0,0 +1,139 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  packed_bit_matrix.cpp
+ *
+ *  Implementation of the PackedBitMatrix class, a binary matrix stored as
+ *  rows of 64-bit words, used to match the class shapes against the
+ *  foreground of the screen a whole row-word at a time
+ **************************************************************************** */
+
+#include "packed_bit_matrix.h"
+
+/* *********************************************************************
+    Constructor: an all-zero matrix
+ ******************************************************************** */
+PackedBitMatrix::PackedBitMatrix(int height, int width) :
+    i_height(height),
+    i_width(width) {
+    i_words_per_row = (width + BITS_PER_WORD - 1) / BITS_PER_WORD + 1;
+    v_words.assign(i_height * i_words_per_row, 0);
+}
+
+/* *********************************************************************
+    Constructor: packs the given matrix (non-zero entries are 1)
+ ******************************************************************** */
+PackedBitMatrix::PackedBitMatrix(const IntMatrix* matrix) {
+    i_height = matrix->size();
+    i_width = i_height > 0 ? (*matrix)[0].size() : 0;
+    i_words_per_row = (i_width + BITS_PER_WORD - 1) / BITS_PER_WORD + 1;
+    v_words.assign(i_height * i_words_per_row, 0);
+    for (int y = 0; y < i_height; y++) {
+        for (int x = 0; x < i_width; x++) {
+            if ((*matrix)[y][x] != 0) {
+                set_bit(y, x);
+            }
+        }
+    }
+}
+
+/* *********************************************************************
+    Sets all the bits to 0
+ ******************************************************************** */
+void PackedBitMatrix::clear_all(void) {
+    v_words.assign(v_words.size(), 0);
+}
+
+/* *********************************************************************
+    Keeps the positions (bit i is the top-left corner (y, x + i)) where
+    the whole shape matches, comparing all of them together, one pixel of
+    the shape at a time (one shift, XOR and AND), until no position is 
+    left
+ ******************************************************************** */
+BitWord PackedBitMatrix::filter_positions(const PackedBitMatrix& shape, 
+                                          int y, int x, 
+                                          BitWord positions) const {
+    int first_word = x / BITS_PER_WORD;
+    for (int row = 0; row < shape.i_height && positions != 0; row++) {
+        const BitWord* screen_row = &v_words[(y + row) * i_words_per_row + 
+                                             first_word];
+        const BitWord* shape_row = &shape.v_words[row * shape.i_words_per_row];
+        for (int col = 0; col < shape.i_width && positions != 0; col++) {
+            int ind = col / BITS_PER_WORD;
+            int shift = col % BITS_PER_WORD;
+            // bit i of pixels is the pixel under (row, col) of the shape, 
+            // when it is placed at (y, x + i). (The second shift is split 
+            // in two, so that it is never by 64)
+            BitWord pixels = (screen_row[ind] >> shift) | 
+                    ((screen_row[ind + 1] << 1) << (BITS_PER_WORD - 1 - shift));
+            BitWord shape_pixel = 0 - ((shape_row[ind] >> shift) & 1);
+            positions &= ~(pixels ^ shape_pixel);
+        }
+    }
+    return positions;
+}
+
+/* *********************************************************************
+    Returns the number of entries where the given shape differs from the
+    sub-matrix with its top-left corner at (y, x), one XOR and popcount 
+    per word of each row of the shape. The shape must fit in the matrix 
+    at (y, x).
+    When max_distance is not negative, stops as soon as the distance is
+    above it (and returns the distance so far)
+ ******************************************************************** */
+int PackedBitMatrix::get_window_distance(const PackedBitMatrix& shape, 
+                                         int y, int x, 
+                                         int max_distance) const {
+    assert(y + shape.i_height <= i_height && x + shape.i_width <= i_width);
+    int num_words = (shape.i_width + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    // the bits of the last word beyond the shape are not compared
+    BitWord last_mask = low_bits_mask(shape.i_width - 
+                                      (num_words - 1) * BITS_PER_WORD);
+    int shift = x % BITS_PER_WORD;
+    const BitWord* screen_row = &v_words[y * i_words_per_row + 
+                                         x / BITS_PER_WORD];
+    const BitWord* shape_row = &shape.v_words[0];
+    if (max_distance < 0) {
+        max_distance = shape.i_height * shape.i_width;
+    }
+    int distance = 0;
+    for (int row = 0; row < shape.i_height && distance <= max_distance; 
+                                                                    row++) {
+        // (the second shift is split in two, so that it is never by 64)
+        for (int w = 0; w < num_words; w++) {
+            BitWord bits = (screen_row[w] >> shift) | 
+                    ((screen_row[w + 1] << 1) << (BITS_PER_WORD - 1 - shift));
+            BitWord diff = bits ^ shape_row[w];
+            if (w == num_words - 1) {
+                diff &= last_mask;
+            }
+            distance += count_bits(diff);
+        }
+        screen_row += i_words_per_row;
+        shape_row += shape.i_words_per_row;
+    }
+    return distance;
+}
+
+/* *********************************************************************
+    Sets to 0 the bits of the given rectangle
+ ******************************************************************** */
+void PackedBitMatrix::clear_rect(int y, int x, int height, int width) {
+    int first_word = x / BITS_PER_WORD;
+    int last_word = (x + width - 1) / BITS_PER_WORD;
+    for (int w = first_word; w <= last_word; w++) {
+        // the columns of the rectangle that fall in word w
+        int start = max(x, w * BITS_PER_WORD) - w * BITS_PER_WORD;
+        int end = min(x + width, (w + 1) * BITS_PER_WORD) - w * BITS_PER_WORD;
+        BitWord keep = ~(low_bits_mask(end - start) << start);
+        for (int row = y; row < y + height; row++) {
+            v_words[row * i_words_per_row + w] &= keep;
+        }
+    }
+}
@@ -0,0 +1,153 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  packed_bit_matrix.h
+ *
+ *  Implementation of the PackedBitMatrix class, a binary matrix stored as
+ *  rows of 64-bit words, used to match the class shapes against the
+ *  foreground of the screen a whole row-word at a time
+ **************************************************************************** */
+
+#ifndef PACKED_BIT_MATRIX_H
+#define PACKED_BIT_MATRIX_H
+
+#include "common_constants.h"
+#include "bit_pair_tools.h"
+
+class PackedBitMatrix {
+    /* *************************************************************************
+        A binary matrix, where bit (x % 64) of word (x / 64) of row y holds
+		the (y, x) entry.
+        Each row has one extra zero word at the end, so that the 64 bits
+		starting at any column can be read without checking the row bounds
+		(the bits beyond the width read as 0)
+    ************************************************************************* */
+
+    public:
+        /* *********************************************************************
+            Constructor: an all-zero matrix
+         ******************************************************************** */
+        PackedBitMatrix(int height, int width);
+
+        /* *********************************************************************
+            Constructor: packs the given matrix (non-zero entries are 1)
+         ******************************************************************** */
+        PackedBitMatrix(const IntMatrix* matrix);
+
+        /* *********************************************************************
+            Sets all the bits to 0
+         ******************************************************************** */
+        void clear_all(void);
+
+        inline void set_bit(int y, int x) {
+            v_words[y * i_words_per_row + x / BITS_PER_WORD] |=
+                                        (BitWord)1 << (x % BITS_PER_WORD);
+        }
+
+        /* *********************************************************************
+            Sets the 64 bits of row y starting at column (64 * word_ind).
+            The bits beyond the width must be 0
+         ******************************************************************** */
+        inline void set_word(int y, int word_ind, BitWord word) {
+            v_words[y * i_words_per_row + word_ind] = word;
+        }
+
+        inline void or_word(int y, int word_ind, BitWord word) {
+            v_words[y * i_words_per_row + word_ind] |= word;
+        }
+
+        inline bool get_bit(int y, int x) const {
+            return (v_words[y * i_words_per_row + x / BITS_PER_WORD] >>
+                                                (x % BITS_PER_WORD)) & 1;
+        }
+
+        /* *********************************************************************
+            Returns the 64 bits of row y starting at column x (bit 0 of the
+            result is the (y, x) entry)
+         ******************************************************************** */
+        inline BitWord get_bits(int y, int x) const {
+            const BitWord* row = &v_words[y * i_words_per_row];
+            int ind = x / BITS_PER_WORD;
+            int shift = x % BITS_PER_WORD;
+            if (shift == 0) {
+                return row[ind];
+            }
+            return (row[ind] >> shift) |
+                   (row[ind + 1] << (BITS_PER_WORD - shift));
+        }
+
+        /* *********************************************************************
+            Returns the positions, among the 64 top-left corners (y, x) to
+            (y, x + 63), where the sub-matrix is equal to the given shape:
+            bit i of the result is set when the shape matches at (y, x + i).
+            All the 64 positions are compared together, one pixel of the 
+            shape at a time (one shift, XOR and AND), starting with the 1 at
+            (0, first_one_col) of the shape, and stopping as soon as no 
+            position is left. Only the positions where the shape fits in the
+            width of the matrix are returned. x must be a multiple of 64, 
+            and the shape must fit in the height of the matrix at row y
+         ******************************************************************** */
+        inline BitWord match_positions(const PackedBitMatrix& shape, 
+                                       int y, int x, int first_one_col) const {
+            assert(x % BITS_PER_WORD == 0);
+            int num_positions = i_width - shape.i_width - x + 1;
+            if (num_positions <= 0) {
+                return 0;
+            }
+            // Most of the positions are rejected here, by the anchor pixel
+            BitWord positions = get_bits(y, x + first_one_col) & 
+                                low_bits_mask(num_positions);
+            if (positions == 0) {
+                return 0;
+            }
+            return filter_positions(shape, y, x, positions);
+        }
+
+        /* *********************************************************************
+            Sets to 0 the bits of the given rectangle
+         ******************************************************************** */
+        void clear_rect(int y, int x, int height, int width);
+
+        /* *********************************************************************
+            Returns the number of entries where the given shape differs from
+            the sub-matrix with its top-left corner at (y, x), one XOR and 
+            popcount per word of each row of the shape. The shape must fit
+            in the matrix at (y, x).
+            When max_distance is not negative, stops as soon as the distance
+            is above it (and returns the distance so far)
+         ******************************************************************** */
+        int get_window_distance(const PackedBitMatrix& shape, int y, int x,
+                                int max_distance = -1) const;
+
+        int get_height(void) const {return i_height;}
+        int get_width(void) const {return i_width;}
+
+    protected:
+        /* *********************************************************************
+            Keeps the positions (bit i is the top-left corner (y, x + i)) where
+            the whole shape matches
+         ******************************************************************** */
+        BitWord filter_positions(const PackedBitMatrix& shape, int y, int x,
+                                 BitWord positions) const;
+
+        /* *********************************************************************
+            Returns the mask of the given number of low bits (1 to 64)
+         ******************************************************************** */
+        static inline BitWord low_bits_mask(int num_bits) {
+            return num_bits >= BITS_PER_WORD ? ~(BitWord)0 :
+                                        ((BitWord)1 << num_bits) - 1;
+        }
+
+        int i_height;
+        int i_width;
+        int i_words_per_row;    // Including the extra zero word
+        BitWordVect v_words;
+};
+
+#endif
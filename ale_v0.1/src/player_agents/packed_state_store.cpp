@@ -0,0 +1,295 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  packed_state_store.cpp
+ *
+ *  Implementation of the PackedStateStore class, which keeps serialized
+ *  emulator states back to back in one memory buffer, and spills the overflow
+ *  to a memory-mapped file
+ **************************************************************************** */
+
+#include "packed_state_store.h"
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define SPILL_GROW_BYTES (16 * 1024 * 1024)	// The spill file grows in
+											// chunks of this size
+
+/* *********************************************************************
+	Orders handles by the offset of their entries
+ ******************************************************************* */
+struct EntryOffsetLess {
+	const vector<PackedStateStore::StateEntry>* p_entries;
+	bool operator()(int a, int b) const {
+		return (*p_entries)[a].offset < (*p_entries)[b].offset;
+	}
+};
+
+/* *********************************************************************
+	Constructor
+	A max_spill_bytes of 0 disables spilling to disk
+ ******************************************************************* */
+PackedStateStore::PackedStateStore(long long max_mem_bytes,
+								   long long max_spill_bytes,
+								   const string& spill_file) :
+	i_max_mem_bytes(max_mem_bytes),
+	i_max_spill_bytes(max_spill_bytes),
+	s_spill_file(spill_file),
+	i_mem_used(0),
+	i_spill_used(0),
+	i_released_mem(0),
+	i_released_spill(0),
+	i_spill_fd(-1),
+	p_spill_map(NULL),
+	i_spill_mapped(0),
+	i_num_live(0) {
+}
+
+/* *********************************************************************
+	Deconstructor
+ ******************************************************************* */
+PackedStateStore::~PackedStateStore() {
+	if (p_spill_map != NULL) {
+		munmap(p_spill_map, i_spill_mapped);
+	}
+	if (i_spill_fd != -1) {
+		close(i_spill_fd);
+	}
+}
+
+/* *********************************************************************
+	Returns true if a state of the given size can still be stored
+ ******************************************************************* */
+bool PackedStateStore::has_room(int num_bytes) const {
+	// released bytes are reclaimed by pack(), before put() gives up
+	return (i_mem_used - i_released_mem + num_bytes <= i_max_mem_bytes ||
+			i_spill_used - i_released_spill + num_bytes <= i_max_spill_bytes);
+}
+
+/* *********************************************************************
+	Stores the given state and returns its handle
+ ******************************************************************* */
+int PackedStateStore::put(const string& state) {
+	int length = state.size();
+	if (i_mem_used + length > i_max_mem_bytes) {
+		// Reclaim the released bytes of the memory buffer before spilling,
+		// and those of the spill file before giving up
+		if (i_released_mem > 0 &&
+			i_mem_used - i_released_mem + length <= i_max_mem_bytes) {
+			pack();
+		} else if (i_spill_used + length > i_max_spill_bytes &&
+				   i_released_mem + i_released_spill > 0) {
+			pack();
+		}
+	}
+	StateEntry entry;
+	entry.length = length;
+	entry.live = true;
+	if (i_mem_used + length <= i_max_mem_bytes) {
+		entry.in_memory = true;
+		entry.offset = i_mem_used;
+		reserve_mem(i_mem_used + length);
+		memcpy(&v_mem_buffer[entry.offset], state.data(), length);
+		i_mem_used += length;
+	} else {
+		if (i_spill_used + length > i_max_spill_bytes) {
+			cerr << "PackedStateStore: out of room for a state of "
+				 << length << " bytes" << endl;
+			exit(-1);
+		}
+		reserve_spill(i_spill_used + length);
+		entry.in_memory = false;
+		entry.offset = i_spill_used;
+		memcpy(p_spill_map + entry.offset, state.data(), length);
+		i_spill_used += length;
+	}
+	int handle;
+	if (!v_free_handles.empty()) {
+		handle = v_free_handles.back();
+		v_free_handles.pop_back();
+		v_entries[handle] = entry;
+	} else {
+		handle = v_entries.size();
+		v_entries.push_back(entry);
+	}
+	i_num_live++;
+	return handle;
+}
+
+/* *********************************************************************
+	Returns the state stored under the given handle
+ ******************************************************************* */
+string PackedStateStore::get(int handle) const {
+	const StateEntry& entry = v_entries[handle];
+	assert(entry.live);
+	return string(entry_data(entry), entry.length);
+}
+
+/* *********************************************************************
+	Marks the given handle as no longer used
+ ******************************************************************* */
+void PackedStateStore::release(int handle) {
+	StateEntry& entry = v_entries[handle];
+	assert(entry.live);
+	entry.live = false;
+	if (entry.in_memory) {
+		i_released_mem += entry.length;
+	} else {
+		i_released_spill += entry.length;
+	}
+	v_free_handles.push_back(handle);
+	i_num_live--;
+}
+
+/* *********************************************************************
+	Releases every handle that is not in live_handles, and packs the
+	remaining states to the front of the buffers. Handles stay valid.
+ ******************************************************************* */
+void PackedStateStore::compact(const IntVect& live_handles) {
+	BitArr keep(false, v_entries.size());
+	for (unsigned int i = 0; i < live_handles.size(); i++) {
+		keep[live_handles[i]] = true;
+	}
+	for (unsigned int h = 0; h < v_entries.size(); h++) {
+		if (v_entries[h].live && !keep[h]) {
+			release(h);
+		}
+	}
+	pack();
+}
+
+/* *********************************************************************
+	Releases all the stored states
+ ******************************************************************* */
+void PackedStateStore::clear(void) {
+	v_entries.clear();
+	v_free_handles.clear();
+	i_mem_used = 0;
+	i_spill_used = 0;
+	i_released_mem = 0;
+	i_released_spill = 0;
+	i_num_live = 0;
+}
+
+/* *********************************************************************
+	Moves the live states to the front of the memory buffer and the
+	spill file, reclaiming the space of the released states. The spilled
+	states that now fit in the memory buffer are moved back into it
+ ******************************************************************* */
+void PackedStateStore::pack(void) {
+	IntVect mem_handles, spill_handles;
+	for (unsigned int h = 0; h < v_entries.size(); h++) {
+		if (!v_entries[h].live) {
+			continue;
+		}
+		if (v_entries[h].in_memory) {
+			mem_handles.push_back(h);
+		} else {
+			spill_handles.push_back(h);
+		}
+	}
+	EntryOffsetLess offset_less;
+	offset_less.p_entries = &v_entries;
+	// Moving the entries in increasing offset order never overwrites an
+	// entry that has not been moved yet
+	sort(mem_handles.begin(), mem_handles.end(), offset_less);
+	sort(spill_handles.begin(), spill_handles.end(), offset_less);
+	i_mem_used = 0;
+	for (unsigned int i = 0; i < mem_handles.size(); i++) {
+		StateEntry& entry = v_entries[mem_handles[i]];
+		memmove(&v_mem_buffer[i_mem_used], &v_mem_buffer[entry.offset],
+				entry.length);
+		entry.offset = i_mem_used;
+		i_mem_used += entry.length;
+	}
+	i_spill_used = 0;
+	for (unsigned int i = 0; i < spill_handles.size(); i++) {
+		StateEntry& entry = v_entries[spill_handles[i]];
+		if (i_mem_used + entry.length <= i_max_mem_bytes) {
+			reserve_mem(i_mem_used + entry.length);
+			memcpy(&v_mem_buffer[i_mem_used], p_spill_map + entry.offset,
+				   entry.length);
+			entry.in_memory = true;
+			entry.offset = i_mem_used;
+			i_mem_used += entry.length;
+			continue;
+		}
+		memmove(p_spill_map + i_spill_used, p_spill_map + entry.offset,
+				entry.length);
+		entry.offset = i_spill_used;
+		i_spill_used += entry.length;
+	}
+	i_released_mem = 0;
+	i_released_spill = 0;
+}
+
+/* *********************************************************************
+	Makes sure the memory buffer can hold num_bytes (at most 
+	i_max_mem_bytes)
+ ******************************************************************* */
+void PackedStateStore::reserve_mem(long long num_bytes) {
+	if ((long long)v_mem_buffer.size() < num_bytes) {
+		long long new_size = max(num_bytes, 
+								 (long long)v_mem_buffer.size() * 2);
+		v_mem_buffer.resize(min(new_size, i_max_mem_bytes));
+	}
+}
+
+/* *********************************************************************
+	Makes sure the spill file is mapped and can hold num_bytes
+ ******************************************************************* */
+void PackedStateStore::reserve_spill(long long num_bytes) {
+	if (num_bytes <= i_spill_mapped) {
+		return;
+	}
+	if (i_spill_fd == -1) {
+		i_spill_fd = open(s_spill_file.c_str(), O_RDWR | O_CREAT | O_TRUNC,
+						  0600);
+		if (i_spill_fd == -1) {
+			cerr << "PackedStateStore: cannot open spill file "
+				 << s_spill_file << endl;
+			exit(-1);
+		}
+		// The file disappears from disk when we close it (or crash)
+		unlink(s_spill_file.c_str());
+	}
+	long long new_size = i_spill_mapped + SPILL_GROW_BYTES;
+	while (new_size < num_bytes) {
+		new_size += SPILL_GROW_BYTES;
+	}
+	if (ftruncate(i_spill_fd, new_size) != 0) {
+		cerr << "PackedStateStore: cannot grow the spill file to "
+			 << new_size << " bytes" << endl;
+		exit(-1);
+	}
+	if (p_spill_map != NULL) {
+		munmap(p_spill_map, i_spill_mapped);
+	}
+	void* map = mmap(NULL, new_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+					 i_spill_fd, 0);
+	if (map == MAP_FAILED) {
+		cerr << "PackedStateStore: cannot map the spill file" << endl;
+		exit(-1);
+	}
+	p_spill_map = (char*)map;
+	i_spill_mapped = new_size;
+}
+
+/* *********************************************************************
+	Returns a pointer to the first byte of the given entry
+ ******************************************************************* */
+const char* PackedStateStore::entry_data(const StateEntry& entry) const {
+	if (entry.in_memory) {
+		return &v_mem_buffer[entry.offset];
+	}
+	return p_spill_map + entry.offset;
+}
@@ -0,0 +1,129 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  packed_state_store.h
+ *
+ *  Implementation of the PackedStateStore class, which keeps serialized
+ *  emulator states back to back in one memory buffer, and spills the overflow
+ *  to a memory-mapped file
+ **************************************************************************** */
+
+#ifndef PACKED_STATE_STORE_H
+#define PACKED_STATE_STORE_H
+
+#include "common_constants.h"
+
+class PackedStateStore {
+    /* *************************************************************************
+        Stores serialized states in a packed memory buffer of at most
+		i_max_mem_bytes bytes. States that do not fit are appended to a
+		memory-mapped spill file of at most i_max_spill_bytes bytes.
+		Each stored state is referred to by an integer handle.
+    ************************************************************************* */
+
+    public:
+		/* *********************************************************************
+            Constructor
+			A max_spill_bytes of 0 disables spilling to disk
+         ******************************************************************* */
+		PackedStateStore(long long max_mem_bytes, long long max_spill_bytes,
+						 const string& spill_file);
+
+		/* *********************************************************************
+            Deconstructor
+         ******************************************************************* */
+		~PackedStateStore();
+
+		/* *********************************************************************
+            Returns true if a state of the given size can still be stored
+         ******************************************************************* */
+		bool has_room(int num_bytes) const;
+
+		/* *********************************************************************
+            Stores the given state and returns its handle
+         ******************************************************************* */
+		int put(const string& state);
+
+		/* *********************************************************************
+            Returns the state stored under the given handle
+         ******************************************************************* */
+		string get(int handle) const;
+
+		/* *********************************************************************
+            Marks the given handle as no longer used
+         ******************************************************************* */
+		void release(int handle);
+
+		/* *********************************************************************
+            Releases every handle that is not in live_handles, and packs the
+			remaining states to the front of the buffers. Handles stay valid.
+         ******************************************************************* */
+		void compact(const IntVect& live_handles);
+
+		/* *********************************************************************
+            Releases all the stored states
+         ******************************************************************* */
+		void clear(void);
+
+		/* *********************************************************************
+            Accessors
+         ******************************************************************* */
+		long long get_mem_bytes(void) const {return i_mem_used;}
+		long long get_spilled_bytes(void) const {return i_spill_used;}
+		int get_num_states(void) const {return i_num_live;}
+
+		struct StateEntry {
+			long long offset;	// Offset in the memory buffer or spill file
+			int length;			// Length of the state in bytes
+			bool in_memory;		// True if the state is in the memory buffer
+			bool live;			// False when the handle has been released
+		};
+
+	protected:
+		/* *********************************************************************
+            Moves the live states to the front of the memory buffer and the
+			spill file, reclaiming the space of the released states. The 
+			spilled states that now fit in the memory buffer are moved back
+         ******************************************************************* */
+		void pack(void);
+
+		/* *********************************************************************
+            Makes sure the memory buffer can hold num_bytes
+         ******************************************************************* */
+		void reserve_mem(long long num_bytes);
+
+		/* *********************************************************************
+            Makes sure the spill file is mapped and can hold num_bytes
+         ******************************************************************* */
+		void reserve_spill(long long num_bytes);
+
+		/* *********************************************************************
+            Returns a pointer to the first byte of the given entry
+         ******************************************************************* */
+		const char* entry_data(const StateEntry& entry) const;
+
+		long long i_max_mem_bytes;	// Maximum size of the memory buffer
+		long long i_max_spill_bytes;// Maximum size of the spill file
+		string s_spill_file;		// Path of the spill file
+		vector<char> v_mem_buffer;	// Packed in-memory states
+		long long i_mem_used;		// Bytes used in v_mem_buffer
+		long long i_spill_used;		// Bytes used in the spill file
+		long long i_released_mem;	// Bytes held by released handles in 
+									// the memory buffer
+		long long i_released_spill;	// Bytes held by released handles in 
+									// the spill file
+		int i_spill_fd;				// File descriptor of the spill file
+		char* p_spill_map;			// The mapped spill file
+		long long i_spill_mapped;	// Size of the mapped region
+		vector<StateEntry> v_entries;// One entry per handle
+		IntVect v_free_handles;		// Released handles, available for reuse
+		int i_num_live;				// Number of live states
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include "freeway_agent.h"
 #include "export_tools.h"
 #include "game_controller.h"
+#include "learning_workers.h"
 #include "random_tools.h"
 #include "vector_matrix_tools.h"
 #include "FSNode.hxx"
@@ -35,6 +36,10 @@ PlayerAgent::PlayerAgent(GameSettings* _game_settings, OSystem* _osystem) :
     pv_possible_actions = p_game_settings->pv_possible_actions;
     pm_curr_screen_matrix = NULL;
     pv_curr_console_ram = NULL;
+	MediaSource& mediasrc = p_osystem->console().mediaSource();
+	p_screen_planes = new ScreenPlanes(mediasrc.height(), mediasrc.width());
+	p_screen_changes = new ScreenChanges(p_osystem);
+	p_tia_objects = NULL;
     i_num_actions = p_game_settings->pv_possible_actions->size();
     cout << "num actions: " << i_num_actions << endl;
     e_episode_status = INITIAL_DELAY;
@@ -58,6 +63,9 @@ PlayerAgent::PlayerAgent(GameSettings* _game_settings, OSystem* _osystem) :
 	i_max_num_frames_per_episode = settings.getInt("max_num_frames_per_episode",
 													true);
 	i_init_act_explor_count = settings.getInt("init_act_explor_count", true);
+	b_write_learning_curve = uses_learning_workers(p_osystem);
+	i_curve_ticks = p_osystem->getTicks();
+	f_curve_seconds = 0;
 	b_minus_one_zero_reward = settings.getBool("minus_one_zero_reward", true);
 	b_end_game_with_score = settings.getBool("end_game_with_score", true);
     
@@ -70,17 +78,29 @@ PlayerAgent::PlayerAgent(GameSettings* _game_settings, OSystem* _osystem) :
 	b_do_bg_detection = settings.getBool("do_bg_detection", true);
 	if (b_do_bg_detection) {
 		cout << "Background-Detection Enabled" << endl;
-		p_background_detect = new BackgroundDetector(p_osystem);
+		p_background_detect = new BackgroundDetector(p_osystem, p_screen_planes);
 	} else {
 		p_background_detect = NULL;
 	}
+	if (settings.getBool("use_tia_objects", true)) {
+		cout << "TIA Object-Trace Enabled" << endl;
+		p_tia_objects = new TIAObjects(p_osystem);
+	}
 	b_do_class_disc = settings.getBool("do_class_disc", true);
 	if (b_do_class_disc) {
 		cout << "Class-Discovery Enabled" << endl;
-		p_class_dicovery = new ClassDiscovery(p_osystem);
+		p_class_dicovery = new ClassDiscovery(p_osystem, p_screen_planes);
 	} else {
 		p_class_dicovery = NULL;
 	}	
+	string record_file = settings.getString("record_frames_file", true);
+	if (record_file != "") {
+		cout << "Recording the frames in " << record_file << endl;
+		p_frame_recorder = new FrameRecorder(record_file, mediasrc.height(), 
+											 mediasrc.width());
+	} else {
+		p_frame_recorder = NULL;
+	}
     i_export_screen_frq = settings.getInt("export_frames_frq", true);
 	i_export_screen_after = settings.getInt("export_frames_after", true);
 	i_export_screen_before = settings.getInt("export_frames_before", true);
@@ -130,12 +150,20 @@ PlayerAgent::~PlayerAgent() {
 	delete pv_reward_per_frame;
 	delete pv_episodes_start_frame; 
 	delete pv_episodes_end_frame;
+	delete p_screen_planes;
+	delete p_screen_changes;
+	if (p_tia_objects) {
+		delete p_tia_objects;
+	}
 	if (p_background_detect) {
 		delete p_background_detect;
 	}
 	if (p_class_dicovery) {
 		delete p_class_dicovery;
 	}
+	if (p_frame_recorder) {
+		delete p_frame_recorder;
+	}
 }
 
 /* *********************************************************************
@@ -162,6 +190,13 @@ Action PlayerAgent::agent_step( const IntMatrix* screen_matrix,
 		
     pm_curr_screen_matrix = screen_matrix; 
     pv_curr_console_ram = console_ram;     
+	// The screen matrix is the last frame of the TIA
+	p_screen_changes->update();
+	p_screen_planes->set_screen(screen_matrix, p_screen_changes);
+	p_screen_changes->clear();
+	if (p_tia_objects) {
+		p_tia_objects->set_frame();
+	}
 	
 	// Export the Screen
 	if ( i_export_screen_frq != 0 && 
@@ -307,9 +342,14 @@ Action PlayerAgent::agent_step( const IntMatrix* screen_matrix,
                 i_restart_delay_counter=p_game_settings->i_delay_after_restart;
                 return RESET;
             } else {
+				if (p_frame_recorder) {
+					// Record the screen, for class_disc_tool
+					p_frame_recorder->add_frame(p_screen_planes->get_screen_matrix(),
+												i_frame_counter);
+				}
 				if (b_do_bg_detection) {
 					// Send screen for background detection
-					p_background_detect->get_new_screen(pm_curr_screen_matrix);
+					p_background_detect->get_new_screen(p_screen_planes);
 					if (p_background_detect->is_bg_extraction_complete()) {
 						cout << "Background Detection Complete." << endl;
 						end_game();
@@ -317,7 +357,7 @@ Action PlayerAgent::agent_step( const IntMatrix* screen_matrix,
 				}
 				if (b_do_class_disc) {
 					// Send screen fro background detection
-					p_class_dicovery->get_new_screen(pm_curr_screen_matrix, 
+					p_class_dicovery->get_new_screen(p_screen_planes, 
 													i_frame_counter);
 					if (p_class_dicovery->is_class_discovery_complete()) {
 						cout << "Class Discovery Complete." << endl;
@@ -368,6 +408,19 @@ void PlayerAgent::on_end_of_game(void) {
             ", Frame #" << i_frame_counter << 
             ", Num Frames = " << num_frames <<
             ", Sum Reward = " << f_episode_reward << endl;
+    if (b_write_learning_curve) {
+        // Learning curve of this worker: episode,frames,seconds,reward
+        // (ticks are accumulated per episode, since they wrap around)
+        uInt32 ticks = p_osystem->getTicks();
+        f_curve_seconds += (ticks - i_curve_ticks) / 1000000.0;
+        i_curve_ticks = ticks;
+        int worker_id = p_osystem->settings().getInt("learning_worker_id");
+        file.open(learning_curve_filename(worker_id).c_str(), 
+                  std::fstream::app);
+        file << i_episode_counter << "," << i_frame_counter << "," 
+             << f_curve_seconds << "," << f_episode_reward << endl;
+        file.close();
+    }
     f_all_episode_reward += f_episode_reward;
     f_episode_reward = 0;
     i_episode_counter++;
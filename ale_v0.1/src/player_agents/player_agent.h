@@ -20,6 +20,9 @@
 #include "game_settings.h"
 #include "background_detector.h"
 #include "class_discovery.h"
+#include "screen_planes.h"
+#include "tia_objects.h"
+#include "frame_recording.h"
 
 class PlayerAgent  {
     /* *************************************************************************
@@ -30,10 +33,21 @@ class PlayerAgent  {
             - p_game_settings           An instance of the GameSettings class
             - pm_curr_screen_matrix     2D matrix of color indecies
             - pv_curr_console_ram       Content of the Console RAM
+            - p_screen_planes           The bitplanes of the current screen,
+                                        shared by the vision modules
+            - p_screen_changes          The parts of the screen that changed
+                                        since the last step
+            - p_tia_objects             The objects drawn by the TIA on the
+                                        current frame (NULL unless 
+                                        use_tia_objects is true)
             - i_num_actions             Number of possible acitons
             - p_osystem                 Pointer to the stella's OSystem object
 			- p_background_detect		Used for background-detection
 			- p_class_dicovery			Used for class-discovery
+			- p_frame_recorder			Records the screens sent to the 
+										background-detection and the 
+										class-discovery (NULL unless 
+										record_frames_file is set)
             - e_episode_counter         The status of the current episode.Can be
                     INITIAL_DELAY,      The delay at very beginning of game
                     RESTART_DELAY,      Delay after restarting the game
@@ -133,8 +147,12 @@ class PlayerAgent  {
         GameSettings* p_game_settings;  // An instance of the GameSettings class
         const IntMatrix* pm_curr_screen_matrix; // 2D matrix of color indecies
         const IntVect* pv_curr_console_ram;     // Content of the Console RAM
+		ScreenPlanes* p_screen_planes;	  // The bitplanes of the current screen
+		ScreenChanges* p_screen_changes;  // The changes since the last step
+		TIAObjects* p_tia_objects;		  // The objects drawn by the TIA
 		BackgroundDetector* p_background_detect;// Used for background-detection
 		ClassDiscovery* p_class_dicovery; // Used for class-discovery
+		FrameRecorder* p_frame_recorder;  // Records the screens for class_disc_tool
         
 		
         float f_curr_reward;              // Reward recieved from game
@@ -155,6 +173,11 @@ class PlayerAgent  {
         bool b_export_death_screens;      // When true, we will save the screens
                                           // when we die
 		int i_init_act_explor_count;
+		bool b_write_learning_curve;	  // True with several learning workers:
+										  // we also write the learning curve 
+										  // of this worker
+		uInt32 i_curve_ticks;			  // Ticks at the last curve point
+		double f_curve_seconds;			  // Seconds since the agent started
 		int i_curr_expl_act_index;		  // The index of the action we 
 										  // are currently exploring
 		int i_curr_act_frame_count;		  // How many frames we have tried this 
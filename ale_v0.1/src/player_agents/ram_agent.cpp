@@ -27,7 +27,8 @@ RAMAgent::RAMAgent(GameSettings* _game_settings, OSystem* _osystem) :
     i_full_feature_vec_length = i_base_length * i_num_actions;
 	cout << "Full Feature-Vector Length: " << i_full_feature_vec_length << endl;
 	p_sarsa_lambda_solver = RLSarsaLambda::generate_rl_sarsa_lambda_instance(
-						p_osystem, i_full_feature_vec_length, i_num_actions);
+						p_osystem, i_full_feature_vec_length, i_num_actions,
+						i_base_length);
 
     pv_curr_feature_map  = new FeatureMap();
     pv_num_nonzero_in_f = new IntVect();
@@ -36,7 +37,9 @@ RAMAgent::RAMAgent(GameSettings* _game_settings, OSystem* _osystem) :
         pv_curr_feature_map->push_back(feature_vec);
         pv_num_nonzero_in_f->push_back(0);
     }
-    pv_tmp_fv_first_part = new IntArr(-1, RAM_LENGTH * 8);
+    pv_tmp_bit_words = new BitWordVect;
+    pv_tmp_active_bits = new IntVect;
+    pv_tmp_feature_inds = new IntVect;
     pv_subvector_positions = new IntVect;
     for (int a = 0; a < i_num_actions; a++) {
         pv_subvector_positions->push_back(a * i_base_length);
@@ -50,7 +53,9 @@ RAMAgent::~RAMAgent() {
     delete p_sarsa_lambda_solver;
     delete pv_curr_feature_map;
     delete pv_num_nonzero_in_f;
-    delete pv_tmp_fv_first_part;
+    delete pv_tmp_bit_words;
+    delete pv_tmp_active_bits;
+    delete pv_tmp_feature_inds;
     delete pv_subvector_positions;
 
 }
@@ -133,38 +138,15 @@ void RAMAgent::generate_feature_vec(void) {
     for (int a = 0; a < i_num_actions; a++) {
         (*pv_num_nonzero_in_f)[a] = 0;
     }
-    int full_vect_index = 0;
-    int byte_val, bit_val;
-    // Get the bit values of ram content into our temp array,
-    // Also, generate the first part of the feature-vector
-    for (int i = 0; i < RAM_LENGTH; i++) {
-        byte_val = (*pv_curr_console_ram)[i];
-        for (int k = 7; k >= 0; k--) {
-            bit_val = (byte_val >> k) & 1;
-            (*pv_tmp_fv_first_part)[full_vect_index] = bit_val;
-            if (bit_val == 1) {
-                add_one_index_to_feature_map(full_vect_index);
-            }
-            full_vect_index++;
-        }
+    // Only the set bits (and the pairs of set bits) produce features, so we
+    // work from the list of set bits, rather than walking all the pairs
+    pack_ram_bits(pv_curr_console_ram, *pv_tmp_bit_words);
+    extract_active_bits(*pv_tmp_bit_words, *pv_tmp_active_bits);
+    pv_tmp_feature_inds->clear();
+    generate_bit_pair_features(*pv_tmp_active_bits, i_ram_bits_length, 
+                               *pv_tmp_feature_inds);
+    for (unsigned int f = 0; f < pv_tmp_feature_inds->size(); f++) {
+        assert((*pv_tmp_feature_inds)[f] < i_base_length);
+        add_one_index_to_feature_map((*pv_tmp_feature_inds)[f]);
     }
-		
-   // Now we'll get the crossproduct of all the bits
-    for (int i = 0; i < i_ram_bits_length; i++) {
-//      Possible major optimization:
-//        if ((*pv_tmp_fv_first_part)[i]  == 0) {
-//            full_vect_index += (i_ram_bits_length - (i + 1));
-//            continue;
-//        }
-        for (int j = i + 1; j < i_ram_bits_length; j++) {
-            if ((*pv_tmp_fv_first_part)[i]  == 1 &&
-                (*pv_tmp_fv_first_part)[j] == 1) { 
-                add_one_index_to_feature_map(full_vect_index);
-            }
-            full_vect_index++;
-        }
-    }
-    assert(full_vect_index == i_base_length);
 }
-
-
@@ -19,6 +19,7 @@
 #include "common_constants.h"
 #include "player_agent.h"
 #include "rl_sarsa_lambda.h"
+#include "bit_pair_tools.h"
 
 class RAMAgent : public PlayerAgent {
     /* *************************************************************************
@@ -29,8 +30,10 @@ class RAMAgent : public PlayerAgent {
         - pv_curr_feature_map   pv_curr_feature_map[a] is the feature-vector 
                                 for action a.
         - pv_num_nonzero_in_f   Number of non-zero values in each feature-vector 
-        - pv_tmp_fv_first_part  An array containing the first part of the 
-                                feature-vector (this is only used internally)
+        - pv_tmp_bit_words      The RAM content packed in bit-words
+        - pv_tmp_active_bits    Indices of the set bits in the RAM
+        - pv_tmp_feature_inds   Indices of the set bits and set bit-pairs
+                                (these three are only used internally)
         - p_sarsa_lambda_solver Pointer to the SARSA-Lambda solver object
         - i_ram_bits_length     Number of bits in RAm (128 * 8 = 1024)
         - i_base_length         Number of bits required to keep 128 * 8 = 1024
@@ -99,7 +102,9 @@ class RAMAgent : public PlayerAgent {
         FeatureMap* pv_curr_feature_map;
         IntVect* pv_num_nonzero_in_f;
         RLSarsaLambda* p_sarsa_lambda_solver;
-        IntArr* pv_tmp_fv_first_part;
+        BitWordVect* pv_tmp_bit_words;
+        IntVect* pv_tmp_active_bits;
+        IntVect* pv_tmp_feature_inds;
         int i_ram_bits_length;
         int i_base_length;
         int i_full_feature_vec_length;
@@ -15,6 +15,7 @@
  **************************************************************************** */
 
 #include <sstream>
+#include <algorithm>
 #include "game_controller.h"
 #include "vector_matrix_tools.h"
 #include "region_manager.h"
@@ -27,15 +28,6 @@ RegionManager::RegionManager(OSystem* _osystem, IntMatrix* background_matrix) {
     i_screen_width  = mediasrc.width();
     i_screen_height = mediasrc.height();
 	
-	// initilize the region matrix
-	pm_region_matrix = new IntMatrix;
-	for (int i = 0; i < i_screen_height; i++) {
-		IntVect row;
-		for (int j = 0; j < i_screen_width; j++) {
-			row.push_back(-1);
-		}
-		pm_region_matrix->push_back(row);
-	}
 	i_curr_num_regions = 0;
 	i_prev_num_regions = 0;
 	
@@ -58,10 +50,11 @@ RegionManager::RegionManager(OSystem* _osystem, IntMatrix* background_matrix) {
 	i_max_obj_velocity = p_osystem->settings().getInt("max_obj_velocity", true); 												
 	f_max_shape_area_dif = p_osystem->settings().getFloat(
 												"max_shape_area_dif", true);
+	p_prev_objects_grid = new SpatialGrid(i_screen_height, i_screen_width, 
+										  i_max_obj_velocity);
 }
 
 RegionManager::~RegionManager() {
-	delete pm_region_matrix;
 	clear_list_of_pointers(pv_curr_objects);
 	clear_list_of_pointers(pv_prev_objects);
 	clear_list_of_pointers(pv_curr_merged_objects);
@@ -70,28 +63,29 @@ RegionManager::~RegionManager() {
 	delete pv_prev_objects;
 	delete pv_curr_merged_objects;
 	delete pv_prev_merged_objects;
+	delete p_prev_objects_grid;
 }
 
 /* *********************************************************************
-	Given a new scree_matrix, it first uses a naive blob-detection 
-	method to extract a set of regions. It then looks at the regions in 
+	Given a new scree_matrix, it first splits its foreground into 
+	connected regions of one color. It then looks at the regions in 
 	previous screen, calculates the velocity for each region,
 	and merges the regions that are adjacent and have the same velocity
 	The detected regions are returned as a a list of RegionObjects
  ******************************************************************** */
 const RegionObjectList* RegionManager::extract_objects_from_new_screen(
-											const IntMatrix* screen_matrix,
+											ScreenPlanes* screen_planes,
 											int frame_number) {
 	swap_curr_and_prev_region_objects();
-	// 1- Use our naive method to extract regions
-	i_curr_num_regions = extract_regions(screen_matrix);
-	if (i_curr_num_regions > MAX_NUM_OBJECTS) {
+	// 1- Split the foreground into connected regions of one color
+	i_curr_num_regions = extract_regions(screen_planes);
+	if (i_curr_num_regions >= MAX_NUM_OBJECTS) {
 		stringstream err;
 		err << "RegionManager: number of discovered regions (" 
-			 << i_curr_num_regions << ") is higher than MAX_NUM_OBJECTS ("
+			 << i_curr_num_regions << ") is not lower than MAX_NUM_OBJECTS ("
 			 << MAX_NUM_OBJECTS << ")\n" << endl;
-		cerr << err;
-		cout << err;
+		cerr << err.str();
+		cout << err.str();
 		exit(-1);
 	}
 	
@@ -100,38 +94,59 @@ const RegionObjectList* RegionManager::extract_objects_from_new_screen(
 	}
 	
 	// 2- Assign a RegionObject to each of the extracted region
+	p_prev_objects_grid->clear();
+	for (int reg_num = 1; reg_num <= i_prev_num_regions; reg_num++) {
+		RegionObject* prev_obj = (*pv_prev_objects)[reg_num];
+		if (prev_obj != NULL && prev_obj->b_is_valid) {
+			p_prev_objects_grid->add_point(prev_obj->i_center_x, 
+										   prev_obj->i_center_y, reg_num);
+		}
+	}
+	vector<IntVect> region_runs(i_curr_num_regions + 1);
+	for (unsigned int r = 0; r < v_runs.size(); r++) {
+		region_runs[v_run_region[r]].push_back(r);
+	}
 	for (int reg_num = 1; reg_num <= i_curr_num_regions; reg_num++) {
 		RegionObject* new_object = new RegionObject();
-		new_object->extract_from_region_matrix(pm_region_matrix, reg_num);
-		if (new_object->b_is_valid) {	// non-empty region
-			(*pv_curr_objects)[reg_num] = new_object;	
-			// Find the corresponding object in previous frame,
-			RegionObject* previous_object = new_object->get_closest_obj_in_list(
-					pv_prev_objects, i_prev_num_regions, f_max_shape_area_dif, 
-					f_max_perc_difference, i_max_obj_velocity);
-			// Calculate object's velocity
-			new_object->p_previous_object = previous_object;
-			calc_object_velocity(new_object);
-		}
+		new_object->extract_from_runs(v_runs, region_runs[reg_num], reg_num);
+		assert(new_object->b_is_valid);	// every region has a run
+		(*pv_curr_objects)[reg_num] = new_object;	
+		// Find the corresponding object in previous frame,
+		// (the previous regions are numbered from 1)
+		RegionObject* previous_object = new_object->get_closest_obj_in_list(
+				pv_prev_objects, i_prev_num_regions + 1, f_max_shape_area_dif, 
+				f_max_perc_difference, i_max_obj_velocity, p_prev_objects_grid);
+		// Calculate object's velocity
+		new_object->p_previous_object = previous_object;
+		calc_object_velocity(new_object);
 	}
 	
-	// 3- Merge regions in the region_matrix that are connected and
-	// correspond to objects with equal velocity
+	// 3- Merge regions that are close and correspond to objects with 
+	// equal velocity
 	merge_equivalent_regions();
 	
 	if (b_plot_region_matrix_post_merge) {
 		plot_region_matrix("post_merge", frame_number);
 	}
 	
-	// 4- Generate a new list of merged objects
+	// 4- Generate a new list of merged objects (each one is listed at 
+	// its smallest region number)
 	for (int reg_num = 1; reg_num <= i_curr_num_regions; reg_num++) {
-		RegionObject* new_object = new RegionObject();
-		new_object->extract_from_region_matrix(pm_region_matrix, reg_num);
-		if (!new_object->b_is_valid) {	
-			continue; // empty region
+		region_runs[reg_num].clear();
+	}
+	for (unsigned int r = 0; r < v_runs.size(); r++) {
+		int root = find_root(v_region_parent, v_run_region[r]);
+		region_runs[root].push_back(r);
+	}
+	for (int reg_num = 1; reg_num <= i_curr_num_regions; reg_num++) {
+		if (region_runs[reg_num].empty()) {
+			continue; // merged into a smaller region
 		}
+		RegionObject* new_object = new RegionObject();
+		new_object->extract_from_runs(v_runs, region_runs[reg_num], reg_num);
 		if (new_object->i_width == 1 && 
 			new_object->i_height == 1) {
+			delete new_object;
 			continue; // ignore objects consisting of exactly one pixel
 		}
 		RegionObject* premerge_obj = (*pv_curr_objects)[reg_num];
@@ -144,199 +159,159 @@ const RegionObjectList* RegionManager::extract_objects_from_new_screen(
 }
 
 /* *********************************************************************
-	Uses a simple sequential method to categorize non-background pixels
-	in the given screen as belonging to one of many discrete regions.
-	The result of this method is a matrix, where the item representing
-	each pixel is either 0 (i.e. background) or i, where is the region
-	number. Returns the number of regions found (pre merge).
-	
-	
-	This sequential approach is taken from Wikipedia
-	(http://en.wikipedia.org/wiki/Blob_extraction)
-	
-	Scan the image from left to right and from top to bottom:
-	For every pixel: 
-	*   check the north and west pixel (when considering
-		4-connectivity) or the northeast, north, northwest, and west 
-		pixel for 8-connectivity for a given region criterion.
-	*   If none of the neighbors fit the criterion then assign to region
-		value of the region counter. Increment region counter.
-	*   If only one neighbor fits the criterion assign pixel to that 
-		region.
-	*   If multiple neighbors match and are all members of the same 
-		region, assign pixel to their region.
-	*   If multiple neighbors match and are members of different 
-		regions, assign pixel to one of the regions 
-		Indicate that all of these regions are the equivalent.
-	
-	Note 1: After this method, the image still needs to be rescanned,
-	so the equivalent regions are merged
-	
-	Note 2: At this point we only find mono-color regions
+	Categorizes the foreground pixels of the given screen as belonging
+	to one of many discrete regions: the 8-connected pixels of one color.
+	The foreground of each row is split into runs of one color, and each
+	run is joined (in a union-find tree) with the runs of the same color 
+	on the previous row that touch it, including diagonally. Fills 
+	v_runs, v_row_first_run and v_run_region, and returns the number of 
+	regions found (pre merge)
  ******************************************************************** */
-int RegionManager::extract_regions(const IntMatrix* screen_matrix) {
-	int num_neighbors = 4;
-	int neighbors_y[] = {-1, -1, -1,  0};
-
-	int neighbors_x[] = {-1,  0,  1, -1};
-	// Reset the region-matrix
-	for (int i = 0; i < i_screen_height; i++) {
-		for (int j = 0; j < i_screen_width; j++) {
-			(*pm_region_matrix)[i][j] = -1;
-		}
-	}
-	int region_counter = 1; // region 0 is reseved for the background
+int RegionManager::extract_regions(ScreenPlanes* screen_planes) {
+	const IntMatrix* screen_matrix = screen_planes->get_screen_matrix();
+	const PackedBitMatrix* forground = screen_planes->get_forground();
+	v_runs.clear();
+	v_run_parent.clear();
+	v_row_first_run.clear();
 	
-	// 1- First Scan
-	int i, j, y, x, color_ind, neighbors_ind, found_region;
-	for (i = 0; i < i_screen_height; i++) {
-		for (j = 0; j < i_screen_width; j++) {
-			color_ind = (*screen_matrix)[i][j];
-			if (color_ind == (*pm_background_matrix)[i][j]) {
-				// This pixel is part of the background
-				(*pm_region_matrix)[i][j] = 0;
+	// 1- Split the rows into runs, and join the touching runs
+	int prev_row_first_run = 0;
+	for (int y = 0; y < i_screen_height; y++) {
+		int row_first_run = v_runs.size();
+		v_row_first_run.push_back(row_first_run);
+		const IntVect& screen_row = (*screen_matrix)[y];
+		int x = 0;
+		while (x < i_screen_width) {
+			// skip to the next foreground pixel
+			BitWord fg_bits = forground->get_bits(y, x);
+			if (fg_bits == 0) {
+				x += BITS_PER_WORD;
 				continue;
 			}
-			// find the region of i,j based on west and north neighbors.
-			found_region = -1; 
-			for (neighbors_ind = 0; neighbors_ind < num_neighbors;
-				 neighbors_ind++) {
-				y = i + neighbors_y[neighbors_ind];
-				x = j + neighbors_x[neighbors_ind];
-				if (x < 0 || x >= i_screen_width ||
-					y < 0 || y >= i_screen_height) {
+			x += __builtin_ctzll(fg_bits);
+			PixelRun run;
+			run.y = y;
+			run.start = x;
+			run.color = screen_row[x];
+			while (x < i_screen_width && forground->get_bit(y, x) && 
+				   screen_row[x] == run.color) {
+				x++;
+			}
+			run.end = x;
+			int run_ind = v_runs.size();
+			v_runs.push_back(run);
+			v_run_parent.push_back(run_ind);
+			// The runs of the previous row that touch this one
+			for (int p = prev_row_first_run; p < row_first_run; p++) {
+				const PixelRun& prev_run = v_runs[p];
+				if (prev_run.end < run.start) {
 					continue;
 				}
-				if ((*pm_region_matrix)[y][x] != 0 &&
-				    (*pm_region_matrix)[y][x] != -1 &&
-					(*screen_matrix)[y][x] == color_ind) {
-					found_region = (*pm_region_matrix)[y][x];
+				if (prev_run.start > run.end) {
 					break;
 				}
-			}
-			if (found_region == -1) {
-				// this pixel is in a new region
-				(*pm_region_matrix)[i][j] = region_counter;
-				region_counter++;
-			} else {
-				(*pm_region_matrix)[i][j] = found_region;
+				if (prev_run.color == run.color) {
+					join_roots(v_run_parent, p, run_ind);
+				}
 			}
 		}
+		prev_row_first_run = row_first_run;
 	}
-	 // 2- Re-scan the region_matrix, and merge equivalent regions
-	 int my_region, nb_region, my_color_ind, nb_color_ind;
-	 int nb_x, nb_y, ind_i, ind_j, lower_region, higher_region;
-	 for (i = 0; i < i_screen_height; i++) {
-		for (j = 0; j < i_screen_width; j++) {
-			my_region = (*pm_region_matrix)[i][j];
-			if (my_region == 0) {
-				continue; // background pixel
-			}
-			my_color_ind = (*screen_matrix)[i][j];
-			for (y = -1; y <= 1; y++) {
-				for (x = -1; x <= 1; x++) {
-					nb_y = i + y;
-					nb_x = j + x;
-					if (nb_x < 0 || nb_x >= i_screen_width ||
-						nb_y < 0 || nb_y >= i_screen_height) {
-						continue;
-					}
-					nb_region = (*pm_region_matrix)[nb_y][nb_x];
-					if (nb_region == 0) {
-						continue;
-					}
-					nb_color_ind = (*screen_matrix)[nb_y][nb_x];
-					if (nb_color_ind == my_color_ind &&
-						nb_region != my_region) {
-						// These two regions are equivilant
-						if (my_region > nb_region) {
-							higher_region = my_region;
-							lower_region = nb_region;
-						} else {
-							higher_region = nb_region;
-							lower_region = my_region;
-						}
-						// Go through the region matrix and convert
-						// higher_region to lower_region
-						for (ind_i = 0; ind_i < i_screen_height; ind_i++) {
-							for (ind_j = 0; ind_j < i_screen_width; ind_j++) {
-								if ((*pm_region_matrix)[ind_i][ind_j] == higher_region) {
-									(*pm_region_matrix)[ind_i][ind_j] = lower_region;
-								}
-							}
-						}
-					}    
-				}
-			}
+	v_row_first_run.push_back(v_runs.size());
+	
+	// 2- Number the regions in the order of their first run (which is 
+	// the root of their tree)
+	int num_regions = 0;
+	v_run_region.assign(v_runs.size(), 0);
+	for (unsigned int r = 0; r < v_runs.size(); r++) {
+		int root = find_root(v_run_parent, r);
+		if (root == (int)r) {
+			num_regions++;
+			v_run_region[r] = num_regions;
+		} else {
+			v_run_region[r] = v_run_region[root];
 		}
 	}
-	return region_counter - 1;
+	v_region_parent.clear();
+	for (int reg_num = 0; reg_num <= num_regions; reg_num++) {
+		v_region_parent.push_back(reg_num);
+	}
+	return num_regions;
 }
 
 /* *********************************************************************
-	Merges regions in the region_matrix that are connected and
-	correspond to objects with equal velocity
+	Merges the regions that are close (see MERGE_DISTANCE) and
+	correspond to objects with equal velocity, in v_region_parent.
+	Each run is compared with the runs under the pixels MERGE_DISTANCE
+	columns to its left, on the rows up to MERGE_DISTANCE away
  ******************************************************************** */
 void RegionManager::merge_equivalent_regions(void) {
-	int i, j, shift_x, shift_y, y, x, ind_i, ind_j;
-	int my_region_num, neighbor_region_num;
-	RegionObject *my_obj, *nb_obj;
-	int high_region_num, low_region_num;
-	for (i = 0; i < i_screen_height; i++) {
-		for (j = 0; j <i_screen_width; j++) {
-			my_region_num = (*pm_region_matrix)[i][j];
-			if (my_region_num == 0) {
-				continue;   // ignore the background pixels
-			}
-			my_obj = (*pv_curr_objects)[my_region_num];
-			if (my_obj == NULL) {
-				continue; // invalid object
+	for (unsigned int r = 0; r < v_runs.size(); r++) {
+		const PixelRun& run = v_runs[r];
+		int start = max(run.start - MERGE_DISTANCE, 0);
+		int end = run.end - MERGE_DISTANCE;
+		if (end <= start) {
+			continue;	// the shifted run is off the screen
+		}
+		for (int shift_y = -MERGE_DISTANCE; shift_y <= MERGE_DISTANCE; 
+			 shift_y++) {
+			int y = run.y + shift_y;
+			if (y < 0 || y >= i_screen_height) {
+				continue;
 			}
-			for(shift_y = -3; shift_y <= 3; shift_y++) {
-				for (shift_x = -3; shift_x <= -3; shift_x++) {
-					y = i + shift_y;
-					x = j + shift_x;
-					if (x < 0 || x >= i_screen_width ||
-						y < 0 || y >= i_screen_height) {
-						continue;
-					}
-					neighbor_region_num = (*pm_region_matrix)[y][x];
-					if (neighbor_region_num == 0) {
-						continue;   // ignore the background pixels
-					}
-					nb_obj = (*pv_curr_objects)[neighbor_region_num];
-					if (nb_obj == NULL) {
-						continue; // invalid object
-					}
-					if ((my_region_num != neighbor_region_num)  &&
-						(my_obj->i_velocity_x == nb_obj->i_velocity_x) &&
-						(my_obj->i_velocity_y == nb_obj->i_velocity_y)) {
-						// These two regions should be merged
-						if (my_region_num > neighbor_region_num) {
-							high_region_num = my_region_num;
-							low_region_num = neighbor_region_num;
-						} else {
-							high_region_num = neighbor_region_num;
-							low_region_num = my_region_num;
-						}
-						// Go through the region matrix and convert
-						// high_region_num to low_region_num
-						for (ind_i = 0; ind_i < i_screen_height; ind_i++) {
-							for (ind_j = 0; ind_j < i_screen_width; ind_j++) {
-								if ((*pm_region_matrix)[ind_i][ind_j] == 
-															high_region_num) {
-									(*pm_region_matrix)[ind_i][ind_j] = 
-																low_region_num;
-								}
-							}
-						}
-					}
+			for (int n = v_row_first_run[y]; n < v_row_first_run[y + 1]; n++) {
+				const PixelRun& nb_run = v_runs[n];
+				if (nb_run.end <= start) {
+					continue;
+				}
+				if (nb_run.start >= end) {
+					break;
+				}
+				int my_region_num = find_root(v_region_parent, v_run_region[r]);
+				int neighbor_region_num = find_root(v_region_parent, 
+													v_run_region[n]);
+				if (my_region_num == neighbor_region_num) {
+					continue;
+				}
+				RegionObject* my_obj = (*pv_curr_objects)[my_region_num];
+				RegionObject* nb_obj = (*pv_curr_objects)[neighbor_region_num];
+				if ((my_obj->i_velocity_x == nb_obj->i_velocity_x) &&
+					(my_obj->i_velocity_y == nb_obj->i_velocity_y)) {
+					// These two regions should be merged
+					join_roots(v_region_parent, my_region_num, 
+							   neighbor_region_num);
 				}
 			}
 		}
 	}
 }
 
+/* *********************************************************************
+	Returns the root of the given node in the given union-find tree,
+	and halves the path to it on the way
+ ******************************************************************** */
+int RegionManager::find_root(IntVect& parents, int node) {
+	while (parents[node] != node) {
+		parents[node] = parents[parents[node]];
+		node = parents[node];
+	}
+	return node;
+}
+
+/* *********************************************************************
+	Joins the trees of the two given nodes. The smaller root becomes
+	the root of both
+ ******************************************************************** */
+void RegionManager::join_roots(IntVect& parents, int node_a, int node_b) {
+	int root_a = find_root(parents, node_a);
+	int root_b = find_root(parents, node_b);
+	if (root_a < root_b) {
+		parents[root_b] = root_a;
+	} else {
+		parents[root_a] = root_b;
+	}
+}
+
 
 /* *********************************************************************
     Calculates the object velocity, based on its location, and the
@@ -382,19 +357,16 @@ void RegionManager::swap_curr_and_prev_region_objects(void) {
 	pre_post is either "pre_merge" or "psot_merge" and used in filename
   ******************************************************************** */
 void RegionManager::plot_region_matrix(string pre_post, int frame_number) {
-	// copy the region_matrix to a new matrix with color indecies
-	IntMatrix* region_matrix_copy = new IntMatrix;
-	for (int i = 0; i < i_screen_height; i++) {
-		IntVect row;
-		for (int j = 0; j < i_screen_width; j++) {
-			int region_num = (*pm_region_matrix)[i][j];
-			if (region_num == 0) {
-				row.push_back(BLACK_COLOR_IND + 256);	// background is black
-			} else {
-				row.push_back(region_num + 256); // use the custom pallete
-			}
+	// draw the runs on a new matrix with color indecies (background is 
+	// black, and the regions use the custom pallete)
+	IntMatrix* region_matrix_copy = new IntMatrix(i_screen_height, 
+							IntVect(i_screen_width, BLACK_COLOR_IND + 256));
+	for (unsigned int r = 0; r < v_runs.size(); r++) {
+		const PixelRun& run = v_runs[r];
+		int region_num = find_root(v_region_parent, v_run_region[r]);
+		for (int x = run.start; x < run.end; x++) {
+			(*region_matrix_copy)[run.y][x] = region_num + 256;
 		}
-		region_matrix_copy->push_back(row);
 	}
 	ostringstream filename;
 	char buffer [50];
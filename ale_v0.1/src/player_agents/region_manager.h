@@ -20,8 +20,13 @@
 #include "common_constants.h"
 #include "OSystem.hxx"
 #include "blob_object.h"
+#include "screen_planes.h"
 
 #define MAX_NUM_OBJECTS 1000
+#define MERGE_DISTANCE 3	// Regions with equal velocity are merged, when 
+							// a pixel of one is this many columns to the 
+							// right (and up to this many rows away) of a 
+							// pixel of the other
 
 
 class RegionManager  {
@@ -30,9 +35,20 @@ class RegionManager  {
         and merging the regions that belong to the same object
             
         Object Variables:
-            - pm_region_matrix      region_matrix[i,j] determines the
-                                    region number that pixel i,j belongs to.
-                                    Region 0 is reserved for background pixels
+            - v_runs                The runs of one color of the foreground 
+                                    pixels, in the order of the rows, then 
+                                    the columns
+            - v_row_first_run       The index of the first run of each row 
+                                    (and the number of runs at the end)
+            - v_run_parent          The union-find tree of the runs: the 
+                                    parent of each run (the roots are the 
+                                    first run of their region)
+            - v_run_region          The region number of each run. Regions 
+                                    are numbered from 1, in the order of 
+                                    their first run
+            - v_region_parent       The union-find tree of the regions that
+                                    are merged (the roots are the smallest
+                                    region number of their merged region)
             - i_curr_num_regions    Number of regions in the current timestep
             - i_prev_num_regions    Number of regions in the previous timestep
             - v_curr_objects        List of objects detected on current screen
@@ -44,6 +60,9 @@ class RegionManager  {
             - pv_prev_merged_objects  List of the previous merged objects. This 
 									is kept, so I don;t delete prev_objects
 									in ClassDiscovery
+            - p_prev_objects_grid   The valid objects of v_prev_objects (by 
+                                    region number), in cells of 
+                                    i_max_obj_velocity pixels
             - pm_background_matrix  The background matrix
 			- b_plot_region_matrix_pre_merge	When true, we will plot the 
 									region matrix, befor mering the objects
@@ -64,53 +83,46 @@ class RegionManager  {
         virtual ~RegionManager();
 
 		/* *********************************************************************
-			Given a new scree_matrix, it first uses a naive blob-detection 
-			method to extract a set of regions. It then looks at the regions in 
+			Given a new scree_matrix, it first splits its foreground into 
+			connected regions of one color. It then looks at the regions in 
             previous screen, calculates the velocity for each region,
             and merges the regions that are adjacent and have the same velocity
 			The detected regions are returned asa a list of RegionObjects
          ******************************************************************** */
 		const RegionObjectList* extract_objects_from_new_screen(
-												const IntMatrix* screen_matrix, 
+												ScreenPlanes* screen_planes, 
 												int frame_number);
 		
 	protected:
 		/* *********************************************************************
-            Uses a simple sequential method to categorize non-background pixels
-            in the given screen as belonging to one of many discrete regions.
-            The result of this method is a matrix, where the item representing
-            each pixel is either 0 (i.e. background) or i, where is the region
-            number. Returns the number of regions found (pre merge).
-            This sequential approach is taken from Wikipedia
-            (http://en.wikipedia.org/wiki/Blob_extraction)
-            
-            Scan the image from left to right and from top to bottom:
-            For every pixel: 
-            *   check the north and west pixel (when considering
-                4-connectivity) or the northeast, north, northwest, and west 
-                pixel for 8-connectivity for a given region criterion.
-            *   If none of the neighbors fit the criterion then assign to region
-                value of the region counter. Increment region counter.
-            *   If only one neighbor fits the criterion assign pixel to that 
-				region.
-            *   If multiple neighbors match and are all members of the same 
-				region, assign pixel to their region.
-            *   If multiple neighbors match and are members of different 
-                regions, assign pixel to one of the regions 
-                Indicate that all of these regions are the equivalent.
-            
-            Note 1: After this method, the image still needs to be rescanned,
-            so the equivalent regions are merged
-            
-            Note 2: At this point we only find mono-color regions
+            Categorizes the foreground pixels of the given screen as 
+            belonging to one of many discrete regions: the 8-connected 
+            pixels of one color.
+            The foreground of each row is split into runs of one color, and
+            each run is joined (in a union-find tree) with the runs of the 
+            same color on the previous row that touch it, including 
+            diagonally. Fills v_runs, v_row_first_run and v_run_region, and
+            returns the number of regions found (pre merge)
          ******************************************************************** */
-		int extract_regions(const IntMatrix* screen_matrix);
+		int extract_regions(ScreenPlanes* screen_planes);
 
         /* *********************************************************************
-			Merges regions in the region_matrix that are connected and
-			correspond to objects with equal velocity
+			Merges the regions that are close (see MERGE_DISTANCE) and
+			correspond to objects with equal velocity, in v_region_parent
 	     ******************************************************************** */
 		void merge_equivalent_regions(void);
+
+        /* *********************************************************************
+			Returns the root of the given node in the given union-find tree,
+			and halves the path to it on the way
+	     ******************************************************************** */
+		static int find_root(IntVect& parents, int node);
+
+        /* *********************************************************************
+			Joins the trees of the two given nodes. The smaller root becomes
+			the root of both
+	     ******************************************************************** */
+		static void join_roots(IntVect& parents, int node_a, int node_b);
 				
 		/* *********************************************************************
 			Calculates the object velocity, based on its location, and the
@@ -135,13 +147,18 @@ class RegionManager  {
 
 		OSystem* p_osystem;
 		IntMatrix* pm_background_matrix;
-		IntMatrix* pm_region_matrix; 
+		PixelRunVect v_runs;
+		IntVect v_row_first_run;
+		IntVect v_run_parent;
+		IntVect v_run_region;
+		IntVect v_region_parent;
 		int i_curr_num_regions;
 		int i_prev_num_regions;
 		RegionObjectList* pv_curr_objects;
 		RegionObjectList* pv_prev_objects;
 		RegionObjectList* pv_curr_merged_objects;
 		RegionObjectList* pv_prev_merged_objects;
+		SpatialGrid* p_prev_objects_grid;
 		bool b_plot_region_matrix_pre_merge;
 		bool  b_plot_region_matrix_post_merge;
 		int i_screen_width;
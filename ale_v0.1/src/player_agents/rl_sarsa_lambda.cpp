@@ -17,19 +17,27 @@
  **************************************************************************** */
 
 #include <sstream>
+#include <ctime>
 // #include <math.h>
 #include "vector_matrix_tools.h"
 #include "rl_sarsa_lambda.h"
 #include "OSystem.hxx"
 #include "export_tools.h"
 #include "random_tools.h"
+#include "tiles2.h"
+
+#define LEARNER_RECORDS_PER_ACTOR 64	// Most transitions learn_from_actors()
+										// takes from one actor in one call
+
+RLSarsaLambda* RLSarsaLambda::p_actor_learner_instance = NULL;
 
 /* *********************************************************************
     Constructor
  ******************************************************************** */
 RLSarsaLambda::RLSarsaLambda(   OSystem* _osystem, int feature_vec_size, 
                                 int num_actions, float alpha, 
-                                int save_weights_freq) {
+                                int save_weights_freq, 
+                                int shared_base_length) {
     p_osystem = _osystem;
     i_feature_vec_size = feature_vec_size;
     i_save_weights_freq = save_weights_freq;
@@ -70,10 +78,6 @@ RLSarsaLambda::RLSarsaLambda(   OSystem* _osystem, int feature_vec_size,
 	pv_num_nonzero_in_f = NULL;
     i_episode_counter = 0;
 	i_frame_counter = 0;
-    float trace_vec_size_ratio = settings.getFloat("trace_vec_size_ratio",true);
-    i_max_nonzero_traces = (int)(feature_vec_size * trace_vec_size_ratio);
-    i_num_nonzero_traces = 0;
-    f_minimum_trace = settings.getFloat("minimum_trace_value", true);
     b_optimistic_init = settings.getBool("optimistic_init", true);
     float weight_init = 0.0;
     if (b_optimistic_init) {
@@ -82,28 +86,112 @@ RLSarsaLambda::RLSarsaLambda(   OSystem* _osystem, int feature_vec_size,
         weight_init = 1.0 / (float)feature_vec_size;
     } 
     
-    pv_weights = new FloatArr(i_feature_vec_size);
-    pv_traces = new FloatArr(i_feature_vec_size);
-    pv_nonzero_traces_inv_ind = new IntVect(i_feature_vec_size); 
-    for (int i = 0; i < i_feature_vec_size; i++ ) {
-        (*pv_weights)[i] = weight_init;
-        (*pv_traces)[i] = 0.0;
-        (*pv_nonzero_traces_inv_ind)[i] = -1;
+    string weights_storage = settings.getString("weights_storage", true);
+    pv_slot_features_map = NULL;
+    if (weights_storage == "dense") {
+        p_hash_table = NULL;
+        i_num_weights = i_feature_vec_size;
+    } else if (weights_storage == "hashed") {
+        // Memory is only spent on the hash-table, which should be sized for
+        // the features that are actually touched
+        i_num_weights = settings.getInt("hashed_weights_size", true);
+        bool safe = settings.getBool("hashed_weights_safe", true);
+        cout << "Hashing the " << i_feature_vec_size << " features into " 
+             << i_num_weights << " weights" 
+             << (safe ? " (probing on collisions)" : "") << endl;
+        p_hash_table = new collision_table(i_num_weights, safe ? 1 : 0);
+        pv_slot_features_map = new FeatureMap(num_actions);
+    } else {
+        cerr << "Invalid value for weights_storage: " << weights_storage << endl;
+        exit(-1);
+    }
+    // With several hogwild learning workers, the weights are shared by the
+    // forked worker processes, which update them without locks. With
+    // actor_learner, the learner keeps its own weights and publishes them
+    bool actor_learner = 
+            (settings.getString("learning_mode", true) == "actor_learner");
+    int num_workers = settings.getInt("num_learning_workers", true);
+    b_shared_weights = (num_workers > 1 && !actor_learner);
+    if ((num_workers > 1 || actor_learner) && p_hash_table != NULL) {
+        // Each worker would fill its own copy of the hash-table
+        cerr << "Hashed weights cannot be used with several learning workers"
+             << endl;
+        exit(-1);
     }
-    pv_nonzero_traces_ind = new IntVect(i_max_nonzero_traces);
-    for (int i = 0; i < i_max_nonzero_traces; i++) {
-        (*pv_nonzero_traces_ind)[i] = -1;
+    i_shared_base_length = shared_base_length;
+    b_interleaved_weights = false;
+    if (i_shared_base_length > 0 && p_hash_table == NULL &&
+        settings.getBool("interleave_action_weights", true)) {
+        assert(i_shared_base_length * i_num_actions == i_feature_vec_size);
+        b_interleaved_weights = true;
+        cout << "Interleaving the weights of the " << i_num_actions 
+             << " actions" << endl;
     }
+    // The running Q-sums would miss the updates of the other workers (or 
+    // the newly published weights)
+    b_incremental_q = (i_shared_base_length > 0 && p_hash_table == NULL &&
+                       !b_shared_weights && !actor_learner &&
+                       settings.getBool("incremental_q", true));
+    i_full_q_frq = settings.getInt("incremental_q_recompute_frq", true);
+    i_steps_since_full_q = 0;
+    b_q_sums_valid = false;
+    if (b_incremental_q) {
+        cout << "Updating the Q-values incrementally (recomputed every " 
+             << i_full_q_frq << " steps)" << endl;
+        v_q_sums.resize(i_num_actions, 0.0);
+        v_active_base.resize(i_shared_base_length, 0);
+    }
+    e_weights_precision = WeightVector::parse_precision(
+                                settings.getString("weights_precision", true));
+    double fixed_step = settings.getFloat("fixed_weights_step", true);
+    pv_weights = new WeightVector(i_num_weights, e_weights_precision, 
+                                  weight_init, fixed_step, b_shared_weights);
+    cout << "Weights vector: " << i_num_weights << " weights, " 
+         << pv_weights->get_num_bytes() << " bytes" << endl;
+    if (e_weights_precision == FIXED_16_PRECISION && 
+        fabs(weight_init) < fixed_step) {
+        cout << "Note: the initial weight is smaller than fixed_weights_step,"
+             << " and is rounded stochastically" << endl;
+    }
+    float trace_vec_size_ratio = settings.getFloat("trace_vec_size_ratio",true);
+    int max_nonzero_traces = min((int)(feature_vec_size * trace_vec_size_ratio),
+                                 i_num_weights);
+    p_traces = new TraceStore(i_num_weights, max_nonzero_traces, 
+                        settings.getFloat("minimum_trace_value", true));
     i_prev_action = -1;
 	b_normalize_fv = settings.getBool("normalize_feature_vector", true);
 	if (b_normalize_fv) {
 		cout << "Normalizing the Feature-Vec to sum up to 1.0" << endl;
 	}
+	string export_format = settings.getString("weights_export_format", true);
+	if (export_format != "text" && export_format != "binary") {
+		cerr << "Invalid value for weights_export_format: " << export_format
+			 << endl;
+		exit(-1);
+	}
+	b_binary_weights = (export_format == "binary");
+	p_checkpoint_writer = new WeightCheckpointWriter();
 	// See if we are importing the weights
 	string import_file = settings.getString("import_weights_file",  true);
 	if (import_file.size() > 0) {
 		cout << "Importing the weights vector from: << " << import_file << endl;
-		import_array(pv_weights, import_file);
+		import_weights(import_file);
+	}
+	pv_own_weights = pv_weights;
+	p_step_profile = NULL;
+	p_channel = NULL;
+	i_actor_id = -1;
+	i_learner_transitions = 0;
+	i_learner_episodes = 0;
+	i_publish_frq = settings.getInt("learner_publish_frq", true);
+	if (actor_learner) {
+		long long ring_bytes = settings.getInt("actor_ring_bytes", true);
+		cout << "Actor/learner mode: " << num_workers << " actors, " 
+			 << ring_bytes << " bytes per transition ring, weights published "
+			 << "every " << i_publish_frq << " transitions" << endl;
+		p_channel = new ActorLearnerChannel(num_workers, ring_bytes, 
+											pv_weights);
+		p_actor_learner_instance = this;
 	}
 }
 
@@ -111,10 +199,20 @@ RLSarsaLambda::RLSarsaLambda(   OSystem* _osystem, int feature_vec_size,
     Deconstructor
  ******************************************************************** */
 RLSarsaLambda::~RLSarsaLambda() {
-    delete pv_weights;
-    delete pv_traces;
-    delete pv_nonzero_traces_ind;
-    delete pv_nonzero_traces_inv_ind;
+    delete p_checkpoint_writer;     // waits for the pending checkpoint
+    delete pv_own_weights;
+    delete p_traces;
+    if (p_channel) {
+        delete p_channel;
+        for (unsigned int i = 0; i < v_actor_streams.size(); i++) {
+            delete v_actor_streams[i].p_traces;
+        }
+        p_actor_learner_instance = NULL;
+    }
+    if (p_hash_table) {
+        delete p_hash_table;
+        delete pv_slot_features_map;
+    }
 }
         
 /* *********************************************************************
@@ -125,10 +223,17 @@ RLSarsaLambda::~RLSarsaLambda() {
 int RLSarsaLambda::episode_start(   FeatureMap* new_feature_map, 
                                     IntVect* num_nonzero_in_f, 
 									int forced_action_ind) {
-    DecayTraces(0.0); 
-    pv_curr_features_map = new_feature_map;
+    if (p_channel) {
+        return actor_step(TRANSITION_START, new_feature_map, 
+                          num_nonzero_in_f, 0.0, forced_action_ind);
+    }
+    p_traces->decay(0.0); 
+    pv_curr_features_map = map_features_to_slots(new_feature_map, 
+                                                 num_nonzero_in_f);
     pv_num_nonzero_in_f = num_nonzero_in_f;
+    long long start = profile_start();
     computeActionValues(); 
+    profile_lap(start, PHASE_ACTION_VALUES);
 	if (forced_action_ind == -1) {	
 		i_prev_action = selectEpsilonGreedyAction();
 	} else {
@@ -155,10 +260,17 @@ int RLSarsaLambda::episode_step(FeatureMap* new_feature_map,
 								int forced_action_ind) {
     i_frame_counter++;
 	assert(i_prev_action != -1);
+	if (p_channel) {
+		return actor_step(TRANSITION_STEP, new_feature_map, num_nonzero_in_f, 
+						  new_reward, forced_action_ind);
+	}
 	double delta = new_reward - v_Q[i_prev_action];	
-	pv_curr_features_map = new_feature_map;
+	pv_curr_features_map = map_features_to_slots(new_feature_map, 
+                                                 num_nonzero_in_f);
     pv_num_nonzero_in_f =  num_nonzero_in_f;
+    long long start = profile_start();
 	computeActionValues();		 //new action values based on new observation
+	profile_lap(start, PHASE_ACTION_VALUES);
 	if (forced_action_ind == -1) {	
 		i_prev_action = selectEpsilonGreedyAction();
 	} else {
@@ -170,9 +282,13 @@ int RLSarsaLambda::episode_step(FeatureMap* new_feature_map,
 		cerr << "Delta = inf. :(" << endl;
 		exit(-1);
 	}
+    start = profile_start();
     updateWeights(delta);
+    start = profile_lap(start, PHASE_WEIGHTS);
     updateTraces();	
+    start = profile_lap(start, PHASE_TRACES);
     computeActionValues(i_prev_action);
+    profile_lap(start, PHASE_ACTION_VALUES);
 	return i_prev_action;
 }
     
@@ -184,9 +300,17 @@ int RLSarsaLambda::episode_step(FeatureMap* new_feature_map,
     final state:  S[end-1] -> a -> reward -> S[end]
  * ****************************************************************** */
 void RLSarsaLambda::episode_end(float reward, float value_of_final_state) {
-    double delta = reward - v_Q[i_prev_action];
-    delta += (f_gamma * value_of_final_state);  
-    updateWeights(delta);
+    if (p_channel) {
+        // The learner takes care of the update (and of the exports)
+        p_channel->push(i_actor_id, TRANSITION_END, i_prev_action, reward, 
+                        value_of_final_state, NULL, NULL, 0);
+    } else {
+        double delta = reward - v_Q[i_prev_action];
+        delta += (f_gamma * value_of_final_state);  
+        long long start = profile_start();
+        updateWeights(delta);
+        profile_lap(start, PHASE_WEIGHTS);
+    }
     i_episode_counter++;
 	if ((f_eps_dim_delta > 0.0 || f_eps_dim_delta < 0.0 ) && 
 		i_episode_counter > i_epsilon_dim_start) {
@@ -198,27 +322,217 @@ void RLSarsaLambda::episode_end(float reward, float value_of_final_state) {
 		cout << "epsilon updated to: " << f_epsilon << endl;
 	}
 
+	if (p_channel) {
+		return;
+	}
 	shrink_weights_vect(); // take care of shrinking the weights vector
+	if (p_hash_table) {
+		print_hashed_weights_stats();
+	}
 	
+    // The shared weights are exported by the first worker only
     if ((i_save_weights_freq != 0) &&  
-        (i_episode_counter % i_save_weights_freq == 0)) {
+        (i_episode_counter % i_save_weights_freq == 0) &&
+        p_osystem->settings().getInt("learning_worker_id", true) == 0) {
         cout << "Exporting the weights... ";
         ostringstream filename;
-        filename << "exported_weights__episode_" << i_episode_counter << ".txt";
+        filename << "exported_weights__episode_" << i_episode_counter 
+                 << (b_binary_weights ? ".bin" : ".txt");
         export_weights(filename.str());
         cout << "done." << endl;
     }
 }
 
+/* *********************************************************************
+    Returns a monotonic time, in nanoseconds (for the profiling)
+ ******************************************************************** */
+long long RLSarsaLambda::profile_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/* *********************************************************************
+    Actor side of the actor_learner mode: chooses the action for the 
+    given state from the published weights, and sends the transition
+    (of the given type) to the learner
+ ******************************************************************** */
+int RLSarsaLambda::actor_step(int type, FeatureMap* new_feature_map, 
+                              IntVect* num_nonzero_in_f, float new_reward, 
+                              int forced_action_ind) {
+    if (i_actor_id == -1) {
+        // Actors are the workers 1 to num_learning_workers
+        i_actor_id = p_osystem->settings().getInt("learning_worker_id") - 1;
+        assert(i_actor_id >= 0 && i_actor_id < p_channel->get_num_actors());
+        // Only the learner updates its own weights: the actors read the
+        // published snapshots, so the copy we inherited is released
+        delete pv_own_weights;
+        pv_own_weights = NULL;
+    }
+    pv_weights = p_channel->get_snapshot();
+    pv_curr_features_map = new_feature_map;
+    pv_num_nonzero_in_f = num_nonzero_in_f;
+    computeActionValues();
+	if (forced_action_ind == -1) {	
+		i_prev_action = selectEpsilonGreedyAction();
+	} else {
+		i_prev_action = forced_action_ind;
+	}
+    // With shared base features, the features of action 0 are enough
+    int num_lists = (i_shared_base_length > 0) ? 1 : i_num_actions;
+    p_channel->push(i_actor_id, type, i_prev_action, new_reward, 0.0, 
+                    pv_curr_features_map, pv_num_nonzero_in_f, num_lists);
+	return i_prev_action;
+}
+
+/* *********************************************************************
+    Learner side of the actor_learner mode: applies the SARSA(lambda)
+    updates for the transitions waiting in the rings of the actors 
+    (a bounded number per actor, so that no actor is starved), and 
+    publishes the weights every i_publish_frq transitions.
+    Returns the number of transitions processed
+ ******************************************************************** */
+int RLSarsaLambda::learn_from_actors(void) {
+    // Keep our own state (in case this process also acts)
+    WeightVector* own_weights = pv_weights;
+    TraceStore* own_traces = p_traces;
+    FeatureMap* own_features_map = pv_curr_features_map;
+    IntVect* own_num_nonzero = pv_num_nonzero_in_f;
+    int own_prev_action = i_prev_action;
+    FloatVect own_Q = v_Q;
+    pv_weights = pv_own_weights;
+    int num_transitions = 0;
+    for (int actor = 0; actor < p_channel->get_num_actors(); actor++) {
+        for (int k = 0; k < LEARNER_RECORDS_PER_ACTOR; k++) {
+            if (!p_channel->pop(actor, v_record)) {
+                break;
+            }
+            learn_from_record(actor, v_record);
+            num_transitions++;
+            i_learner_transitions++;
+            if (i_learner_transitions % i_publish_frq == 0) {
+                p_channel->publish(pv_weights);
+            }
+        }
+    }
+    pv_weights = own_weights;
+    p_traces = own_traces;
+    pv_curr_features_map = own_features_map;
+    pv_num_nonzero_in_f = own_num_nonzero;
+    i_prev_action = own_prev_action;
+    v_Q = own_Q;
+    return num_transitions;
+}
+
+/* *********************************************************************
+    Learner side: applies one transition record of the given actor.
+    The steps are the same as in episode_start, episode_step and 
+    episode_end, with the actions chosen by the actor
+ ******************************************************************** */
+void RLSarsaLambda::learn_from_record(int actor, const IntVect& record) {
+    if ((int)v_actor_streams.size() <= actor) {
+        v_actor_streams.resize(actor + 1);
+    }
+    ActorStream& stream = v_actor_streams[actor];
+    if (stream.p_traces == NULL) {
+        stream.p_traces = new TraceStore(i_num_weights, 
+                    p_traces->get_max_traces(),
+                    p_osystem->settings().getFloat("minimum_trace_value", true));
+        stream.features.resize(i_num_actions);
+        stream.num_nonzero.resize(i_num_actions, 0);
+    }
+    p_traces = stream.p_traces;
+    int type = record[RECORD_TYPE];
+    float reward = ActorLearnerChannel::int_bits_to_float(record[RECORD_REWARD]);
+    if (type == TRANSITION_END) {
+        double delta = reward - stream.prev_q;
+        delta += f_gamma * ActorLearnerChannel::int_bits_to_float(
+                                                record[RECORD_FINAL_VALUE]);
+        updateWeights(delta);
+        i_learner_episodes++;
+        if ((i_save_weights_freq != 0) &&  
+            (i_learner_episodes % i_save_weights_freq == 0)) {
+            cout << "Exporting the weights... ";
+            ostringstream filename;
+            filename << "exported_weights__episode_" << i_learner_episodes 
+                     << (b_binary_weights ? ".bin" : ".txt");
+            export_weights(filename.str());
+            cout << "done." << endl;
+        }
+        return;
+    }
+    // Unpack the features of the new state
+    int pos = RECORD_HEADER_INTS;
+    for (int l = 0; l < record[RECORD_NUM_LISTS]; l++) {
+        int num_features = record[pos++];
+        IntArr& features = stream.features[l];
+        if ((int)features.size() < num_features) {
+            features.resize(num_features);
+        }
+        for (int j = 0; j < num_features; j++) {
+            features[j] = record[pos++];
+        }
+        stream.num_nonzero[l] = num_features;
+    }
+    if (record[RECORD_NUM_LISTS] == 1) {
+        // Shared base: action a has the features of action 0, shifted
+        int num_features = stream.num_nonzero[0];
+        for (int a = 1; a < i_num_actions; a++) {
+            IntArr& features = stream.features[a];
+            if ((int)features.size() < num_features) {
+                features.resize(num_features);
+            }
+            for (int j = 0; j < num_features; j++) {
+                features[j] = stream.features[0][j] + a * i_shared_base_length;
+            }
+            stream.num_nonzero[a] = num_features;
+        }
+    }
+    pv_curr_features_map = &stream.features;
+    pv_num_nonzero_in_f = &stream.num_nonzero;
+    i_prev_action = record[RECORD_ACTION];
+    if (type == TRANSITION_START) {
+        p_traces->decay(0.0);
+    } else {
+        double delta = reward - stream.prev_q;
+        computeActionValues(i_prev_action);
+        delta += f_gamma * v_Q[i_prev_action];
+        updateWeights(delta);
+        updateTraces();
+    }
+    computeActionValues(i_prev_action);
+    stream.prev_q = v_Q[i_prev_action];
+    stream.prev_action = i_prev_action;
+}
+
 /* *********************************************************************
    Compute all the action values from current activeFeatures and weights
  * ****************************************************************** */
 void RLSarsaLambda::computeActionValues() {
+	if (b_incremental_q) {
+		update_q_sums();
+		for (int a = 0; a < i_num_actions; a++) {
+			computeActionValues(a);
+		}
+		return;
+	}
+	if (b_interleaved_weights) {
+		// All actions share the base features (i.e. the features of 
+		// action 0), so one pass over them computes all the Q-values
+		int num_base_features = (*pv_num_nonzero_in_f)[0];
+		pv_weights->sum_rows((*pv_curr_features_map)[0], num_base_features, 
+							 i_num_actions, v_Q);
+		for (int a = 0; a < i_num_actions; a++) {
+			assert((*pv_num_nonzero_in_f)[a] == num_base_features);
+			if (b_normalize_fv) {
+				v_Q[a] = v_Q[a] / float(num_base_features);
+			}
+		}
+		return;
+	}
 	for (int a = 0; a < i_num_actions; a++) {
-		v_Q[a] = 0;
-		for (int j = 0; j < (*pv_num_nonzero_in_f)[a]; j++) {
-			v_Q[a] += (*pv_weights)[(*pv_curr_features_map)[a][j]];
-        }
+		v_Q[a] = pv_weights->sum((*pv_curr_features_map)[a], 
+								 (*pv_num_nonzero_in_f)[a]);
 		if (b_normalize_fv) {
 			v_Q[a] = v_Q[a] / float((*pv_num_nonzero_in_f)[a]);
 		}
@@ -230,10 +544,22 @@ void RLSarsaLambda::computeActionValues() {
     weights
  * ****************************************************************** */
 void RLSarsaLambda::computeActionValues(int a) {
-	v_Q[a] = 0;
-    for (int j = 0; j < (*pv_num_nonzero_in_f)[a]; j++) { 
-		v_Q[a] += (*pv_weights)[(*pv_curr_features_map)[a][j]];
-    }
+	if (b_incremental_q) {
+		// v_q_sums already follows the weight changes
+		assert((*pv_num_nonzero_in_f)[a] == (*pv_num_nonzero_in_f)[0]);
+		v_Q[a] = v_q_sums[a];
+		if (b_normalize_fv) {
+			v_Q[a] = v_Q[a] / float((*pv_num_nonzero_in_f)[a]);
+		}
+		return;
+	}
+	if (b_interleaved_weights) {
+		v_Q[a] = pv_weights->sum((*pv_curr_features_map)[0], 
+								 (*pv_num_nonzero_in_f)[0], i_num_actions, a);
+	} else {
+		v_Q[a] = pv_weights->sum((*pv_curr_features_map)[a], 
+								 (*pv_num_nonzero_in_f)[a]);
+	}
 	if (b_normalize_fv) {
 		v_Q[a] = v_Q[a] / float((*pv_num_nonzero_in_f)[a]);
 	}
@@ -287,17 +613,31 @@ int RLSarsaLambda::selectEpsilonGreedyAction() {
     traces and replace current trace
  * ****************************************************************** */
 void RLSarsaLambda::updateTraces() {
-	DecayTraces(f_gamma * f_lambda);                              
+	p_traces->decay(f_gamma * f_lambda);                              
+	if (b_interleaved_weights) {
+		// Same as below, walking the contiguous slots of each base feature
+		for (int j = 0; j < (*pv_num_nonzero_in_f)[0]; j++) {
+			int first_slot = (*pv_curr_features_map)[0][j] * i_num_actions;
+			for (int a = 0; a < i_num_actions; a++) {
+				if (a == i_prev_action) {
+					p_traces->set(first_slot + a, 1.0);	// replace traces
+				} else {
+					p_traces->clear(first_slot + a);
+				}
+			}
+		}
+		return;
+	}
 	for (int a = 0; a < i_num_actions; a++) { 
 		if (a != i_prev_action) {
 			for (int j = 0; j < (*pv_num_nonzero_in_f)[a]; j++) {
-                ClearTrace((*pv_curr_features_map)[a][j]);
+                p_traces->clear((*pv_curr_features_map)[a][j]);
             }
         }
     }
     for (int j = 0; j < (*pv_num_nonzero_in_f)[i_prev_action]; j++) {
         // replace traces
-        SetTrace((*pv_curr_features_map)[i_prev_action][j], 1.0); 
+        p_traces->set((*pv_curr_features_map)[i_prev_action][j], 1.0); 
     }
 }
 
@@ -307,34 +647,46 @@ void RLSarsaLambda::updateTraces() {
 void RLSarsaLambda::updateWeights(double delta) {
 	assert(f_alpha >= 0);
 	double temp = f_alpha * delta;
-	for (int i = 0; i < i_num_nonzero_traces; i++) { 
-		int index = (*pv_nonzero_traces_ind)[i];
-		(*pv_weights)[index] += (temp * (*pv_traces)[index]);
+	if (b_incremental_q) {
+		const int* slots = p_traces->get_slots();
+		const float* traces = p_traces->get_values();
+		for (int i = 0; i < p_traces->size(); i++) {
+			double old_weight = pv_weights->get(slots[i]);
+			pv_weights->add(slots[i], temp * traces[i]);
+			on_weight_change(slots[i], pv_weights->get(slots[i]) - old_weight);
+		}
+		return;
 	}
+	pv_weights->add_scaled(p_traces->get_slots(), p_traces->get_values(), 
+						   p_traces->size(), temp);
     // print_largest_weight();
 }
 
 /* *********************************************************************
     This is for debugging only: prints the largest (+/-) value in 
-    pv_weights and pv_traces
+    pv_weights and p_traces
  * ****************************************************************** */
 void RLSarsaLambda::print_largest_weight(void) {
     double largest_weight = 0;
     double smallest_weight = 0;
     double largest_trace = 0;
     double smallest_trace = 0;
-	for (int i = 0; i < i_feature_vec_size; i++) { 
-        if ((*pv_weights)[i] > largest_weight) {
-            largest_weight = (*pv_weights)[i];
+	for (int i = 0; i < i_num_weights; i++) { 
+        double weight = pv_weights->get(i);
+        if (weight > largest_weight) {
+            largest_weight = weight;
         }
-        if ((*pv_weights)[i] < smallest_weight) {
-            smallest_weight = (*pv_weights)[i];
+        if (weight < smallest_weight) {
+            smallest_weight = weight;
         }
-        if ((*pv_traces)[i] > largest_trace) {
-            largest_trace = (*pv_traces)[i];
+	}
+	for (int i = 0; i < p_traces->size(); i++) {
+        double trace = p_traces->get_values()[i];
+        if (trace > largest_trace) {
+            largest_trace = trace;
         }
-        if ((*pv_traces)[i] < smallest_trace) {
-            smallest_trace = (*pv_traces)[i];
+        if (trace < smallest_trace) {
+            smallest_trace = trace;
         }
 	}
     cout << "Largest Weight: " << largest_weight << " - ";
@@ -345,80 +697,31 @@ void RLSarsaLambda::print_largest_weight(void) {
 }
 
 /* *********************************************************************
-    clear or zero-out trace, if any, for given feature
- * ****************************************************************** */
-void RLSarsaLambda::ClearTrace(int f) {
-	if (!((*pv_traces)[f] == 0.0)) {
-        ClearExistentTrace(f, (*pv_nonzero_traces_inv_ind)[f]);
-    }
-}
-
-/* *********************************************************************
-    clear trace at given location in list of nonzero-traces
- * ****************************************************************** */
-void RLSarsaLambda::ClearExistentTrace(int f, int loc) { 
-    (*pv_traces)[f] = 0.0;
-    i_num_nonzero_traces--;
-    (*pv_nonzero_traces_ind)[loc] = (*pv_nonzero_traces_ind)[i_num_nonzero_traces];
-    (*pv_nonzero_traces_inv_ind)[(*pv_nonzero_traces_ind)[loc]] = loc;
-}
-
-/* *********************************************************************
-    Decay all nonzero traces
- * ****************************************************************** */
-void RLSarsaLambda::DecayTraces(float decay_rate) {
-	for (int loc = i_num_nonzero_traces - 1; loc >= 0; loc--) { 
-		int f = (*pv_nonzero_traces_ind)[loc];
-        (*pv_traces)[f] *= decay_rate;
-        if ((*pv_traces)[f] < f_minimum_trace) {
-            ClearExistentTrace(f, loc);
-        }
-	}
-}         
-
-/* *********************************************************************
-    set trace to given value
+   Saves the weights vector to file
  * ****************************************************************** */
-void RLSarsaLambda::SetTrace(int f, float new_trace_value) {
-    if ((*pv_traces)[f] >= f_minimum_trace) {
-        (*pv_traces)[f] = new_trace_value;         // trace already exists
-    } else { 
-        while (i_num_nonzero_traces >= i_max_nonzero_traces) {
-            IncreaseMinTrace(); // ensure room for new trace
-        }
-        (*pv_traces)[f] = new_trace_value;
-        (*pv_nonzero_traces_ind)[i_num_nonzero_traces] = f;
-        (*pv_nonzero_traces_inv_ind)[f] = i_num_nonzero_traces;
-        i_num_nonzero_traces++;
+void RLSarsaLambda::export_weights(const string& filename) {
+    if (b_binary_weights) {
+        p_checkpoint_writer->write(pv_weights, i_num_actions, 
+                    b_interleaved_weights ? i_shared_base_length : 0, 
+                    p_hash_table, filename);
+        return;
     }
-}
-
-/* *********************************************************************
-    Try to make room for more traces by incrementing minimum_trace by 10%, 
-    culling any traces that fall below the new minimum
- * ****************************************************************** */
-void RLSarsaLambda::IncreaseMinTrace() {
-    f_minimum_trace += (0.1 * f_minimum_trace);
-    for (int loc = i_num_nonzero_traces - 1; loc >= 0; loc--) {
-        int f = (*pv_nonzero_traces_ind)[loc];
-        if ( (*pv_traces)[f] < f_minimum_trace) {
-            ClearExistentTrace(f, loc);
+    export_hash_table(filename);
+    FloatArr weights(i_num_weights);
+    if (b_interleaved_weights) {
+        // The file is in feature order, whatever the layout
+        for (int f = 0; f < i_num_weights; f++) {
+            weights[f] = pv_weights->get(get_weight_slot(f));
         }
+    } else {
+        pv_weights->to_array(weights);
     }
-}
-
-
-
-/* *********************************************************************
-   Saves the weights vector to file
- * ****************************************************************** */
-void RLSarsaLambda::export_weights(const string& filename) {
-    export_array(pv_weights, filename);
+    export_array(&weights, filename);
     for (unsigned int i = 0; i < 10; i++) {
-        cout << (*pv_weights)[i] << ", ";
+        cout << weights[i] << ", ";
     }
     for (unsigned int i = 1; i <= 10; i++) {
-        cout << (*pv_weights)[pv_weights->size() - i] << ", ";
+        cout << weights[weights.size() - i] << ", ";
     }
 }
 
@@ -426,18 +729,104 @@ void RLSarsaLambda::export_weights(const string& filename) {
    Loads the weights vector from file
  * ****************************************************************** */
 void RLSarsaLambda::import_weights(const string& filename) {
-    import_array(pv_weights, filename);
+    if (is_weight_checkpoint(filename)) {
+        load_weight_checkpoint(filename, pv_weights, i_num_actions, 
+                    b_interleaved_weights ? i_shared_base_length : 0, 
+                    p_hash_table);
+    } else {
+        import_hash_table(filename);
+        FloatArr weights(i_num_weights);
+        import_array(&weights, filename);
+        if (b_interleaved_weights) {
+            for (int f = 0; f < i_num_weights; f++) {
+                pv_weights->set(get_weight_slot(f), weights[f]);
+            }
+        } else {
+            pv_weights->from_array(weights);
+        }
+    }
+    b_q_sums_valid = false;
     cout << "Weights Vector importd fromfile" + filename << endl;
     cout << "First 10 values: ";
     for (int i = 0; i < 10; i++) {
-        cout << (*pv_weights)[i] << ", ";
+        cout << pv_weights->get(i) << ", ";
     }
     cout << endl << "Last 10 values: ";
     for (int i = 1; i <= 10; i++) {
-        cout << (*pv_weights)[pv_weights->size() - i] << ", ";
+        cout << pv_weights->get(pv_weights->size() - i) << ", ";
     }
 }
 
+/* *********************************************************************
+	Brings v_q_sums up to date with the current base features (the 
+	features of action 0), by adding the weights of the features 
+	that became active and subtracting those of the features that 
+	are no longer active. A feature can be in the list more than once 
+	(e.g. two ClassAgent instances in one tile), and then counts once 
+	per copy. Every i_full_q_frq steps, or when the sums are not valid, 
+	the sums are recomputed from scratch instead.
+ * ****************************************************************** */
+void RLSarsaLambda::update_q_sums(void) {
+	const IntArr& new_features = (*pv_curr_features_map)[0];
+	int num_new = (*pv_num_nonzero_in_f)[0];
+	int num_old = v_active_base_list.size();
+	if (!b_q_sums_valid || i_steps_since_full_q >= i_full_q_frq) {
+		for (int j = 0; j < num_old; j++) {
+			v_active_base[v_active_base_list[j]] = 0;
+		}
+		v_active_base_list.resize(num_new);
+		for (int a = 0; a < i_num_actions; a++) {
+			v_q_sums[a] = 0;
+		}
+		for (int j = 0; j < num_new; j++) {
+			int f = new_features[j];
+			v_active_base_list[j] = f;
+			v_active_base[f]++;
+			add_base_feature_to_q_sums(f, 1.0);
+		}
+		b_q_sums_valid = true;
+		i_steps_since_full_q = 0;
+		return;
+	}
+	i_steps_since_full_q++;
+	// v_active_base becomes the old count minus the new count. Each 
+	// feature is then added once with that difference, and zeroed
+	for (int j = 0; j < num_new; j++) {
+		v_active_base[new_features[j]]--;
+	}
+	for (int j = 0; j < num_old; j++) {
+		int f = v_active_base_list[j];
+		if (v_active_base[f] != 0) {
+			add_base_feature_to_q_sums(f, -v_active_base[f]);
+			v_active_base[f] = 0;
+		}
+	}
+	for (int j = 0; j < num_new; j++) {
+		int f = new_features[j];
+		if (v_active_base[f] != 0) {
+			add_base_feature_to_q_sums(f, -v_active_base[f]);
+			v_active_base[f] = 0;
+		}
+	}
+	v_active_base_list.resize(num_new);
+	for (int j = 0; j < num_new; j++) {
+		int f = new_features[j];
+		v_active_base_list[j] = f;
+		v_active_base[f]++;
+	}
+}
+
+/* *********************************************************************
+	Adds sign * the weights of base feature f to v_q_sums 
+ * ****************************************************************** */
+void RLSarsaLambda::add_base_feature_to_q_sums(int f, double sign) {
+	for (int a = 0; a < i_num_actions; a++) {
+		int slot = b_interleaved_weights ? f * i_num_actions + a : 
+										   a * i_shared_base_length + f;
+		v_q_sums[a] += sign * pv_weights->get(slot);
+	}
+}
+
 /* *********************************************************************
 	Takes care of shrinking the weights-vector (when it is enabled)
  * ****************************************************************** */
@@ -446,9 +835,11 @@ void RLSarsaLambda::shrink_weights_vect(void) {
 		(i_episode_counter % i_shrink_weights_frq != 0)) {
 		return;
 	}
+	FloatArr weights;
+	pv_weights->to_array(weights);
 	int num_non_zero = 0;
-	for (unsigned int i = 0; i < pv_weights->size(); i++) {
-		if ((*pv_weights)[i] != 0.0) {
+	for (unsigned int i = 0; i < weights.size(); i++) {
+		if (weights[i] != 0.0) {
 			num_non_zero++;
 		}
 	}
@@ -467,24 +858,180 @@ void RLSarsaLambda::shrink_weights_vect(void) {
 	}
 	
 	cout << "Had " << num_non_zero << " non-zero values in w.";
-	shrink_array(pv_weights, num_vals_to_keep);
+	shrink_array(&weights, num_vals_to_keep);
+	pv_weights->from_array(weights);
+	b_q_sums_valid = false;
 	num_non_zero = 0;
-	for (unsigned int i = 0; i < pv_weights->size(); i++) {
-		if ((*pv_weights)[i] != 0) {
+	for (unsigned int i = 0; i < weights.size(); i++) {
+		if (weights[i] != 0) {
 			num_non_zero++;
 		}
 	}
 	cout << "Kept " << num_non_zero << " values." << endl;
 }
 
+/* *********************************************************************
+	Returns the slot of the given feature in the weights vector. 
+	This is the feature itself, unless the weights are hashed or
+	interleaved
+ * ****************************************************************** */
+int RLSarsaLambda::get_weight_slot(int feature) {
+	if (b_interleaved_weights) {
+		return (feature % i_shared_base_length) * i_num_actions + 
+				feature / i_shared_base_length;
+	}
+	if (p_hash_table == NULL) {
+		return feature;
+	}
+	// hash_UNH only looks at each int modulo 2048, so we split the feature
+	// index into 11-bit digits
+	int digits[3];
+	digits[0] = feature & 0x7FF;
+	digits[1] = (feature >> 11) & 0x7FF;
+	digits[2] = feature >> 22;
+	return ::hash(digits, 3, p_hash_table);
+}
+
+/* *********************************************************************
+	Returns the given feature-map, with every feature index replaced
+	by its slot in the weights vector. With the dense storage the 
+	given map itself is returned.
+ * ****************************************************************** */
+FeatureMap* RLSarsaLambda::map_features_to_slots(FeatureMap* feature_map, 
+												 IntVect* num_nonzero_in_f) {
+	if (p_hash_table == NULL) {
+		return feature_map;
+	}
+	for (int a = 0; a < i_num_actions; a++) {
+		int num_features = (*num_nonzero_in_f)[a];
+		IntArr& slots = (*pv_slot_features_map)[a];
+		if ((int)slots.size() < num_features) {
+			slots.resize((*feature_map)[a].size());
+		}
+		for (int j = 0; j < num_features; j++) {
+			slots[j] = get_weight_slot((*feature_map)[a][j]);
+		}
+	}
+	return pv_slot_features_map;
+}
+
+/* *********************************************************************
+	Prints the usage and collision statistics of the hashed weights
+ * ****************************************************************** */
+void RLSarsaLambda::print_hashed_weights_stats(void) {
+	cout << "Hashed weights: " << p_hash_table->usage() << " of " 
+		 << p_hash_table->m << " slots used, " 
+		 << p_hash_table->calls << " lookups, "
+		 << p_hash_table->collisions << " collisions" << endl;
+}
+
+/* *********************************************************************
+   Returns/Sets the weight of the given feature. These work with all
+   the weights storages and precisions
+ * ****************************************************************** */
+double RLSarsaLambda::get_feature_weight(int feature) {
+	return pv_weights->get(get_weight_slot(feature));
+}
+
+void RLSarsaLambda::set_feature_weight(int feature, double weight) {
+	pv_weights->set(get_weight_slot(feature), weight);
+	b_q_sums_valid = false;
+}
+
+/* *********************************************************************
+	Sets every weight to the given value
+ * ****************************************************************** */
+void RLSarsaLambda::set_all_weights(double weight) {
+	for (int i = 0; i < i_num_weights; i++) {
+		pv_weights->set(i, weight);
+	}
+	b_q_sums_valid = false;
+}
+
+/* *********************************************************************
+	Saves the size, the mode and (in safe mode) the keys of the hash-table
+	of the hashed weights to <weights_filename>.hash
+ * ****************************************************************** */
+void RLSarsaLambda::export_hash_table(const string& weights_filename) {
+	if (p_hash_table == NULL) {
+		return;
+	}
+	string filename = weights_filename + ".hash";
+	ofstream file(filename.c_str());
+	file << "hashed," << p_hash_table->m << "," << p_hash_table->safe << endl;
+	if (p_hash_table->safe) {
+		for (int i = 0; i < p_hash_table->m; i++) {
+			file << p_hash_table->data[i] << ",";
+		}
+		file << endl;
+	}
+	if (!file) {
+		cerr << "Failed to write the hash-table " << filename << endl;
+	}
+}
+
+/* *********************************************************************
+	Checks that <weights_filename>.hash matches our storage, and restores 
+	the keys of the hash-table from it. Exits when it does not match
+ * ****************************************************************** */
+void RLSarsaLambda::import_hash_table(const string& weights_filename) {
+	string filename = weights_filename + ".hash";
+	ifstream file(filename.c_str());
+	if (p_hash_table == NULL) {
+		if (file) {
+			cerr << weights_filename << " holds hashed weights, and "
+				 << "weights_storage is dense" << endl;
+			exit(-1);
+		}
+		return;
+	}
+	string storage;
+	long size = 0;
+	int safe = -1;
+	char delim;
+	if (!file || !getline(file, storage, ',') || storage != "hashed" ||
+		!(file >> size >> delim >> safe)) {
+		cerr << "Cannot read " << filename << ": the weights in " 
+			 << weights_filename << " cannot be used as hashed weights" << endl;
+		exit(-1);
+	}
+	if (size != p_hash_table->m || safe != p_hash_table->safe) {
+		cerr << weights_filename << " holds hashed weights with " << size 
+			 << " slots (safe = " << safe << "), expected " 
+			 << p_hash_table->m << " slots (safe = " << p_hash_table->safe 
+			 << ")" << endl;
+		exit(-1);
+	}
+	p_hash_table->reset();
+	for (int i = 0; safe && i < size; i++) {
+		if (!(file >> p_hash_table->data[i] >> delim)) {
+			cerr << filename << " is truncated" << endl;
+			exit(-1);
+		}
+	}
+}
+
+/* *********************************************************************
+	Returns the precision for the per-feature step-size vectors of 
+	the subclasses: the weights precision, except that fixed-point 
+	weights get single precision step-sizes
+ * ****************************************************************** */
+WeightPrecision RLSarsaLambda::get_aux_precision(void) const {
+	if (e_weights_precision == FIXED_16_PRECISION) {
+		return SINGLE_PRECISION;
+	}
+	return e_weights_precision;
+}
+
 /* *********************************************************************
 	Generates an instance of one of the RLSarsaLambda subclasses, based 
 	on the values of use_idbd and use_delta_bar_delta 
+	See the constructor for shared_base_length
 	Note: The caller is resposible for deleting the returned pointer
 ******************************************************************** */
 RLSarsaLambda* RLSarsaLambda::generate_rl_sarsa_lambda_instance(
 							OSystem* _osystem, int feature_vec_size,
-							int num_actions) {
+							int num_actions, int shared_base_length) {
 	Settings& settings = _osystem->settings();
     float alpha_multiplier = settings.getFloat("alpha_multiplier", true);
 	float alpha = settings.getFloat("alpha", true);
@@ -520,19 +1067,22 @@ RLSarsaLambda* RLSarsaLambda::generate_rl_sarsa_lambda_instance(
 													feature_vec_size, 
 													num_actions, 
 													eps_start, k, phi, theta, 
-													exp_w_frq);		
+													exp_w_frq, 
+													shared_base_length);		
 	} else if (use_idbd) {
 		cout << "Using iDBD. " << endl ;
 		sarsa_lambda_solver = new RLSarsaLambdaWithIDBD(_osystem, 
 														feature_vec_size,  
 														num_actions, 
-														exp_w_frq);
+														exp_w_frq, 
+														shared_base_length);
 	} else {
 		cout << "Using static Alpha. " << endl ;
 		sarsa_lambda_solver = new RLSarsaLambda(  _osystem, 
 													feature_vec_size, 
 													num_actions, alpha, 
-													exp_w_frq);
+													exp_w_frq, 
+													shared_base_length);
 	}
 	return sarsa_lambda_solver;
 
@@ -554,18 +1104,17 @@ RLSarsaLambda* RLSarsaLambda::generate_rl_sarsa_lambda_instance(
  ******************************************************************** */
 RLSarsaLambdaWithIDBD::RLSarsaLambdaWithIDBD(	OSystem* _osystem, 
 						int feature_vec_size,  int num_actions,  
-						int save_weights_freq) : 
+						int save_weights_freq, int shared_base_length) : 
 						RLSarsaLambda(	_osystem, feature_vec_size, num_actions, 
-										-1.0, save_weights_freq)  {
+										-1.0, save_weights_freq, 
+										shared_base_length)  {
 	Settings& settings = p_osystem->settings();
     f_theta = settings.getFloat("theta", true);
 	cout << "Theta (iDBD meta-learning rate) = " << f_theta << endl;
-    pv_h = new FloatArr(i_feature_vec_size);
-    pv_beta = new FloatArr(i_feature_vec_size);
-    for (int i = 0; i < i_feature_vec_size; i++ ) {
-        (*pv_h)[i] = 0;
-        (*pv_beta)[i] = 0;
-    }
+    pv_h = new WeightVector(i_num_weights, get_aux_precision(), 0.0, 
+                            1.0 / 1024, b_shared_weights);
+    pv_beta = new WeightVector(i_num_weights, get_aux_precision(), 0.0, 
+                               1.0 / 1024, b_shared_weights);
 }
 
 /* *********************************************************************
@@ -582,18 +1131,25 @@ RLSarsaLambdaWithIDBD::~RLSarsaLambdaWithIDBD() {
  * ****************************************************************** */
 void RLSarsaLambdaWithIDBD::updateWeights(double delta) {
 	double alpha, decay;
-	for (int i = 0; i < i_num_nonzero_traces; i++) {
-		int index = (*pv_nonzero_traces_ind)[i];
-		(*pv_beta)[index] += (	f_theta * delta * (*pv_traces)[index] * 
-								(*pv_h)[index]	);	
-		alpha = pow(M_E, (*pv_beta)[index]);
-		decay = 1.0 - (alpha * (*pv_traces)[index] * (*pv_traces)[index]);
+	const int* slots = p_traces->get_slots();
+	const float* traces = p_traces->get_values();
+	for (int i = 0; i < p_traces->size(); i++) {
+		int index = slots[i];
+		double trace = traces[i];
+		double h = pv_h->get(index);
+		pv_beta->add(index, f_theta * delta * trace * h);	
+		alpha = pow(M_E, pv_beta->get(index));
+		decay = 1.0 - (alpha * trace * trace);
 		if (decay < 0) {
 			decay = 0;
 		}
-		decay = decay * (*pv_h)[index];
-		(*pv_h)[index] = decay + alpha * delta * (*pv_traces)[index];
-		(*pv_weights)[index] += (alpha * delta * (*pv_traces)[index]);
+		decay = decay * h;
+		pv_h->set(index, decay + alpha * delta * trace);
+		double old_weight = pv_weights->get(index);
+		pv_weights->add(index, alpha * delta * trace);
+		if (b_incremental_q) {
+			on_weight_change(index, pv_weights->get(index) - old_weight);
+		}
 	}
 }
 
@@ -616,18 +1172,16 @@ void RLSarsaLambdaWithIDBD::updateWeights(double delta) {
 RLSarsaLambdaWithDeltaBarDelta::RLSarsaLambdaWithDeltaBarDelta(
 		OSystem* _osystem, int feature_vec_size, 
 		int num_actions, double eps_start, double k, double phi, double theta,
-		int save_weights_freq) : 
+		int save_weights_freq, int shared_base_length) : 
 		RLSarsaLambda(	_osystem, feature_vec_size, num_actions, 
-		-1.0, save_weights_freq)  {
+		-1.0, save_weights_freq, shared_base_length)  {
 	f_k = k;
 	f_phi = phi;
 	f_theta = theta;
-	pv_eps = new FloatArr(i_feature_vec_size);
-    pv_delta_bar = new FloatArr(i_feature_vec_size);
-    for (int i = 0; i < i_feature_vec_size; i++ ) {
-        (*pv_eps)[i] = eps_start;
-        (*pv_delta_bar)[i] = 0.0;
-    }
+	pv_eps = new WeightVector(i_num_weights, get_aux_precision(), eps_start,
+							  1.0 / 1024, b_shared_weights);
+    pv_delta_bar = new WeightVector(i_num_weights, get_aux_precision(), 0.0,
+                                    1.0 / 1024, b_shared_weights);
 
 }
 /* *********************************************************************
@@ -643,24 +1197,33 @@ RLSarsaLambdaWithDeltaBarDelta::~RLSarsaLambdaWithDeltaBarDelta() {
  * ****************************************************************** */
 void RLSarsaLambdaWithDeltaBarDelta::updateWeights(double delta) {
 	double new_delta, delta_bar_delta;
-	for (int i = 0; i < i_num_nonzero_traces; i++) {
-		int index = (*pv_nonzero_traces_ind)[i];
+	const int* slots = p_traces->get_slots();
+	const float* traces = p_traces->get_values();
+	for (int i = 0; i < p_traces->size(); i++) {
+		if (traces[i] == 0.0f) {
+			continue;	// cleared trace, which would still decay delta_bar
+		}
+		int index = slots[i];
 		// 1- Compute delta 
-		new_delta =  delta * (*pv_traces)[index];
+		new_delta =  delta * traces[i];
 		
 		// 2- Update epsilon
-		delta_bar_delta = new_delta * (*pv_delta_bar)[index];
+		delta_bar_delta = new_delta * pv_delta_bar->get(index);
 		if (delta_bar_delta > 0) {
-			(*pv_eps)[index] += f_k;
+			pv_eps->add(index, f_k);
 		} else if (delta_bar_delta < 0) {
-			(*pv_eps)[index] -= f_phi * (*pv_eps)[index];
+			pv_eps->add(index, -f_phi * pv_eps->get(index));
 		}
 		
 		// 3- Update delta-bar
-		(*pv_delta_bar)[index] = ((1 - f_theta) * new_delta) + 
-							 (f_theta * (*pv_delta_bar)[index]);
+		pv_delta_bar->set(index, ((1 - f_theta) * new_delta) + 
+								 (f_theta * pv_delta_bar->get(index)));
 		// 4- Update the weights vector
-		(*pv_weights)[index] += ((*pv_eps)[index] * new_delta);
+		double old_weight = pv_weights->get(index);
+		pv_weights->add(index, pv_eps->get(index) * new_delta);
+		if (b_incremental_q) {
+			on_weight_change(index, pv_weights->get(index) - old_weight);
+		}
 	}
 
 }
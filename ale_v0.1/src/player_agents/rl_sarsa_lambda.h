@@ -21,15 +21,46 @@
 #define RL_SARSA_LAMBDA_H
 
 #include "common_constants.h"
+#include "weight_vector.h"
+#include "trace_store.h"
+#include "weight_checkpoint.h"
+#include "actor_learner_channel.h"
 class OSystem;
+class collision_table;
+
+enum SarsaPhase {
+	PHASE_ACTION_VALUES,	// computeActionValues()
+	PHASE_TRACES,			// updateTraces()
+	PHASE_WEIGHTS,			// updateWeights()
+	NUM_SARSA_PHASES
+};
+
+struct SarsaProfile {
+    /* *************************************************************************
+        Time spent (in nanoseconds) and number of calls, per phase of the 
+		SARSA(lambda) steps. Filled in while set with set_profile()
+    ************************************************************************* */
+	long long ns[NUM_SARSA_PHASES];
+	long long calls[NUM_SARSA_PHASES];
+	SarsaProfile() {
+		for (int i = 0; i < NUM_SARSA_PHASES; i++) {
+			ns[i] = 0;
+			calls[i] = 0;
+		}
+	}
+};
 
 class RLSarsaLambda {
     public:
         /* *********************************************************************
             Constructor
+            A shared_base_length larger than 0 tells the solver that the 
+            features of action a are the features of action 0, shifted by 
+            a * shared_base_length (as in RAMAgent and GridScrAgent)
          ******************************************************************** */
         RLSarsaLambda(OSystem* _osystem, int feature_vec_size, 
-                        int num_actions, float alpha, int save_weights_freq) ;
+                        int num_actions, float alpha, int save_weights_freq,
+                        int shared_base_length = 0) ;
         /* *********************************************************************
             Deconstructor
          ******************************************************************** */
@@ -73,30 +104,119 @@ class RLSarsaLambda {
         
         
         /* *********************************************************************
-           Saves the weights vector to file
+           Saves the weights vector to file. With binary checkpoints 
+           (weights_export_format = binary) the file is written in the 
+           background, and is complete once the next export starts, or the
+           agent is deleted
          * ****************************************************************** */
         virtual void export_weights(const string& filename);
 
         /* *********************************************************************
-           Loads the weights vector from file
+           Loads the weights vector from file (a binary checkpoint or a text
+           file, as found in the file)
          * ****************************************************************** */
         virtual void import_weights(const string& filename);
 
         /* *********************************************************************
-           Accessor method
+           Returns/Sets the weight of the given feature. These work with all
+           the weights storages and precisions
          * ****************************************************************** */
-        inline FloatArr* get_weights(void) {return pv_weights;};
+        double get_feature_weight(int feature);
+        void set_feature_weight(int feature, double weight);
+
+        /* *********************************************************************
+           Sets every weight to the given value. Unlike set_feature_weight() 
+           on every feature, this does not fill the hash-table of the hashed
+           weights
+         * ****************************************************************** */
+        void set_all_weights(double weight);
 
         /* *********************************************************************
             Generates an instance of one of the RLSarsaLambda subclasses, based 
             on the values of use_idbd and use_delta_bar_delta 
+            See the constructor for shared_base_length
             Note: The caller is resposible for deleting the returned pointer
         ******************************************************************** */
         static RLSarsaLambda* generate_rl_sarsa_lambda_instance(
 									OSystem* _osystem, int feature_vec_size,
-									int num_actions);
+									int num_actions, 
+									int shared_base_length = 0);
+
+        /* *********************************************************************
+            Starts accumulating the time of each phase of the steps into
+            p_profile (NULL stops it). Used by the sarsa_benchmark
+        ******************************************************************** */
+        void set_profile(SarsaProfile* p_profile) {
+            p_step_profile = p_profile;
+        }
+
+        /* *********************************************************************
+            Returns the maximum number of non-zero traces
+        ******************************************************************** */
+        int get_max_traces(void) const {
+            return p_traces->get_max_traces();
+        }
+
+        /* *********************************************************************
+            Returns the instance that owns the actor/learner channel (when 
+            learning_mode is actor_learner), or NULL
+        ******************************************************************** */
+        static RLSarsaLambda* get_actor_learner_instance(void) {
+            return p_actor_learner_instance;
+        }
+
+        /* *********************************************************************
+            Learner side of the actor_learner mode: applies the SARSA(lambda)
+            updates for the transitions waiting in the rings of the actors 
+            (a bounded number per actor, so that no actor is starved), and 
+            publishes the weights every i_publish_frq transitions.
+            Returns the number of transitions processed
+        ******************************************************************** */
+        int learn_from_actors(void);
         
     protected:
+        /* *********************************************************************
+            Profiling: profile_start() returns the current time (0 when not 
+            profiling), and profile_lap() adds the time since start to the 
+            given phase, and returns the current time
+        ******************************************************************** */
+        inline long long profile_start(void) {
+            return p_step_profile ? profile_now() : 0;
+        }
+        inline long long profile_lap(long long start, SarsaPhase phase) {
+            if (p_step_profile == NULL) {
+                return 0;
+            }
+            long long now = profile_now();
+            p_step_profile->ns[phase] += now - start;
+            p_step_profile->calls[phase]++;
+            return now;
+        }
+        static long long profile_now(void);
+
+        /* *********************************************************************
+            Actor side of the actor_learner mode: chooses the action for the 
+            given state from the published weights, and sends the transition
+            (of the given type) to the learner
+        ******************************************************************** */
+        int actor_step(int type, FeatureMap* new_feature_map, 
+                       IntVect* num_nonzero_in_f, float new_reward, 
+                       int forced_action_ind);
+
+        /* *********************************************************************
+            Learner side: applies one transition record of the given actor
+        ******************************************************************** */
+        void learn_from_record(int actor, const IntVect& record);
+
+        struct ActorStream {      // What the learner keeps for each actor
+            TraceStore* p_traces; // The traces of the actor's episode
+            FeatureMap features;  // Features of the last state
+            IntVect num_nonzero;  // Lengths of the feature lists
+            double prev_q;        // Q-value of the last (state, action)
+            int prev_action;      // The last action
+            ActorStream() : p_traces(NULL), prev_q(0), prev_action(-1) {}
+        };
+
         /* *********************************************************************
            Compute all the action values from current activeFeatures and weights
          * ****************************************************************** */
@@ -133,40 +253,88 @@ class RLSarsaLambda {
 
         /* *********************************************************************
             This is for debugging only: prints the largest (+/-) value in 
-            pv_weights and pv_traces
+            pv_weights and p_traces
          * ****************************************************************** */
         void print_largest_weight(void);
 
         /* *********************************************************************
-            clear or zero-out trace, if any, for given feature
+            Brings v_q_sums up to date with the current base features (the 
+            features of action 0), by adding the weights of the features 
+            that became active and subtracting those of the features that 
+            are no longer active. Every i_full_q_frq steps, or when the sums
+            are not valid, the sums are recomputed from scratch instead.
+            Only used when b_incremental_q is true
          * ****************************************************************** */
-        void ClearTrace(int f);                          
+        void update_q_sums(void);
 
         /* *********************************************************************
-            clear trace at given location in list of nonzero-traces
+            Adds sign * the weights of base feature f to v_q_sums 
          * ****************************************************************** */
-        void ClearExistentTrace(int f, int loc);         
+        void add_base_feature_to_q_sums(int f, double sign);
 
         /* *********************************************************************
-            decay all nonzero traces
+            Tells the incremental Q-values that the weight in the given slot 
+            changed by weight_change
          * ****************************************************************** */
-        void DecayTraces(float decay_rate);              
+        inline void on_weight_change(int slot, double weight_change) {
+            if (!b_q_sums_valid) {
+                return;
+            }
+            int f, a;
+            if (b_interleaved_weights) {
+                f = slot / i_num_actions;
+                a = slot - f * i_num_actions;
+            } else {
+                a = slot / i_shared_base_length;
+                f = slot - a * i_shared_base_length;
+            }
+            if (v_active_base[f]) {
+                // The feature can be in the list more than once
+                v_q_sums[a] += weight_change * v_active_base[f];
+            }
+        }
 
         /* *********************************************************************
-            set trace to given value
+            Takes care of shrinking the weights-vector (when it is enabled)
          * ****************************************************************** */
-        void SetTrace(int f, float new_trace_value);     
+        void shrink_weights_vect(void);                         
 
         /* *********************************************************************
-            increase minimal trace value, forcing more to 0, making room for new 
-            ones
+            Returns the slot of the given feature in the weights vector. 
+            This is the feature itself, unless the weights are hashed or
+            interleaved
          * ****************************************************************** */
-        void IncreaseMinTrace();                         
+        int get_weight_slot(int feature);
 
         /* *********************************************************************
-            Takes care of shrinking the weights-vector (when it is enabled)
+            Returns the given feature-map, with every feature index replaced
+            by its slot in the weights vector. With the dense storage the 
+            given map itself is returned.
          * ****************************************************************** */
-        void shrink_weights_vect(void);                         
+        FeatureMap* map_features_to_slots(FeatureMap* feature_map, 
+                                          IntVect* num_nonzero_in_f);
+
+        /* *********************************************************************
+            Prints the usage and collision statistics of the hashed weights
+         * ****************************************************************** */
+        void print_hashed_weights_stats(void);
+
+        /* *********************************************************************
+            With the hashed weights, the text weights files come with a 
+            <filename>.hash file, holding the size and the mode of the 
+            hash-table, and in safe mode its keys (which depend on the order 
+            the features were seen). These save it, and check and restore 
+            it (exiting when it does not match our storage)
+         * ****************************************************************** */
+        void export_hash_table(const string& weights_filename);
+        void import_hash_table(const string& weights_filename);
+
+        /* *********************************************************************
+            Returns the precision for the per-feature step-size vectors of 
+            the subclasses: the weights precision, except that fixed-point 
+            weights get single precision step-sizes
+         * ****************************************************************** */
+        WeightPrecision get_aux_precision(void) const;
 
         OSystem* p_osystem;       // Pointer to the OSystem object
         double f_epsilon;          // probability of random action
@@ -177,8 +345,39 @@ class RLSarsaLambda {
 		bool b_normalize_fv;	  // When true feature-vector will be normalized
         int i_num_actions;        // number of actions
         int i_feature_vec_size;   // maximum number of features
-        FloatArr* pv_weights;     // vector of feature weights
-        FloatArr* pv_traces;      // eligibility traces vector
+        WeightPrecision e_weights_precision; // [double/single/fixed16]
+        int i_shared_base_length; // Length of the base feature-vector shared
+                                  // by all actions (0 when not shared)
+        bool b_shared_weights;    // When true, the weights (and the 
+                                  // IDBD/DBD step-size vectors) are shared
+                                  // by several learning workers
+        bool b_interleaved_weights; // When true, the weights of all the 
+                                  // actions for one base feature are 
+                                  // contiguous: feature f of action a is in 
+                                  // slot f * i_num_actions + a
+        bool b_incremental_q;     // When true, the Q-values are updated from
+                                  // the changes in the base features and in
+                                  // the weights, rather than recomputed
+        int i_full_q_frq;         // How often (in steps) the incremental 
+                                  // Q-values are recomputed from scratch
+        int i_steps_since_full_q; // Steps since the last full recompute
+        bool b_q_sums_valid;      // False when v_q_sums must be recomputed
+        FloatVect v_q_sums;       // Sum of the active weights of each action
+        IntVect v_active_base_list; // The base features summed in v_q_sums
+        IntVect v_active_base;    // Per base feature: how many times it is 
+                                  // in v_active_base_list (other values are 
+                                  // only used inside update_q_sums)
+        int i_num_weights;        // Size of the weights and traces vectors:
+                                  // i_feature_vec_size for the dense storage,
+                                  // or the size of the hash-table
+        collision_table* p_hash_table; // Maps the features to their slots in
+                                  // the weights vector (NULL when dense)
+        FeatureMap* pv_slot_features_map; // The current feature-map, with 
+                                  // features replaced by their slots (only
+                                  // used by the hashed storage)
+        WeightVector* pv_weights; // vector of feature weights, stored in the
+                                  // precision given by weights_precision
+        TraceStore* p_traces;     // the non-zero eligibility traces
         int i_prev_action;        // The action a decided for s
         int i_curr_action;        // The action a' decided for s'
         FloatVect v_Q;            // Q[a] value of action a in state s 
@@ -207,14 +406,29 @@ class RLSarsaLambda {
         int i_save_weights_freq;  // How often (based on number of episodes)
                                   //  should the weights be saved to disk.
                                   //  0 means that weigths will not be saved        
+        bool b_binary_weights;    // When true, the weights are exported as 
+                                  // binary checkpoints, rather than text
+        WeightCheckpointWriter* p_checkpoint_writer; // Writes the binary 
+                                  // checkpoints in the background
+        WeightVector* pv_own_weights; // The weights allocated by this agent
+                                  // (NULL in the actors, which point 
+                                  // pv_weights at the published snapshot)
+        ActorLearnerChannel* p_channel; // Rings and weight snapshots shared 
+                                  // with the actors (NULL unless 
+                                  // learning_mode is actor_learner)
+        int i_actor_id;           // Actor side: our ring (-1 until known)
+        int i_publish_frq;        // Learner side: publish the weights every
+                                  // this many transitions
+        int i_learner_transitions; // Learner side: transitions processed
+        int i_learner_episodes;   // Learner side: episodes completed
+        vector<ActorStream> v_actor_streams; // Learner side: one per actor
+        IntVect v_record;         // Learner side: the record being applied
+        static RLSarsaLambda* p_actor_learner_instance;
+        SarsaProfile* p_step_profile; // When not NULL, we time the phases 
+                                  // of the steps into it
         int i_epsilon_dim_start;  // Starts diminishing epsilon 
                                   // after this many episodes
 		float f_eps_dim_delta;	  // The amount to subtract from delta per epis
-        int i_max_nonzero_traces; // Max number of non-zero values in pv_traces
-        int i_num_nonzero_traces; // Number of non-zero value in v_traces
-        double f_minimum_trace;    // Minimum non-zero value in v_traces
-        IntVect* pv_nonzero_traces_ind;//Indecies of non-zero values in v_traces
-        IntVect* pv_nonzero_traces_inv_ind; // inverse of pv_nonzero_traces_ind
         
         
         
@@ -234,7 +448,8 @@ class RLSarsaLambdaWithIDBD : public RLSarsaLambda {
          ******************************************************************** */
         RLSarsaLambdaWithIDBD(	OSystem* _osystem, int feature_vec_size, 
 								int num_actions,  
-								int save_weights_freq) ;
+								int save_weights_freq,
+								int shared_base_length = 0) ;
         /* *********************************************************************
             Deconstructor
          ******************************************************************** */
@@ -246,8 +461,8 @@ class RLSarsaLambdaWithIDBD : public RLSarsaLambda {
         virtual void updateWeights(double delta);
 		
 		double f_theta;		// the new meta-step-size
-		FloatArr* pv_h;     // the h vector (See the otiginal paper)
-		FloatArr* pv_beta;  // the beta vector (See the otiginal paper)
+		WeightVector* pv_h;     // the h vector (See the otiginal paper)
+		WeightVector* pv_beta;  // the beta vector (See the otiginal paper)
 };
 		
 class RLSarsaLambdaWithDeltaBarDelta : public RLSarsaLambda {
@@ -265,7 +480,8 @@ class RLSarsaLambdaWithDeltaBarDelta : public RLSarsaLambda {
         RLSarsaLambdaWithDeltaBarDelta(	OSystem* _osystem, int feature_vec_size, 
 								int num_actions, double eps_start, 
 								double k, double phi, double theta,
-								int save_weights_freq) ;
+								int save_weights_freq,
+								int shared_base_length = 0) ;
         /* *********************************************************************
             Deconstructor
          ******************************************************************** */
@@ -277,8 +493,9 @@ class RLSarsaLambdaWithDeltaBarDelta : public RLSarsaLambda {
         virtual void updateWeights(double delta);
 		
 		double f_k, f_phi, f_theta;	// meta-step-size parameters
-		FloatArr* pv_eps;   // epsilon h vector (See the otiginal paper)
-		FloatArr* pv_delta_bar;  // the delta_bar vector (See the otiginal paper)
+		WeightVector* pv_eps;   // epsilon h vector (See the otiginal paper)
+		WeightVector* pv_delta_bar;  // the delta_bar vector (See the otiginal 
+									 // paper)
 };
 		
 
@@ -0,0 +1,361 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  screen_planes.cpp
+ *
+ *  Implementation of the ScreenPlanes class, which decomposes each screen
+ *  (once per frame) into a foreground bitmap, per-color bitplanes and
+ *  per-block color masks, shared by the vision modules
+ **************************************************************************** */
+
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "screen_planes.h"
+
+ScreenPlanes::ScreenPlanes(int height, int width) :
+	i_height(height), i_width(width) {
+	pm_screen_matrix = NULL;
+	pm_background_matrix = NULL;
+	i_parts = 0;
+	b_is_built = false;
+	pm_forground = new PackedBitMatrix(i_height, i_width);
+	pv_color_planes.assign(NUM_COLORS, NULL);
+	v_is_present.assign(NUM_COLORS, 0);
+	i_block_height = 0;
+	i_block_width = 0;
+	i_num_block_cols = 0;
+	b_rebuild_all = true;
+	v_row_changed.assign(i_height, 0);
+	v_row_colors.assign(i_height * COLOR_MASK_WORDS, 0);
+	v_color_num_rows.assign(NUM_COLORS, 0);
+}
+
+ScreenPlanes::~ScreenPlanes() {
+	delete pm_forground;
+	for (int c = 0; c < NUM_COLORS; c++) {
+		if (pv_color_planes[c]) {
+			delete pv_color_planes[c];
+		}
+	}
+}
+
+/* *********************************************************************
+	Adds the given parts (ScreenPlaneParts or-ed together) to the
+	parts that are built for each screen
+ ******************************************************************** */
+void ScreenPlanes::use_parts(int parts) {
+	i_parts |= parts;
+	b_is_built = false;
+	b_rebuild_all = true;
+}
+
+/* *********************************************************************
+	Sets the background matrix used for the foreground bitmap. The
+	matrix is not copied, and should outlive this object
+ ******************************************************************** */
+void ScreenPlanes::set_background(const IntMatrix* background_matrix) {
+	pm_background_matrix = background_matrix;
+	b_is_built = false;
+	b_rebuild_all = true;
+}
+
+/* *********************************************************************
+	Sets the size of the blocks of the block color masks. The size
+	must divide the screen
+ ******************************************************************** */
+void ScreenPlanes::set_block_size(int block_height, int block_width) {
+	assert(i_height % block_height == 0 && i_width % block_width == 0);
+	i_block_height = block_height;
+	i_block_width = block_width;
+	i_num_block_cols = i_width / i_block_width;
+	int num_blocks = (i_height / i_block_height) * i_num_block_cols;
+	v_block_colors.assign(num_blocks * COLOR_MASK_WORDS, 0);
+	v_block_fg_colors.assign(num_blocks * COLOR_MASK_WORDS, 0);
+	v_block_col_of_x.clear();
+	for (int x = 0; x < i_width; x++) {
+		v_block_col_of_x.push_back(x / i_block_width);
+	}
+	b_is_built = false;
+	b_rebuild_all = true;
+}
+
+/* *********************************************************************
+	Sets the screen of the current frame. The planes are rebuilt by
+	the next query. changes are the parts of the screen that changed
+	since the last call (NULL when unknown)
+ ******************************************************************** */
+void ScreenPlanes::set_screen(const IntMatrix* screen_matrix, 
+							  const ScreenChanges* changes) {
+	pm_screen_matrix = screen_matrix;
+	b_is_built = false;
+	if (changes == NULL) {
+		b_rebuild_all = true;
+		return;
+	}
+	if (b_rebuild_all) {
+		return;
+	}
+	for (int y = 0; y < i_height; y++) {
+		if (changes->is_row_changed(y)) {
+			v_row_changed[y] = 1;
+		}
+	}
+}
+
+/* *********************************************************************
+	Returns the foreground bitmap
+ ******************************************************************** */
+const PackedBitMatrix* ScreenPlanes::get_forground(void) {
+	assert((i_parts & FORGROUND_PLANE) && pm_background_matrix != NULL);
+	if (!b_is_built) {
+		build();
+	}
+	return pm_forground;
+}
+
+/* *********************************************************************
+	Returns the bitplane of the given color, or NULL if the color
+	is not on the screen
+ ******************************************************************** */
+const PackedBitMatrix* ScreenPlanes::get_color_plane(int color_ind) {
+	assert(i_parts & COLOR_PLANES);
+	assert(color_ind >= 0 && color_ind < NUM_COLORS);
+	if (!b_is_built) {
+		build();
+	}
+	if (!v_is_present[color_ind]) {
+		return NULL;
+	}
+	return pv_color_planes[color_ind];
+}
+
+/* *********************************************************************
+	Returns the colors on the screen, in ascending order
+ ******************************************************************** */
+const IntVect& ScreenPlanes::get_present_colors(void) {
+	assert(i_parts & COLOR_PLANES);
+	if (!b_is_built) {
+		build();
+	}
+	return v_present_colors;
+}
+
+/* *********************************************************************
+	Returns the COLOR_MASK_WORDS words of the color mask of block
+	(block_i, block_j), for all the pixels of the block or for its
+	foreground pixels only
+ ******************************************************************** */
+const BitWord* ScreenPlanes::get_block_colors(int block_i, int block_j,
+											  bool forground_only) {
+	assert((i_parts & BLOCK_COLOR_MASKS) && i_block_height > 0);
+	assert(!forground_only || pm_background_matrix != NULL);
+	if (!b_is_built) {
+		build();
+	}
+	int ind = (block_i * i_num_block_cols + block_j) * COLOR_MASK_WORDS;
+	if (forground_only) {
+		return &v_block_fg_colors[ind];
+	}
+	return &v_block_colors[ind];
+}
+
+/* *********************************************************************
+	Returns the word whose bit i is set when a[i] != b[i], for i in
+	[0, len) (len is at most 64). With SSE2, the pixels are compared 4 
+	at a time
+ ******************************************************************** */
+static inline BitWord get_diff_bits(const int* a, const int* b, int len) {
+	BitWord bits = 0;
+	int i = 0;
+#ifdef __SSE2__
+	for (; i + 4 <= len; i += 4) {
+		__m128i a_pixels = _mm_loadu_si128((const __m128i*)(a + i));
+		__m128i b_pixels = _mm_loadu_si128((const __m128i*)(b + i));
+		int equal = _mm_movemask_ps(_mm_castsi128_ps(
+										_mm_cmpeq_epi32(a_pixels, b_pixels)));
+		bits |= (BitWord)(~equal & 15) << i;
+	}
+#endif
+	for (; i < len; i++) {
+		bits |= (BitWord)(a[i] != b[i]) << i;
+	}
+	return bits;
+}
+
+/* *********************************************************************
+	Builds the parts in use from the current screen. Only the rows that
+	changed since the last build are rebuilt, with all the rows of their
+	blocks when the block masks are in use (the masks of a block are 
+	rebuilt from all its rows)
+ ******************************************************************** */
+void ScreenPlanes::build(void) {
+	assert(pm_screen_matrix != NULL);
+	bool do_blocks = (i_parts & BLOCK_COLOR_MASKS);
+	bool do_colors = (i_parts & COLOR_PLANES);
+	bool do_fg = (pm_background_matrix != NULL) &&
+				 (do_blocks || (i_parts & FORGROUND_PLANE));
+	if (b_rebuild_all) {
+		v_row_changed.assign(i_height, 1);
+	} else if (do_blocks) {
+		for (int y0 = 0; y0 < i_height; y0 += i_block_height) {
+			int y_end = y0 + i_block_height;
+			bool block_row_changed = false;
+			for (int y = y0; y < y_end; y++) {
+				block_row_changed |= (v_row_changed[y] != 0);
+			}
+			if (block_row_changed) {
+				fill(v_row_changed.begin() + y0, v_row_changed.begin() + y_end,
+					 1);
+			}
+		}
+	}
+	for (int y = 0; y < i_height; y++) {
+		if (!v_row_changed[y]) {
+			continue;
+		}
+		if (do_blocks && y % i_block_height == 0) {
+			int first_ind = (y / i_block_height) * i_num_block_cols * 
+							COLOR_MASK_WORDS;
+			int end_ind = first_ind + i_num_block_cols * COLOR_MASK_WORDS;
+			fill(v_block_colors.begin() + first_ind, 
+				 v_block_colors.begin() + end_ind, 0);
+			fill(v_block_fg_colors.begin() + first_ind, 
+				 v_block_fg_colors.begin() + end_ind, 0);
+		}
+		if (do_colors) {
+			clear_row_colors(y);
+		}
+		build_row(y, do_fg, do_colors, do_blocks);
+		v_row_changed[y] = 0;
+	}
+	if (do_colors) {
+		v_present_colors.clear();
+		for (int c = 0; c < NUM_COLORS; c++) {
+			v_is_present[c] = (v_color_num_rows[c] > 0);
+			if (v_is_present[c]) {
+				v_present_colors.push_back(c);
+			}
+		}
+	}
+	b_rebuild_all = false;
+	b_is_built = true;
+}
+
+/* *********************************************************************
+	Clears the bits of row y from the color planes
+ ******************************************************************** */
+void ScreenPlanes::clear_row_colors(int y) {
+	int num_words = (i_width + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	BitWord* row_colors = &v_row_colors[y * COLOR_MASK_WORDS];
+	for (int w = 0; w < COLOR_MASK_WORDS; w++) {
+		BitWord colors = row_colors[w];
+		while (colors != 0) {
+			int c = w * BITS_PER_WORD + __builtin_ctzll(colors);
+			colors &= colors - 1;
+			for (int word_ind = 0; word_ind < num_words; word_ind++) {
+				pv_color_planes[c]->set_word(y, word_ind, 0);
+			}
+			v_color_num_rows[c]--;
+		}
+		row_colors[w] = 0;
+	}
+}
+
+/* *********************************************************************
+	Builds the parts in use for row y, 64 pixels at a time: the 
+	foreground bits are the pixels that differ from the background, and 
+	the runs of one color end at the pixels that differ from their right
+	neighbor (both are compared 4 pixels at a time, with SSE2). Each run 
+	is then or-ed into the plane of its color and into the masks of the 
+	blocks it crosses (most of the rows are a few long runs)
+ ******************************************************************** */
+void ScreenPlanes::build_row(int y, bool do_fg, bool do_colors, 
+							 bool do_blocks) {
+	bool do_runs = do_colors || do_blocks;
+	const int* screen_row = &(*pm_screen_matrix)[y][0];
+	const int* bg_row = NULL;
+	if (do_fg) {
+		bg_row = &(*pm_background_matrix)[y][0];
+	}
+	BitWord* row_colors = &v_row_colors[y * COLOR_MASK_WORDS];
+	int first_block = 0;	// the index of the first block of the row
+	if (do_blocks) {
+		first_block = (y / i_block_height) * i_num_block_cols;
+	}
+	for (int x0 = 0; x0 < i_width; x0 += BITS_PER_WORD) {
+		int len = min(BITS_PER_WORD, i_width - x0);
+		int word_ind = x0 / BITS_PER_WORD;
+		BitWord fg_word = 0;
+		if (do_fg) {
+			fg_word = get_diff_bits(screen_row + x0, bg_row + x0, len);
+			pm_forground->set_word(y, word_ind, fg_word);
+		}
+		if (!do_runs) {
+			continue;
+		}
+		// bit i is set when a run ends at x0 + i (the last pixel of
+		// the row has no right neighbor)
+		int num_neighbors = min(len, i_width - 1 - x0);
+		BitWord run_ends = get_diff_bits(screen_row + x0, 
+										 screen_row + x0 + 1, 
+										 num_neighbors);
+		run_ends |= (BitWord)1 << (len - 1);
+		int run_start = 0;
+		while (run_ends != 0) {
+			int run_end = __builtin_ctzll(run_ends) + 1;
+			run_ends &= run_ends - 1;
+			int c = screen_row[x0 + run_start];
+			assert(c >= 0 && c < NUM_COLORS);
+			BitWord run_bits = bits_in_range(run_start, 
+											 run_end - run_start);
+			if (do_colors) {
+				BitWord color_bit = (BitWord)1 << (c % BITS_PER_WORD);
+				if (!(row_colors[c / BITS_PER_WORD] & color_bit)) {
+					if (pv_color_planes[c] == NULL) {
+						pv_color_planes[c] = new PackedBitMatrix(i_height,
+																 i_width);
+					}
+					row_colors[c / BITS_PER_WORD] |= color_bit;
+					v_color_num_rows[c]++;
+				}
+				pv_color_planes[c]->or_word(y, word_ind, run_bits);
+			}
+			if (do_blocks) {
+				add_run_to_blocks(first_block, x0, x0 + run_start, 
+								  x0 + run_end, c, fg_word & run_bits);
+			}
+			run_start = run_end;
+		}
+	}
+}
+
+/* *********************************************************************
+	Adds color c to the masks of the blocks crossed by the run 
+	[run_start, run_end) of a row whose first block is first_block (the
+	run lies in the word starting at column x0). run_fg_bits are the 
+	foreground bits of the run, at their place in that word
+ ******************************************************************** */
+void ScreenPlanes::add_run_to_blocks(int first_block, int x0, int run_start, 
+									 int run_end, int c, BitWord run_fg_bits) {
+	int color_word = c / BITS_PER_WORD;
+	BitWord color_bit = (BitWord)1 << (c % BITS_PER_WORD);
+	int x = run_start;
+	while (x < run_end) {
+		int block_j = v_block_col_of_x[x];
+		int block_end = min((block_j + 1) * i_block_width, run_end);
+		int ind = (first_block + block_j) * COLOR_MASK_WORDS + color_word;
+		v_block_colors[ind] |= color_bit;
+		if (run_fg_bits & bits_in_range(x - x0, block_end - x)) {
+			v_block_fg_colors[ind] |= color_bit;
+		}
+		x = block_end;
+	}
+}
@@ -0,0 +1,197 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  screen_planes.h
+ *
+ *  Implementation of the ScreenPlanes class, which decomposes each screen
+ *  (once per frame) into a foreground bitmap, per-color bitplanes and
+ *  per-block color masks, shared by the vision modules
+ **************************************************************************** */
+
+#ifndef SCREEN_PLANES_H
+#define SCREEN_PLANES_H
+
+#include "common_constants.h"
+#include "packed_bit_matrix.h"
+#include "screen_changes.h"
+
+#define NUM_COLORS 256
+#define COLOR_MASK_WORDS (NUM_COLORS / BITS_PER_WORD)	// Words in the color
+														// mask of a block
+
+// The parts of the decomposition a module can ask for (or-ed together)
+enum ScreenPlaneParts {
+	FORGROUND_PLANE		= 1,	// Needs a background
+	COLOR_PLANES		= 2,
+	BLOCK_COLOR_MASKS	= 4		// Needs a block size
+};
+
+class ScreenPlanes {
+    /* *************************************************************************
+        Decomposes the current screen, in one pass over its pixels, into the
+		parts asked for by the modules that use it:
+			- a foreground bitmap: the pixels that differ from the background
+			  matrix
+			- one bitplane per color present on the screen
+			- for each block of the screen, the mask of the colors in the
+			  block (bit c of the mask is set when color c is in the block),
+			  for all the pixels and (when a background is set) for the
+			  foreground pixels only
+		The pixels are compared 4 at a time (with SSE2), and the color 
+		planes and the block masks are gathered from the runs of one color
+		of the rows.
+		The decomposition is built lazily, by the first query after
+		set_screen, so the agents that do not use it pay nothing.
+		When set_screen is told which rows changed, only those rows are
+		rebuilt (with the rows of their blocks, for the block masks)
+
+        Instance variabls:
+		- pm_screen_matrix		The current screen
+		- pm_background_matrix	The background matrix (or NULL)
+		- i_parts				The parts to build (ScreenPlaneParts or-ed)
+		- b_is_built			True when the planes are up-to-date with the
+								current screen
+		- pm_forground			The foreground bitmap
+		- pv_color_planes		The bitplane of each color (NULL for the
+								colors never seen yet)
+		- v_present_colors		The colors on the current screen, ascending
+		- v_is_present			v_is_present[c] is 1 when color c is on the
+								current screen
+		- i_block_height		Height of the blocks
+		- i_block_width			Width of the blocks
+		- i_num_block_cols		Number of blocks in each row of blocks
+		- v_block_colors		The color mask of each block,
+								COLOR_MASK_WORDS words per block
+		- v_block_fg_colors		Same, for the foreground pixels only
+		- v_block_col_of_x		The block column of each screen column
+		- b_rebuild_all			True when all the rows should be rebuilt
+		- v_row_changed			v_row_changed[y] is 1 when row y changed
+								since the planes were last built
+		- v_row_colors			The color mask of each row, COLOR_MASK_WORDS
+								words per row
+		- v_color_num_rows		The number of rows each color is on
+    ************************************************************************* */
+
+    public:
+        ScreenPlanes(int height, int width);
+        virtual ~ScreenPlanes();
+
+		/* *********************************************************************
+            Adds the given parts (ScreenPlaneParts or-ed together) to the
+			parts that are built for each screen
+         ******************************************************************** */
+		void use_parts(int parts);
+
+		/* *********************************************************************
+            Sets the background matrix used for the foreground bitmap. The
+			matrix is not copied, and should outlive this object
+         ******************************************************************** */
+		void set_background(const IntMatrix* background_matrix);
+
+		/* *********************************************************************
+            Sets the size of the blocks of the block color masks. The size
+			must divide the screen
+         ******************************************************************** */
+		void set_block_size(int block_height, int block_width);
+
+		/* *********************************************************************
+            Sets the screen of the current frame. The planes are rebuilt by
+			the next query. changes are the parts of the screen that changed
+			since the last call (NULL when unknown)
+         ******************************************************************** */
+		void set_screen(const IntMatrix* screen_matrix, 
+						const ScreenChanges* changes = NULL);
+
+		const IntMatrix* get_screen_matrix(void) const {
+			return pm_screen_matrix;
+		}
+
+		/* *********************************************************************
+            Returns the foreground bitmap
+         ******************************************************************** */
+		const PackedBitMatrix* get_forground(void);
+
+		/* *********************************************************************
+            Returns the bitplane of the given color, or NULL if the color
+			is not on the screen
+         ******************************************************************** */
+		const PackedBitMatrix* get_color_plane(int color_ind);
+
+		/* *********************************************************************
+            Returns the colors on the screen, in ascending order
+         ******************************************************************** */
+		const IntVect& get_present_colors(void);
+
+		/* *********************************************************************
+            Returns the COLOR_MASK_WORDS words of the color mask of block
+			(block_i, block_j), for all the pixels of the block or for its
+			foreground pixels only
+         ******************************************************************** */
+		const BitWord* get_block_colors(int block_i, int block_j,
+										bool forground_only);
+
+	protected:
+		/* *********************************************************************
+            Builds the parts in use from the current screen, for the rows
+			that changed since the last build
+         ******************************************************************** */
+		void build(void);
+
+		/* *********************************************************************
+            Builds the parts in use for row y
+         ******************************************************************** */
+		void build_row(int y, bool do_fg, bool do_colors, bool do_blocks);
+
+		/* *********************************************************************
+            Clears the bits of row y from the color planes
+         ******************************************************************** */
+		void clear_row_colors(int y);
+
+		/* *********************************************************************
+            Adds color c to the masks of the blocks crossed by the run 
+			[run_start, run_end) of a row whose first block is first_block 
+			(the run lies in the word starting at column x0). run_fg_bits 
+			are the foreground bits of the run, at their place in that word
+         ******************************************************************** */
+		void add_run_to_blocks(int first_block, int x0, int run_start, 
+							   int run_end, int c, BitWord run_fg_bits);
+
+		/* *********************************************************************
+            Returns the word with the bits [start, start + len) set
+         ******************************************************************** */
+		static inline BitWord bits_in_range(int start, int len) {
+			if (len == BITS_PER_WORD) {
+				return ~(BitWord)0;
+			}
+			return (((BitWord)1 << len) - 1) << start;
+		}
+
+		int i_height;
+		int i_width;
+		const IntMatrix* pm_screen_matrix;
+		const IntMatrix* pm_background_matrix;
+		int i_parts;
+		bool b_is_built;
+		PackedBitMatrix* pm_forground;
+		vector<PackedBitMatrix*> pv_color_planes;
+		IntVect v_present_colors;
+		IntVect v_is_present;
+		int i_block_height;
+		int i_block_width;
+		int i_num_block_cols;
+		BitWordVect v_block_colors;
+		BitWordVect v_block_fg_colors;
+		IntVect v_block_col_of_x;
+		bool b_rebuild_all;
+		IntVect v_row_changed;
+		BitWordVect v_row_colors;
+		IntVect v_color_num_rows;
+};
+
+#endif
@@ -17,12 +17,15 @@
 #include "Serializer.hxx"
 #include "Deserializer.hxx"
 #include "System.hxx"
+#include "TIA.hxx"
 #include <sstream>
+#include <algorithm>
 #include "random_tools.h"
 #include "game_controller.h"
 #include "tree_node.h"
 #include "full_search_tree.h"
 #include "uct_search_tree.h"
+#include "mc_search_tree.h"
 
 SearchAgent::SearchAgent(GameSettings* _game_settings, OSystem* _osystem) : 
     PlayerAgent(_game_settings, _osystem),
@@ -31,6 +34,24 @@ SearchAgent::SearchAgent(GameSettings* _game_settings, OSystem* _osystem) :
 	i_next_act_frame(0) {
 	i_sim_steps_per_node = p_osystem->settings().getInt("sim_steps_per_node", true);
 	str_search_method = p_osystem->settings().getString("search_method", true); 
+	i_rollout_frame_skip = p_osystem->settings().getInt("uct_rollout_frame_skip",
+																		true);
+	string ram_watch = p_osystem->settings().getString("uct_rollout_ram_watch",
+																		true);
+	replace(ram_watch.begin(), ram_watch.end(), ',', ' ');
+	istringstream ram_watch_stream(ram_watch);
+	int ram_ind;
+	while (ram_watch_stream >> ram_ind) {
+		assert(ram_ind >= 0 && ram_ind < RAM_LENGTH);
+		v_rollout_ram_watch.push_back(ram_ind);
+	}
+	if (i_rollout_frame_skip > 0) {
+		cout << "SearchAgent: Monte Carlo rollouts hold each action for " 
+			 << i_rollout_frame_skip << " frames, watching " 
+			 << v_rollout_ram_watch.size() << " RAM bytes" << endl;
+	}
+	p_telemetry = new SearchTelemetry(p_osystem, 
+			p_osystem->settings().getString("search_telemetry_file", true));
 	MediaSource& mediasrc = p_osystem->console().mediaSource();
     i_screen_width  = mediasrc.width();
     i_screen_height = mediasrc.height();
@@ -47,6 +68,8 @@ SearchAgent::SearchAgent(GameSettings* _game_settings, OSystem* _osystem) :
 		p_search_tree = new FullSearchTree(this);
 	} else if (str_search_method == "uct") {
 		p_search_tree = new UCTSearchTree(this);
+	} else if (str_search_method == "mc") {
+		p_search_tree = new MCSearchTree(this);
 	} else {
 		cerr << "Unknown search Method: " << str_search_method << endl;
 		exit(-1);
@@ -55,6 +78,7 @@ SearchAgent::SearchAgent(GameSettings* _game_settings, OSystem* _osystem) :
 
 SearchAgent::~SearchAgent() {
 	delete p_search_tree;
+	delete p_telemetry;
 	delete pm_sim_scr_matrix;
 	delete pv_sim_ram_content;
 }
@@ -101,30 +125,28 @@ Action SearchAgent::agent_step( const IntMatrix* screen_matrix,
 	i_curr_num_sim_steps = 0;
 	if (i_frame_counter >= i_next_act_frame) {
 		// Run a new simulation to find the next action
+		p_telemetry->start_decision();
 		i_next_act_frame = i_frame_counter + i_sim_steps_per_node;
 		str_curr_state = save_state();
-		if (str_search_method == "fulltree") {
-			p_search_tree->clear();	// The current full-tree implementation
-									// does not support rebuilding the tree
+		if (!p_search_tree->is_reused()) {
+			p_search_tree->clear();	// Rebuild the tree from scratch
 		}
-		cout << "Frame: " << i_frame_counter << ", ";
-		if (p_search_tree->is_built) {
+		bool tree_updated = p_search_tree->is_built;
+		if (tree_updated) {
 			// Re-use the old tree
 			p_search_tree->move_to_best_sub_branch();
 			assert (p_search_tree->get_root_frame_number() == i_frame_counter);
 			p_search_tree->update_tree();
-			cout << "Tree Updated: ";
 		} else {
 			// Build a new Search-Tree
 			p_search_tree->clear(); 
 			p_search_tree->build(str_curr_state, i_frame_counter);
-			cout << "Tree Re-Constructed: ";
 		}
 		e_curr_action = p_search_tree->get_best_action();
-		cout << " Root Value = " << p_search_tree->get_root_value();  
-		cout << " - Deepest Node Frame: " 
-			 << p_search_tree->i_deepest_node_frame_num << endl;
 		load_state(str_curr_state);
+		p_telemetry->end_decision(i_frame_counter, str_search_method, 
+								  tree_updated, e_curr_action, 
+								  i_curr_num_sim_steps, p_search_tree);
 		// deal with the bloody bug, where the screen doesnt get updated
 		// after restoring the state for one turn. This *hack* allows 
 		// basically skips exporting teh screen for one turn
@@ -156,7 +178,36 @@ void SearchAgent::simulate_game(Action act, int num_steps, int start_frame_num,
 								float& reward, bool& game_ended) {
 	reward = 0.0;
 	game_ended = false;
+	bool is_rollout = (act == RANDOM);
+	uInt32 sim_start = p_telemetry->get_ticks();
+	long long reward_usecs_before = p_telemetry->i_reward_usecs;
+	int steps_before = i_curr_num_sim_steps;
+	if (is_rollout && i_rollout_frame_skip > 0) {
+		simulate_random_rollout(num_steps, start_frame_num, reward, 
+								game_ended);
+	} else {
+		simulate_frames(act, num_steps, start_frame_num, reward, game_ended);
+	}
+	// Everything that was not reward evaluation was emulation
+	uInt32 sim_usecs = p_telemetry->get_ticks() - sim_start;
+	p_telemetry->i_emulate_usecs += sim_usecs - 
+						(p_telemetry->i_reward_usecs - reward_usecs_before);
+	if (is_rollout) {
+		p_telemetry->i_rollout_frames += i_curr_num_sim_steps - steps_before;
+		p_telemetry->i_rollout_usecs += sim_usecs;
+	}
+}
+
+/* *********************************************************************
+	Simulates the game frame by frame, checking the reward and 
+	end-of-game on every frame (the body of simulate_game())
+ ******************************************************************** */
+void SearchAgent::simulate_frames(Action act, int num_steps, 
+								  int start_frame_num, float& reward, 
+								  bool& game_ended) {
 	MediaSource& mediasrc = p_osystem->console().mediaSource();
+	bool time_frames = p_telemetry->is_timing_frames();
+	uInt32 eval_start = 0;
 	for (int i = 0; i < num_steps; i++) {
 		i_curr_num_sim_steps++;
 		if (act == RANDOM && 
@@ -166,6 +217,9 @@ void SearchAgent::simulate_game(Action act, int num_steps, int start_frame_num,
 		GameController::apply_action(	p_sim_event_obj, act, PLAYER_B_NOOP);
 		p_osystem->myTimingInfo.start = p_osystem->getTicks();
 		mediasrc.update(); 
+		if (time_frames) {
+			eval_start = p_telemetry->get_ticks();
+		}
 		if (p_game_settings->b_uses_screen_matrix) {
 			copy_simulated_framebuffer();
 		}
@@ -183,30 +237,127 @@ void SearchAgent::simulate_game(Action act, int num_steps, int start_frame_num,
 		game_ended = p_game_settings->is_end_of_game(pm_sim_scr_matrix,  
 													 pv_sim_ram_content, 
 													 start_frame_num + i);
+		if (time_frames) {
+			p_telemetry->i_reward_usecs += p_telemetry->get_ticks() - eval_start;
+		}
 		if (game_ended) {
 			break;
 		}
 	}
 }
 
+/* *********************************************************************
+	Fast path for Monte Carlo rollouts: holds each random action for
+	i_rollout_frame_skip frames, and only copies the RAM/screen and 
+	evaluates the reward and end-of-game at the end of each hold (or 
+	when one of the watched RAM bytes changes).
+	Note that the reward is clipped to [-1, 0.0, 1.0] per evaluation, 
+	not per frame.
+ ******************************************************************** */
+void SearchAgent::simulate_random_rollout(int num_steps, int start_frame_num,
+										  float& reward, bool& game_ended) {
+	reward = 0.0;
+	game_ended = false;
+	// The TIA is our only MediaSource. Calling TIA::update() directly skips 
+	// the virtual dispatch on every frame.
+	TIA* p_tia = (TIA*)(&p_osystem->console().mediaSource());
+	int num_watched = v_rollout_ram_watch.size();
+	IntVect watched_vals(num_watched);
+	for (int w = 0; w < num_watched; w++) {
+		watched_vals[w] = read_simulated_ram(v_rollout_ram_watch[w]);
+	}
+	bool time_frames = p_telemetry->is_timing_frames();
+	uInt32 eval_start = 0;
+	int frames_since_eval = 0;
+	int i = 0;
+	while (i < num_steps) {
+		Action act = choice(p_game_settings->pv_possible_actions);
+		GameController::apply_action(p_sim_event_obj, act, PLAYER_B_NOOP);
+		int hold_end = min(i + i_rollout_frame_skip, num_steps);
+		while (i < hold_end) {
+			p_tia->TIA::update();
+			i++;
+			frames_since_eval++;
+			bool do_eval = (i == hold_end);
+			for (int w = 0; w < num_watched; w++) {
+				int val = read_simulated_ram(v_rollout_ram_watch[w]);
+				if (val != watched_vals[w]) {
+					watched_vals[w] = val;
+					do_eval = true;
+				}
+			}
+			if (!do_eval) {
+				continue;
+			}
+			if (time_frames) {
+				eval_start = p_telemetry->get_ticks();
+			}
+			if (p_game_settings->b_uses_screen_matrix) {
+				copy_simulated_framebuffer();
+			}
+			copy_simulated_ram_content();
+			float curr_reward = p_game_settings->get_reward(pm_sim_scr_matrix, 
+															pv_sim_ram_content);
+			if (curr_reward > 0) {	// convert it to [-1, 0.0, 1.0]  reward
+				reward += 1.0;
+			} else if (curr_reward < 0) {	
+				reward -= 1.0;
+			}
+			// is_end_of_game() counts its calls as frames in some games
+			p_game_settings->i_frames_since_last_restart += frames_since_eval - 1;
+			frames_since_eval = 0;
+			game_ended = p_game_settings->is_end_of_game(pm_sim_scr_matrix,  
+														 pv_sim_ram_content, 
+														 start_frame_num + i - 1);
+			if (time_frames) {
+				p_telemetry->i_reward_usecs += p_telemetry->get_ticks() - 
+											   eval_start;
+			}
+			if (game_ended) {
+				i_curr_num_sim_steps += i;
+				return;
+			}
+		}
+	}
+	i_curr_num_sim_steps += i;
+}
+
 
 /* *********************************************************************
 	Saves the OSystem/GameSettings states to a string
  ******************************************************************** */
 string SearchAgent::save_state(void) const {
+	uInt32 start = p_telemetry->get_ticks();
 	Serializer ser;
 	p_osystem->console().system().saveState(s_cartridge_md5, ser);
 	p_game_settings->save_state(ser);
-	return ser.get_str();
+	string state_str = ser.get_str();
+	p_telemetry->i_save_load_usecs += p_telemetry->get_ticks() - start;
+	return state_str;
 }
 
 /* *********************************************************************
 	Loads the OSystem/GameSettings states from a string
  ******************************************************************** */
 void SearchAgent::load_state(const string state_str) {
+	uInt32 start = p_telemetry->get_ticks();
 	Deserializer deser(state_str);
 	p_osystem->console().system().loadState(s_cartridge_md5, deser);
 	p_game_settings->load_state(deser);
+	p_telemetry->i_save_load_usecs += p_telemetry->get_ticks() - start;
+}
+
+/* *********************************************************************
+	Loads the OSystem/GameSettings states from an already constructed
+	Deserializer. The Deserializer is rewound first, so the same one can 
+	be used to restore a state many times
+ ******************************************************************** */
+void SearchAgent::load_state(Deserializer& deser) {
+	uInt32 start = p_telemetry->get_ticks();
+	deser.rewind();
+	p_osystem->console().system().loadState(s_cartridge_md5, deser);
+	p_game_settings->load_state(deser);
+	p_telemetry->i_save_load_usecs += p_telemetry->get_ticks() - start;
 }
 
 
@@ -23,6 +23,9 @@
 #include "SettingsUNIX.hxx"
 #include "OSystemUNIX.hxx"
 #include "search_tree.h"
+#include "search_telemetry.h"
+
+class Deserializer;
 
 class SearchAgent : public PlayerAgent {
 	friend class SearchTree;
@@ -66,6 +69,22 @@ class SearchAgent : public PlayerAgent {
          ******************************************************************** */
         void simulate_game(Action act, int num_steps, int start_frame_num,
 							float& reward, bool& game_ended);
+
+		/* *********************************************************************
+            Simulates the game frame by frame, checking the reward and 
+			end-of-game on every frame (the body of simulate_game())
+         ******************************************************************** */
+        void simulate_frames(Action act, int num_steps, int start_frame_num,
+							float& reward, bool& game_ended);
+
+		/* *********************************************************************
+            Fast path for Monte Carlo rollouts: holds each random action for
+			i_rollout_frame_skip frames, and only copies the RAM/screen and 
+			evaluates the reward and end-of-game at the end of each hold 
+			(or when one of the watched RAM bytes changes)
+         ******************************************************************** */
+        void simulate_random_rollout(int num_steps, int start_frame_num,
+									float& reward, bool& game_ended);
 		
 		/* *********************************************************************
             Saves the OSystem's state to string
@@ -76,6 +95,13 @@ class SearchAgent : public PlayerAgent {
             Saves the OSystem's state to string
          ******************************************************************** */
         void load_state(const string state_str);
+		
+		/* *********************************************************************
+            Loads the OSystem's state from an already constructed 
+			Deserializer. The Deserializer is rewound first, so the same
+			one can be used to restore a state many times
+         ******************************************************************** */
+        void load_state(Deserializer& deser);
 
 		/* *********************************************************************
 			Copies the content of the simulated framebufer to pm_sim_scr_matrix
@@ -118,6 +144,13 @@ class SearchAgent : public PlayerAgent {
 								// action
 		int i_curr_num_sim_steps; // Number of simulate dsteps during the 
 								// current turn
+		int i_rollout_frame_skip; // Each random action in a Monte Carlo 
+								// rollout is held for this many frames. 
+								// 0 means the (slower) per-frame rollout
+		IntVect v_rollout_ram_watch; // RAM indices that force a reward and
+								// end-of-game check when they change 
+		SearchTelemetry* p_telemetry; // Collects the statistics of each 
+								// decision
         int i_screen_height;
         int i_screen_width;
 };
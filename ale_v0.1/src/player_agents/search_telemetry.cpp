@@ -0,0 +1,135 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  search_telemetry.cpp
+ *
+ *  Implementation of the SearchTelemetry class, which collects statistics for
+ *  every decision of the Search-Agent, and writes them as one CSV row per 
+ *  decision
+ **************************************************************************** */
+
+#include "search_telemetry.h"
+#include "search_tree.h"
+
+/* *********************************************************************
+	Constructor
+	An empty csv_file means the summaries are printed to cout
+ ******************************************************************* */
+SearchTelemetry::SearchTelemetry(OSystem* osystem, const string& csv_file) :
+	p_osystem(osystem),
+	p_csv_stream(NULL),
+	i_decision_start(0) {
+	if (csv_file != "") {
+		p_csv_stream = new ofstream(csv_file.c_str());
+		if (!p_csv_stream->is_open()) {
+			cerr << "SearchTelemetry: cannot open " << csv_file << endl;
+			exit(-1);
+		}
+		cout << "Writing the search telemetry to " << csv_file << endl;
+		write_header();
+	}
+	start_decision();
+}
+
+/* *********************************************************************
+	Deconstructor
+ ******************************************************************* */
+SearchTelemetry::~SearchTelemetry() {
+	if (p_csv_stream) {
+		p_csv_stream->close();
+		delete p_csv_stream;
+	}
+}
+
+/* *********************************************************************
+	Resets the counters, and starts timing a new decision
+ ******************************************************************* */
+void SearchTelemetry::start_decision(void) {
+	i_iterations = 0;
+	i_nodes_allocated = 0;
+	i_rollout_frames = 0;
+	i_rollout_usecs = 0;
+	i_emulate_usecs = 0;
+	i_save_load_usecs = 0;
+	i_reward_usecs = 0;
+	i_decision_start = get_ticks();
+}
+
+/* *********************************************************************
+	Collects the tree statistics and writes the decision's row
+ ******************************************************************* */
+void SearchTelemetry::end_decision(	int frame_num, const string& search_method,
+									bool tree_updated, Action action, 
+									long long sim_steps, 
+									const SearchTree* tree) {
+	long long total_usecs = (uInt32)(get_ticks() - i_decision_start);
+	long long bookkeeping_usecs = total_usecs - i_emulate_usecs - 
+								  i_save_load_usecs - i_reward_usecs;
+	if (bookkeeping_usecs < 0) {
+		bookkeeping_usecs = 0;
+	}
+	long long rollout_fps = 0;
+	if (i_rollout_usecs > 0) {
+		rollout_fps = (i_rollout_frames * 1000000) / i_rollout_usecs;
+	}
+	int num_nodes, max_depth;
+	long long state_bytes;
+	float mean_depth;
+	tree->get_tree_stats(num_nodes, state_bytes, max_depth, mean_depth);
+	
+	if (p_csv_stream == NULL) {
+		cout	<< "Frame: " << frame_num 
+				<< (tree_updated ? ", Tree Updated" : ", Tree Re-Constructed")
+				<< ", Action: " << action_to_string(action)
+				<< ", Root Value = " << tree->get_root_value()
+				<< " - Deepest Node Frame: " << tree->i_deepest_node_frame_num
+				<< " - Iterations: " << i_iterations
+				<< " - Nodes: " << num_nodes 
+				<< " (" << i_nodes_allocated << " new)"
+				<< " - Depth: " << max_depth << "/" << mean_depth
+				<< " - State KB: " << state_bytes / 1024;
+		if (i_rollout_usecs > 0) {
+			cout << " - Rollout Frames/Sec: " << rollout_fps;
+		}
+		cout << endl;
+		return;
+	}
+	(*p_csv_stream)	<< frame_num << ","
+					<< search_method << ","
+					<< tree_updated << ","
+					<< action_to_string(action) << ","
+					<< tree->get_root_value() << ","
+					<< tree->i_deepest_node_frame_num << ","
+					<< i_iterations << ","
+					<< i_nodes_allocated << ","
+					<< num_nodes << ","
+					<< state_bytes << ","
+					<< max_depth << ","
+					<< mean_depth << ","
+					<< sim_steps << ","
+					<< i_rollout_frames << ","
+					<< rollout_fps << ","
+					<< total_usecs << ","
+					<< i_emulate_usecs << ","
+					<< i_save_load_usecs << ","
+					<< i_reward_usecs << ","
+					<< bookkeeping_usecs << endl;
+}
+
+/* *********************************************************************
+	Writes the column names of the CSV stream
+ ******************************************************************* */
+void SearchTelemetry::write_header(void) {
+	(*p_csv_stream)	<< "frame,search_method,tree_updated,action,root_value,"
+					<< "deepest_node_frame,iterations,nodes_allocated,"
+					<< "tree_nodes,state_bytes,max_depth,mean_depth,"
+					<< "sim_steps,rollout_frames,rollout_fps,total_usecs,"
+					<< "emulate_usecs,save_load_usecs,reward_usecs,"
+					<< "bookkeeping_usecs" << endl;
+}
@@ -0,0 +1,96 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  search_telemetry.h
+ *
+ *  Implementation of the SearchTelemetry class, which collects statistics for
+ *  every decision of the Search-Agent, and writes them as one CSV row per 
+ *  decision
+ **************************************************************************** */
+
+#ifndef SEARCH_TELEMETRY_H
+#define SEARCH_TELEMETRY_H
+
+#include <fstream>
+#include "common_constants.h"
+#include "OSystem.hxx"
+
+class SearchTree;
+
+class SearchTelemetry {
+    /* *************************************************************************
+        Per-decision statistics of the Search-Agent. The counters are public
+		and are incremented directly by the search-agent, the tree-nodes and
+		the search-trees between start_decision() and end_decision().
+		When no telemetry file is given, a one-line summary is printed to 
+		cout instead of the CSV row.
+    ************************************************************************* */
+
+    public:
+		/* *********************************************************************
+            Constructor
+			An empty csv_file means the summaries are printed to cout
+         ******************************************************************* */
+		SearchTelemetry(OSystem* osystem, const string& csv_file);
+
+		/* *********************************************************************
+            Deconstructor
+         ******************************************************************* */
+		~SearchTelemetry();
+
+		/* *********************************************************************
+            Resets the counters, and starts timing a new decision
+         ******************************************************************* */
+		void start_decision(void);
+
+		/* *********************************************************************
+            Collects the tree statistics and writes the decision's row
+         ******************************************************************* */
+		void end_decision(	int frame_num, const string& search_method, 
+							bool tree_updated, Action action, 
+							long long sim_steps, const SearchTree* tree);
+
+		/* *********************************************************************
+            Returns the current time in micro-seconds
+         ******************************************************************* */
+		uInt32 get_ticks(void) const {
+			return p_osystem->getTicks();
+		}
+
+		/* *********************************************************************
+            Returns true when the per-frame costs (e.g. i_reward_usecs) 
+			should be timed, i.e. when they are written to the CSV file. 
+			Otherwise the simulated frames are only timed as a whole.
+         ******************************************************************* */
+		bool is_timing_frames(void) const {
+			return p_csv_stream != NULL;
+		}
+
+		int i_iterations;			// Iterations (UCT iterations, MC rollouts
+									// or full-tree expansions)
+		long long i_nodes_allocated;// Tree-nodes created
+		long long i_rollout_frames;	// Frames simulated in Monte Carlo rollouts
+		long long i_rollout_usecs;	// Time spent in rollouts
+		long long i_emulate_usecs;	// Time spent emulating frames
+		long long i_save_load_usecs;// Time spent saving and loading states
+		long long i_reward_usecs;	// Time spent copying the RAM/screen and
+									// evaluating the reward and end-of-game
+
+	protected:
+		/* *********************************************************************
+            Writes the column names of the CSV stream
+         ******************************************************************* */
+		void write_header(void);
+
+		OSystem* p_osystem;			// Used to read the time
+		ofstream* p_csv_stream;		// NULL when printing to cout
+		uInt32 i_decision_start;	// Time when the decision started
+};
+
+#endif
@@ -83,9 +83,7 @@ Action SearchTree::get_best_action(void) {
 		cout << "is now: " << best_branch << endl;
 	}
 	
-	Action best_act = (*p_search_agent->p_game_settings->
-											pv_possible_actions)[best_branch];
-	return best_act;
+	return p_root->v_children[best_branch]->e_action;
 }
 
 
@@ -147,3 +145,41 @@ void SearchTree::print(TreeNode* node) const {
 	}
 	cout << endl;
 }
+
+
+/* *********************************************************************
+	Returns the number of nodes in the tree, the bytes of state they 
+	hold, and the maximum and mean depth of the leaves
+ ******************************************************************* */
+void SearchTree::get_tree_stats(int& num_nodes, long long& state_bytes,
+								int& max_depth, float& mean_depth) const {
+	num_nodes = 0;
+	state_bytes = 0;
+	max_depth = 0;
+	mean_depth = 0;
+	if (p_root == NULL) {
+		return;
+	}
+	queue< pair<TreeNode*, int> > q;
+	q.push(make_pair(p_root, 0));
+	int num_leaves = 0;
+	long long sum_depth = 0;
+	while(!q.empty()) {
+		TreeNode* node = q.front().first;
+		int depth = q.front().second;
+		q.pop();
+		num_nodes++;
+		state_bytes += node->str_state.size();
+		if (node->is_leaf()) {
+			num_leaves++;
+			sum_depth += depth;
+			if (depth > max_depth) {
+				max_depth = depth;
+			}
+		}
+		for (unsigned int c = 0; c < node->v_children.size(); c++) {
+			q.push(make_pair(node->v_children[c], depth + 1));
+		}
+	}
+	mean_depth = (float)sum_depth / num_leaves;
+}
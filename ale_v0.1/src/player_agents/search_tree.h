@@ -66,6 +66,13 @@ class SearchTree {
          ******************************************************************* */
 		virtual void move_to_best_sub_branch(void);
 
+		/* *********************************************************************
+			Returns true when the tree is kept across decisions (and updated
+			from its best sub-branch), false when it is rebuilt every time
+         ******************************************************************* */
+		virtual bool is_reused(void) const {
+			return true;
+		}
 		
 		/* *********************************************************************
 			Returns the frame number of the root
@@ -77,7 +84,7 @@ class SearchTree {
 		/* *********************************************************************
 			Returns the the best branch-value for root
          ******************************************************************* */
-		float get_root_value(void) {
+		float get_root_value(void) const {
 			return p_root->v_children[p_root->i_best_branch]->f_branch_reward;
 		}
 
@@ -87,6 +94,13 @@ class SearchTree {
          ******************************************************************* */
 		virtual void print(TreeNode* node = NULL) const;
 
+		/* *********************************************************************
+			Returns the number of nodes in the tree, the bytes of state they 
+			hold, and the maximum and mean depth of the leaves
+         ******************************************************************* */
+		virtual void get_tree_stats(int& num_nodes, long long& state_bytes,
+									int& max_depth, float& mean_depth) const;
+
 
 		bool is_built;			// True whe the tree is built
 		int i_deepest_node_frame_num; // the frame number for the deepest node
@@ -153,4 +153,95 @@ bool calc_shape_distance(	const IntMatrix* pm_shape_a, const IntMatrix* pm_shape
 	return true;
 }
 
- 
\ No newline at end of file
+ 
+
+/* *****************************************************************************
+	Same as calc_shape_distance, for binary shapes packed in bit rows: the 
+	distance at each position is one XOR and popcount per row-word.
+	When max_pixel_distance is not negative, the pixel distances above it
+	are not calculated exactly: some value above max_pixel_distance is 
+	returned instead. 
+	The positions of the smaller shape are searched with a bound: a 
+	position is dropped as soon as its distance reaches the smallest one
+	found so far
+ **************************************************************************** */
+bool calc_packed_shape_distance(const PackedBitMatrix* pm_shape_a, 
+								const PackedBitMatrix* pm_shape_b, 
+								bool allow_different_size, 
+								float max_shape_area_dif,
+								int& pixel_distance, float& perc_distance,
+								int max_pixel_distance) {
+	int a_height = pm_shape_a->get_height();
+	int a_width  = pm_shape_a->get_width();
+	int b_height = pm_shape_b->get_height();
+	int b_width  = pm_shape_b->get_width();
+	
+	int a_area = a_width * a_height;
+	int b_area = b_width * b_height;
+	if (a_width == b_width && 
+		a_height == b_height) {
+		// Objects have the same shape
+		pixel_distance = pm_shape_a->get_window_distance(*pm_shape_b, 0, 0,
+														 max_pixel_distance);
+	} else {
+		// Objects have different shapes
+		if (!allow_different_size) {
+			pixel_distance = -1;
+			perc_distance = -1.0;
+			return false;
+		}
+		
+		// When one shape is smaller than the other, we move the smaller
+		// object inside the bigger object, and return the smallest distance
+		// This only makes sense when the shapes area is within a small range
+		if  (	( (float)a_area >  (max_shape_area_dif * b_area) ) || 
+				( (float)b_area > (max_shape_area_dif * a_area) )	) {
+			// size difference is too big
+			pixel_distance = -1;
+			perc_distance = -1.0;
+			return false;
+		}
+
+		const PackedBitMatrix *bigger_shape, *smaller_shape;
+		int width_dif, height_dif;
+		if (a_width <= b_width && 
+			a_height <= b_height) {
+			bigger_shape = pm_shape_b;
+			smaller_shape = pm_shape_a;
+			width_dif = b_width - a_width;
+			height_dif = b_height - a_height;
+		} else if (	a_width >= b_width && 
+					a_height >= b_height) {
+			bigger_shape = pm_shape_a;
+			smaller_shape = pm_shape_b;
+			width_dif = a_width - b_width;
+			height_dif =  a_height - b_height;
+		} else {
+			// incompatible shapes
+			pixel_distance = -1;
+			perc_distance = -1.0;
+			return false;
+		}
+		
+		assert (width_dif >= 0 &&  height_dif >= 0);
+		int smallest_distance = -1;
+		for (int i = 0; i <= height_dif && smallest_distance != 0; i++) {
+			for (int j = 0; j <= width_dif && smallest_distance != 0; j++) {
+				int bound = max_pixel_distance;
+				if (smallest_distance > 0 && 
+					(bound < 0 || smallest_distance - 1 < bound)) {
+					bound = smallest_distance - 1;
+				}
+				int dist = bigger_shape->get_window_distance(*smaller_shape,
+															 i, j, bound);
+				if (smallest_distance == -1 || dist < smallest_distance) {
+					smallest_distance = dist;
+				}
+			}
+		}
+		pixel_distance = smallest_distance;
+	}
+	int num_pixels = a_area + b_area;
+	perc_distance = float(pixel_distance) / float(num_pixels);
+	return true;
+}
@@ -15,6 +15,7 @@
 #define SHAPE_TOOLS_H
 
 #include "common_constants.h"
+#include "packed_bit_matrix.h"
 
 /* *****************************************************************************
 	Flips a 2D shape matrix horizentaly or vertically
@@ -32,6 +33,20 @@ bool calc_shape_distance(	const IntMatrix* pm_shape_a, const IntMatrix* pm_shape
 					bool allow_different_size, float max_shape_area_dif,
 					int& pixel_distance, float& perc_distance);
 
+/* *****************************************************************************
+	Same as calc_shape_distance, for binary shapes packed in bit rows: the 
+	distance at each position is one XOR and popcount per row-word.
+	When max_pixel_distance is not negative, the pixel distances above it
+	are not calculated exactly: some value above max_pixel_distance is 
+	returned instead
+ **************************************************************************** */
+bool calc_packed_shape_distance(const PackedBitMatrix* pm_shape_a, 
+								const PackedBitMatrix* pm_shape_b, 
+								bool allow_different_size, 
+								float max_shape_area_dif,
+								int& pixel_distance, float& perc_distance,
+								int max_pixel_distance = -1);
+
 
  #endif 
  
\ No newline at end of file
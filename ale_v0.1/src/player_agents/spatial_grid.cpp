@@ -0,0 +1,68 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  spatial_grid.cpp
+ *
+ *  Implementation of the SpatialGrid class, a uniform grid over the screen
+ *  used to find the objects of the previous frame that are close to an
+ *  object of the current frame
+ **************************************************************************** */
+
+#include <algorithm>
+#include "spatial_grid.h"
+
+/* *********************************************************************
+	Constructor: an empty grid over a screen of the given size
+ ******************************************************************** */
+SpatialGrid::SpatialGrid(int height, int width, int cell_size) {
+	i_cell_size = max(cell_size, 1);
+	i_num_cols = (width + i_cell_size - 1) / i_cell_size;
+	i_num_rows = (height + i_cell_size - 1) / i_cell_size;
+	v_cells.resize(i_num_cols * i_num_rows);
+}
+
+/* *********************************************************************
+	Removes all the points
+ ******************************************************************** */
+void SpatialGrid::clear(void) {
+	for (unsigned int i = 0; i < v_used_cells.size(); i++) {
+		v_cells[v_used_cells[i]].clear();
+	}
+	v_used_cells.clear();
+}
+
+/* *********************************************************************
+	Adds the point (x, y), with the given index
+ ******************************************************************** */
+void SpatialGrid::add_point(int x, int y, int ind) {
+	int cell = get_cell_coord(y, i_num_rows) * i_num_cols + 
+			   get_cell_coord(x, i_num_cols);
+	if (v_cells[cell].empty()) {
+		v_used_cells.push_back(cell);
+	}
+	v_cells[cell].push_back(ind);
+}
+
+/* *********************************************************************
+	Fills inds with the indices of the points in the 3x3 cells around
+	(x, y), in ascending order (i.e. the order of a scan of the whole 
+	list)
+ ******************************************************************** */
+void SpatialGrid::get_nearby_points(int x, int y, IntVect& inds) const {
+	inds.clear();
+	int col = get_cell_coord(x, i_num_cols);
+	int row = get_cell_coord(y, i_num_rows);
+	for (int i = max(row - 1, 0); i <= min(row + 1, i_num_rows - 1); i++) {
+		for (int j = max(col - 1, 0); j <= min(col + 1, i_num_cols - 1); j++) {
+			const IntVect& cell = v_cells[i * i_num_cols + j];
+			inds.insert(inds.end(), cell.begin(), cell.end());
+		}
+	}
+	sort(inds.begin(), inds.end());
+}
@@ -0,0 +1,77 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  spatial_grid.h
+ *
+ *  Implementation of the SpatialGrid class, a uniform grid over the screen
+ *  used to find the objects of the previous frame that are close to an
+ *  object of the current frame
+ **************************************************************************** */
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include "common_constants.h"
+
+class SpatialGrid {
+    /* *************************************************************************
+        A uniform grid of square cells over the screen. Each cell keeps the 
+		indices of the points added in it. With cells as large as the 
+		maximum object velocity, all the points within that velocity of a 
+		position (on both axes) are in the 3x3 cells around it.
+        
+        Instance variabls:
+		- i_cell_size			Width and height of each cell
+		- i_num_cols			Number of cells in each row of cells
+		- i_num_rows			Number of rows of cells
+		- v_cells				The point indices of each cell
+		- v_used_cells			The cells that have points (so that only 
+								these are cleared)
+    ************************************************************************* */
+
+    public:
+        /* *********************************************************************
+            Constructor: an empty grid over a screen of the given size
+         ******************************************************************** */
+        SpatialGrid(int height, int width, int cell_size);
+
+		/* *********************************************************************
+            Removes all the points
+         ******************************************************************** */
+		void clear(void);
+
+		/* *********************************************************************
+            Adds the point (x, y), with the given index
+         ******************************************************************** */
+		void add_point(int x, int y, int ind);
+
+		/* *********************************************************************
+            Fills inds with the indices of the points in the 3x3 cells around
+			(x, y), in ascending order (i.e. the order of a scan of the
+			whole list)
+         ******************************************************************** */
+		void get_nearby_points(int x, int y, IntVect& inds) const;
+
+	protected:
+		/* *********************************************************************
+            Returns the cell column of x (or the cell row of y), clamped to 
+			the grid
+         ******************************************************************** */
+		inline int get_cell_coord(int v, int num_cells) const {
+			return max(0, min(v / i_cell_size, num_cells - 1));
+		}
+
+		int i_cell_size;
+		int i_num_cols;
+		int i_num_rows;
+		vector<IntVect> v_cells;
+		IntVect v_used_cells;
+};
+
+#endif
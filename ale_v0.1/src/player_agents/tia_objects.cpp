@@ -0,0 +1,177 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  tia_objects.cpp
+ *
+ *  Implementation of the TIAObjects class, which turns the object trace
+ *  recorded by the TIA into a list of the objects on the screen
+ **************************************************************************** */
+
+#include "tia_objects.h"
+#include "bit_pair_tools.h"
+
+#define NUM_TIA_OBJECTS 5	// P0, P1, M0, M1 and BL
+
+// The horizontal offsets of the copies of a player or missile, for each
+// number-and-size mode (the low 3 bits of NUSIZ), ending with -1
+static const int copy_offsets[8][4] = {
+	{0, -1},			// One copy
+	{0, 16, -1},		// Two copies - close
+	{0, 32, -1},		// Two copies - medium
+	{0, 16, 32, -1},	// Three copies - close
+	{0, 64, -1},		// Two copies - wide
+	{0, -1},			// Double size player
+	{0, 32, 64, -1},	// Three copies - medium
+	{0, -1}				// Quad size player
+};
+
+TIAObjects::TIAObjects(OSystem* osystem) {
+	MediaSource& mediasrc = osystem->console().mediaSource();
+	// The TIA is our only MediaSource
+	p_tia = (TIA*)(&mediasrc);
+	p_tia->enableObjectTrace(true);
+	i_height = mediasrc.height();
+	i_width = mediasrc.width();
+	b_is_built = false;
+}
+
+TIAObjects::~TIAObjects() {
+	p_tia->enableObjectTrace(false);
+}
+
+/* *********************************************************************
+	Returns the objects on the current frame
+ ******************************************************************** */
+const TIAObjectVect& TIAObjects::get_objects(void) {
+	if (!b_is_built) {
+		build();
+	}
+	return v_objects;
+}
+
+/* *********************************************************************
+	Returns the bits of the trace line that decide the position and size
+	of the given object: two rows with different keys cannot draw the
+	same object
+ ******************************************************************** */
+static inline int get_object_key(const TIA::ObjectTraceLine& line, int type) {
+	int key = line.x[type] << 8;
+	switch (type) {
+		case TIA::P0:
+		case TIA::P1:
+			return key | (line.nusiz[type - TIA::P0] & 0x07);
+		case TIA::M0:
+		case TIA::M1:
+			return key | (line.nusiz[type - TIA::M0] & 0x37);
+		default:
+			return key | (line.ctrlpf & 0x30);
+	}
+}
+
+/* *********************************************************************
+	Builds the list of the objects from the object trace: for each
+	object, the consecutive rows that draw it with the same key are
+	joined
+ ******************************************************************** */
+void TIAObjects::build(void) {
+	v_objects.clear();
+	const TIA::ObjectTraceLine* trace = p_tia->objectTrace();
+	for (int type = 0; type < NUM_TIA_OBJECTS; type++) {
+		int bit = 1 << type;
+		int y = 0;
+		while (y < i_height) {
+			if (!(trace[y].enabled & bit)) {
+				y++;
+				continue;
+			}
+			int key = get_object_key(trace[y], type);
+			int end_y = y + 1;
+			while (end_y < i_height && (trace[end_y].enabled & bit) &&
+				   get_object_key(trace[end_y], type) == key) {
+				end_y++;
+			}
+			add_object(type, y, end_y);
+			y = end_y;
+		}
+	}
+	b_is_built = true;
+}
+
+/* *********************************************************************
+	Adds the copies of the object of the given type drawn on the rows
+	[first_row, end_row), which all have the same position and size
+	as first_row
+ ******************************************************************** */
+void TIAObjects::add_object(int type, int first_row, int end_row) {
+	const TIA::ObjectTraceLine* trace = p_tia->objectTrace();
+	const TIA::ObjectTraceLine& line = trace[first_row];
+	int x = line.x[type];
+	int color = line.color[type];
+	int width;
+	int mode;
+	if (type == TIA::P0 || type == TIA::P1) {
+		int player = type - TIA::P0;
+		// The box is only as wide as the pixels set on some row, and the
+		// color is the one of the row with the most pixels
+		int grp_bits = 0;
+		int max_row_pixels = 0;
+		for (int y = first_row; y < end_row; y++) {
+			grp_bits |= trace[y].grp[player];
+			int row_pixels = count_bits(trace[y].grp[player]);
+			if (row_pixels > max_row_pixels) {
+				max_row_pixels = row_pixels;
+				color = trace[y].color[type];
+			}
+		}
+		if (grp_bits == 0) {
+			return;
+		}
+		mode = line.nusiz[player] & 0x07;
+		int scale = 1;
+		if (mode == 0x05) {
+			scale = 2;
+		} else if (mode == 0x07) {
+			scale = 4;
+		}
+		int first_pixel = 0;
+		while (!(grp_bits & (0x80 >> first_pixel))) {
+			first_pixel++;
+		}
+		int last_pixel = 7;
+		while (!(grp_bits & (0x80 >> last_pixel))) {
+			last_pixel--;
+		}
+		// In double and quad size modes, the player is delayed by a pixel
+		if (scale > 1) {
+			x++;
+		}
+		x += first_pixel * scale;
+		width = (last_pixel - first_pixel + 1) * scale;
+	} else if (type == TIA::M0 || type == TIA::M1) {
+		int nusiz = line.nusiz[type - TIA::M0];
+		mode = nusiz & 0x07;
+		width = 1 << ((nusiz >> 4) & 0x03);
+	} else {
+		mode = 0;
+		width = 1 << ((line.ctrlpf >> 4) & 0x03);
+	}
+	for (int c = 0; copy_offsets[mode][c] >= 0; c++) {
+		TIAObject obj;
+		obj.type = type;
+		obj.x = (x + copy_offsets[mode][c]) % i_width;
+		if (obj.x < 0) {
+			obj.x += i_width;
+		}
+		obj.y = first_row;
+		obj.width = min(width, i_width - obj.x);
+		obj.height = end_row - first_row;
+		obj.color = color;
+		v_objects.push_back(obj);
+	}
+}
@@ -0,0 +1,101 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  tia_objects.h
+ *
+ *  Implementation of the TIAObjects class, which turns the object trace
+ *  recorded by the TIA into a list of the objects on the screen
+ **************************************************************************** */
+
+#ifndef TIA_OBJECTS_H
+#define TIA_OBJECTS_H
+
+#include "OSystem.hxx"
+#include "TIA.hxx"
+#include "common_constants.h"
+
+// One object drawn by the TIA on the current frame
+struct TIAObject {
+	int type;		// The TIA object (TIA::P0, P1, M0, M1 or BL)
+	int x;			// Left column of the bounding box
+	int y;			// Top row of the bounding box
+	int width;
+	int height;
+	int color;		// Color of the row of the object with the most pixels
+};
+typedef vector<TIAObject> TIAObjectVect;
+
+class TIAObjects {
+    /* *************************************************************************
+        Reads the movable objects (players, missiles and ball) of each frame
+		directly from the TIA, instead of detecting them on the screen.
+		The TIA records the position, graphics, size and color of the
+		objects on each scanline (the object trace), and the scanlines that
+		draw the same object at the same position are joined into one
+		object. Each copy of a player or missile (NUSIZ) is an object of its
+		own, and the objects that wrap around the right edge of the screen
+		are cut at the edge.
+		The list is built lazily, by the first query after set_frame, so
+		the agents that do not use it pay nothing but the trace
+
+        Instance variabls:
+		- p_tia					The TIA of the console
+		- i_height				Height of the screen
+		- i_width				Width of the screen
+		- b_is_built			True when the list is up-to-date with the
+								current frame
+		- v_objects				The objects of the current frame, by type
+								and then top to bottom
+    ************************************************************************* */
+
+    public:
+        TIAObjects(OSystem* osystem);
+        virtual ~TIAObjects();
+
+		/* *********************************************************************
+            Called on each new frame. The list is rebuilt by the next query
+         ******************************************************************** */
+		void set_frame(void) {
+			b_is_built = false;
+		}
+
+		/* *********************************************************************
+            Returns the objects on the current frame
+         ******************************************************************** */
+		const TIAObjectVect& get_objects(void);
+
+		/* *********************************************************************
+            Returns the object trace of the current frame, one line per row
+			of the screen
+         ******************************************************************** */
+		const TIA::ObjectTraceLine* get_trace(void) const {
+			return p_tia->objectTrace();
+		}
+
+	protected:
+		/* *********************************************************************
+            Builds the list of the objects from the object trace
+         ******************************************************************** */
+		void build(void);
+
+		/* *********************************************************************
+            Adds the copies of the object of the given type drawn on the rows
+			[first_row, end_row), which all have the same position and size
+			as first_row
+         ******************************************************************** */
+		void add_object(int type, int first_row, int end_row);
+
+		TIA* p_tia;
+		int i_height;
+		int i_width;
+		bool b_is_built;
+		TIAObjectVect v_objects;
+};
+
+#endif
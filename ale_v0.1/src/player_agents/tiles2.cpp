@@ -17,8 +17,9 @@ across integer values.
  
 It is recommended by the UNH folks that num-tilings be a power of 2, e.g., 16. 
  
-We assume the existence of a function "rand()" that produces successive
-random integers, of which we use only the low-order bytes.
+The random numbers of the hashing come from their own generator, with a fixed
+seed (HASH_RNDSEQ_SEED), so that the tiles (and the hashed weight slots) of a
+feature are the same in every run, whatever the seed of rand().
 */
 
 #include <iostream>
@@ -187,14 +188,19 @@ int hash_UNH(int *ints, int num_ints, long m, int increment)
     long index;
     long sum = 0;
 
-    /* if first call to hashing, initialize table of random numbers */
+    /* if first call to hashing, initialize table of random numbers 
+       (with a linear congruential generator, independent of rand()) */
     if (first_call)
     {
+        unsigned int rnd_state = HASH_RNDSEQ_SEED;
         for (k = 0; k < 2048; k++)
         {
             rndseq[k] = 0;
             for (i=0; i < (int)sizeof(int); ++i)
-                rndseq[k] = (rndseq[k] << 8) | (rand() & 0xff);
+            {
+                rnd_state = rnd_state * 1103515245 + 12345;
+                rndseq[k] = (rndseq[k] << 8) | ((rnd_state >> 16) & 0xff);
+            }
         }
         first_call = 0;
     }
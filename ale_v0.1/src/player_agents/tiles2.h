@@ -11,6 +11,7 @@
 #define MAX_NUM_VARS 20        // Maximum number of variables in a grid-tiling      
 #define MAX_NUM_COORDS 100     // Maximum number of hashing coordinates      
 #define MaxLONGINT 2147483647  
+#define HASH_RNDSEQ_SEED 12345 // Seed of the random numbers of the hashing
 
 void GetTiles(
 	int tiles[],               // provided array contains returned tiles (tile indices)
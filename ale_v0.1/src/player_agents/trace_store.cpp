@@ -0,0 +1,77 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  trace_store.cpp
+ *
+ *  Implementation of the TraceStore class, which keeps the non-zero 
+ *  eligibility traces of Sarsa-Lambda in packed parallel arrays
+ **************************************************************************** */
+
+#include "trace_store.h"
+
+/* *********************************************************************
+	Constructor
+	num_slots is the size of the weights vector
+ ******************************************************************* */
+TraceStore::TraceStore(int num_slots, int max_traces, double min_trace) :
+	v_slots(max(max_traces, 1), -1),
+	v_values(max(max_traces, 1), 0.0f),
+	v_locs(num_slots, -1),
+	i_num_traces(0),
+	i_max_traces(max_traces),
+	f_min_trace(min_trace) {
+}
+
+/* *********************************************************************
+	Multiplies all the traces by decay_rate, and drops the ones that 
+	fall below f_min_trace
+ ******************************************************************* */
+void TraceStore::decay(float decay_rate) {
+	float* values = &v_values[0];
+	for (int i = 0; i < i_num_traces; i++) {	// vectorized
+		values[i] *= decay_rate;
+	}
+	compact();
+}
+
+/* *********************************************************************
+	Drops the traces below f_min_trace (and the cleared ones). Each 
+	dropped entry is replaced by the last entry, so only the moved 
+	entries touch v_locs
+ ******************************************************************* */
+void TraceStore::compact(void) {
+	int* slots = &v_slots[0];
+	float* values = &v_values[0];
+	// Going backwards, the last entry has always been checked already
+	for (int i = i_num_traces - 1; i >= 0; i--) {
+		float value = values[i];
+		if (value >= f_min_trace && value > 0.0f) {
+			continue;
+		}
+		v_locs[slots[i]] = -1;
+		i_num_traces--;
+		if (i != i_num_traces) {
+			slots[i] = slots[i_num_traces];
+			values[i] = values[i_num_traces];
+			v_locs[slots[i]] = i;
+		}
+	}
+}
+
+/* *********************************************************************
+	Compacts the store, and then increases f_min_trace by 10% until 
+	there is room for one more trace
+ ******************************************************************* */
+void TraceStore::make_room(void) {
+	compact();
+	while (i_num_traces >= i_max_traces) {
+		f_min_trace += (0.1 * f_min_trace);
+		compact();
+	}
+}
@@ -0,0 +1,116 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  trace_store.h
+ *
+ *  Implementation of the TraceStore class, which keeps the non-zero 
+ *  eligibility traces of Sarsa-Lambda in packed parallel arrays
+ **************************************************************************** */
+
+#ifndef TRACE_STORE_H
+#define TRACE_STORE_H
+
+#include "common_constants.h"
+
+class TraceStore {
+    /* *************************************************************************
+        Keeps at most i_max_traces non-zero traces, as a packed array of 
+		weight slots and a parallel packed array of trace values. 
+		Only v_locs (the position of each slot in the packed arrays) is 
+		as long as the weights vector.
+		Decaying is one vectorized pass over the packed values, followed by 
+		a pass that drops the traces that fell below f_min_trace. Neither 
+		pass reads the weights-long arrays. Clearing a trace only zeroes 
+		its value, and the entry is dropped at the next compaction.
+		Note: the packed arrays may hold cleared (zero) traces between a 
+		clear() and the next decay()
+    ************************************************************************* */
+
+    public:
+		/* *********************************************************************
+            Constructor
+			num_slots is the size of the weights vector
+         ******************************************************************* */
+		TraceStore(int num_slots, int max_traces, double min_trace);
+
+		/* *********************************************************************
+            Sets the trace of the given slot. When the store is full, 
+			f_min_trace is increased by 10% (as many times as needed), to 
+			make room for the new trace
+         ******************************************************************* */
+		inline void set(int slot, float value) {
+			int loc = v_locs[slot];
+			if (loc >= 0) {
+				v_values[loc] = value;	// trace already exists
+				return;
+			}
+			if (i_num_traces >= i_max_traces) {
+				make_room();
+			}
+			v_slots[i_num_traces] = slot;
+			v_values[i_num_traces] = value;
+			v_locs[slot] = i_num_traces;
+			i_num_traces++;
+		}
+
+		/* *********************************************************************
+            Clears the trace of the given slot, if any
+         ******************************************************************* */
+		inline void clear(int slot) {
+			int loc = v_locs[slot];
+			if (loc >= 0) {
+				v_values[loc] = 0.0f;
+			}
+		}
+
+		/* *********************************************************************
+            Returns the trace of the given slot
+         ******************************************************************* */
+		inline float get(int slot) const {
+			int loc = v_locs[slot];
+			return loc >= 0 ? v_values[loc] : 0.0f;
+		}
+
+		/* *********************************************************************
+            Multiplies all the traces by decay_rate, and drops the ones that 
+			fall below f_min_trace
+         ******************************************************************* */
+		void decay(float decay_rate);
+
+		/* *********************************************************************
+            Accessors. get_slots()[i] and get_values()[i], for i < size(), 
+			are the packed traces
+         ******************************************************************* */
+		int size(void) const {return i_num_traces;}
+		const int* get_slots(void) const {return &v_slots[0];}
+		const float* get_values(void) const {return &v_values[0];}
+		double get_min_trace(void) const {return f_min_trace;}
+		int get_max_traces(void) const {return i_max_traces;}
+
+	protected:
+		/* *********************************************************************
+            Drops the traces below f_min_trace (and the cleared ones)
+         ******************************************************************* */
+		void compact(void);
+
+		/* *********************************************************************
+            Compacts the store, and then increases f_min_trace by 10% until 
+			there is room for one more trace
+         ******************************************************************* */
+		void make_room(void);
+
+		IntVect v_slots;		// Packed weight slots of the non-zero traces
+		vector<float> v_values;	// Packed trace values, parallel to v_slots
+		IntVect v_locs;			// Position of each slot in v_slots, or -1
+		int i_num_traces;		// Number of used entries in the packed arrays
+		int i_max_traces;		// Size of the packed arrays
+		double f_min_trace;		// Traces below this value are dropped
+};
+
+#endif
@@ -28,16 +28,18 @@ TreeNode::TreeNode(	TreeNode* parent, const string start_state,
 					int num_simulate_steps, Action a):
 	p_parent(parent),
 	str_state(""), 
+	i_state_handle(-1),
 	i_frame_num(-1),
 	f_node_reward(0.0), 
 	f_branch_reward(0.0),
 	i_best_branch(-1), 
 	b_is_dead(false),
+	e_action(a),
 	f_uct_value(0.0),
 	i_uct_visit_count(0),
 	i_uct_death_count(0),
-    i_mc_current_child(-1),
 	f_uct_sum_reward(0.0)  {
+	search_agent->p_telemetry->i_nodes_allocated++;
 	// Simulate the game for si_num_sim_steps
 	search_agent->load_state(start_state);
 	search_agent->simulate_game(a, num_simulate_steps, start_frame_num, 
@@ -44,6 +44,8 @@ class TreeNode {
 		}
 		
 		string str_state;		// The state of current node
+		int i_state_handle;		// Handle of the state in a PackedStateStore. 
+								// -1 when the state is kept in str_state
 		float f_node_reward;	// reward recieved in this node
 		float f_branch_reward;	// best reward possible in this branch
 								// = node_reward + max(children.branch_reward)
@@ -53,6 +55,7 @@ class TreeNode {
 		bool b_is_dead;		// true when either the game ended in
 							// this node, or all children are dead
 		int i_frame_num;	// The frame number for the state of this node. 
+		Action e_action;	// The action that was taken to get to this node
 		NodeList v_children;// vector of children nodes
 		TreeNode* p_parent;	// pointer to our parent
 		float f_uct_value;	// This is the UCT value, which helps us decide
@@ -62,7 +65,6 @@ class TreeNode {
 								// node, how many times did we end up dead?
 		float f_uct_sum_reward;	// Sum of the rewards we have recieved through
 								//  all simulations from this node
-        int i_mc_current_child; //current Monte Carlo child, used to get next child for Monte Carlo rollout
 		
 };
 
@@ -39,6 +39,20 @@ UCTSearchTree::UCTSearchTree(SearchAgent* search_agent) :
 		cout << "UCT: uct_avg_reward_per_frame is true. " << 
 				"looking at reward/frame, not just reward" << endl;
 	}
+	b_prune_actions = settings.getBool("uct_prune_actions", true);
+	i_prune_warmup_expansions = settings.getInt("uct_prune_warmup_expansions",
+																		true);
+	i_prune_recheck_frq = settings.getInt("uct_prune_recheck_frq", true);
+	if (b_prune_actions) {
+		cout << "UCT: pruning equivalent actions after " 
+			 << i_prune_warmup_expansions << " expansions" << endl;
+	}
+	i_num_expansions = 0;
+	int num_actions = p_search_agent->i_num_actions;
+	v_same_successor.resize(num_actions, BitArr(true, num_actions));
+	for (int a = 0; a < num_actions; a++) {
+		v_action_class.push_back(a);
+	}
 }
 
 /* *********************************************************************
@@ -75,7 +89,7 @@ void UCTSearchTree::update_tree(void) {
 		single_uct_iteration();
 		if (p_search_agent->get_num_simulated_steps() > 
 			i_max_sim_steps_per_tree) {
-			cout << "Perfomred " << i << " UCT iterations" << endl;
+			p_search_agent->p_telemetry->i_iterations = i;
 			break;
 		}
 	}
@@ -147,9 +161,7 @@ Action UCTSearchTree::get_best_action(void) {
 		cout << "is now: " << best_branch << endl;
 	}
 	p_root->i_best_branch = best_branch;
-	Action best_act = (*p_search_agent->p_game_settings->
-											pv_possible_actions)[best_branch];
-	return best_act;
+	return p_root->v_children[best_branch]->e_action;
 }
 
 /* *********************************************************************
@@ -230,7 +242,12 @@ int UCTSearchTree::get_best_branch(TreeNode* node,
  ******************************************************************* */
 void UCTSearchTree::expand_node(TreeNode* node) {
 	assert(node->is_leaf());
+	bool full_expansion = do_full_expansion();
+	i_num_expansions++;
 	for (int a = 0; a < p_search_agent->i_num_actions; a++) {
+		if (!full_expansion && v_action_class[a] != a) {
+			continue;	// an equivalent action is already expanded
+		}
 		Action act = (*p_search_agent->p_game_settings->pv_possible_actions)[a];
 		TreeNode* new_child = new TreeNode(	node,
 											node->str_state, 
@@ -249,6 +266,64 @@ void UCTSearchTree::expand_node(TreeNode* node) {
 			new_child->f_branch_reward /= frames_from_root;
 		}
 	}
+	if (b_prune_actions && full_expansion) {
+		update_action_classes(node);
+	}
+}
+
+/* *********************************************************************
+	Returns true if the next expansion should generate a child for 
+	every action (to learn or re-check the action classes)
+ ******************************************************************* */
+bool UCTSearchTree::do_full_expansion(void) const {
+	if (!b_prune_actions || i_num_expansions < i_prune_warmup_expansions) {
+		return true;
+	}
+	return (i_prune_recheck_frq > 0 && 
+			i_num_expansions % i_prune_recheck_frq == 0);
+}
+
+/* *********************************************************************
+	Compares the children of a fully expanded node, and splits any 
+	two actions that led to different states into different classes
+ ******************************************************************* */
+void UCTSearchTree::update_action_classes(const TreeNode* node) {
+	int num_actions = node->v_children.size();
+	assert(num_actions == p_search_agent->i_num_actions);
+	bool classes_changed = false;
+	for (int a = 0; a < num_actions; a++) {
+		for (int b = a + 1; b < num_actions; b++) {
+			if (v_same_successor[a][b] && 
+				node->v_children[a]->str_state != 
+				node->v_children[b]->str_state) {
+				v_same_successor[a][b] = false;
+				v_same_successor[b][a] = false;
+				classes_changed = true;
+			}
+		}
+	}
+	if (!classes_changed && i_num_expansions != i_prune_warmup_expansions) {
+		return;
+	}
+	// Each action is represented by the first action it is equivalent to.
+	// Equality of states is transitive, so this gives a partition.
+	int num_classes = 0;
+	for (int a = 0; a < num_actions; a++) {
+		v_action_class[a] = a;
+		for (int b = 0; b < a; b++) {
+			if (v_same_successor[a][b]) {
+				v_action_class[a] = b;
+				break;
+			}
+		}
+		if (v_action_class[a] == a) {
+			num_classes++;
+		}
+	}
+	if (i_num_expansions >= i_prune_warmup_expansions) {
+		cout << "UCT: " << num_classes << " action classes out of " 
+			 << num_actions << " actions" << endl;
+	}
 }
 
 
@@ -83,6 +83,18 @@ class UCTSearchTree : public SearchTree {
 		 ******************************************************************* */
 		void expand_node(TreeNode* node);
 
+		/* *********************************************************************
+			Returns true if the next expansion should generate a child for 
+			every action (to learn or re-check the action classes)
+		 ******************************************************************* */
+		bool do_full_expansion(void) const;
+
+		/* *********************************************************************
+			Compares the children of a fully expanded node, and splits any 
+			two actions that led to different states into different classes
+		 ******************************************************************* */
+		void update_action_classes(const TreeNode* node);
+
 		/* *********************************************************************
 			Performs a Monte Carlo simulation from the given node, for
 			i_uct_monte_carlo_steps steps 
@@ -109,6 +121,19 @@ class UCTSearchTree : public SearchTree {
 									// reward/frame (not just reward). 
 									// This is to prevent"	biasing towards 
 									// exploring already deeper sub-branches
+		bool b_prune_actions;		// When true, only one action from each 
+									// group of equivalent actions is expanded
+		int i_prune_warmup_expansions;// Number of full expansions used to 
+									// learn the action classes
+		int i_prune_recheck_frq;	// Every this many expansions we do a 
+									// full expansion to re-check the classes
+		int i_num_expansions;		// Number of expansions so far (kept 
+									// across decisions)
+		vector<BitArr> v_same_successor; // v_same_successor[a][b] is true 
+									// while actions a and b have always led 
+									// to identical states
+		IntVect v_action_class;		// Representative action-index for 
+									// each action
 };
 
 
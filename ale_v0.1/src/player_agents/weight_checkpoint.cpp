@@ -0,0 +1,248 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  weight_checkpoint.cpp
+ *
+ *  Implementation of the binary weight checkpoints: the WeightCheckpointWriter
+ *  class, which writes snapshots of a WeightVector from a background thread,
+ *  and the functions that load them back through mmap
+ **************************************************************************** */
+
+#include "weight_checkpoint.h"
+#include "tiles2.h"
+#include <cstdio>
+#include <cstring>
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CRC_CHUNK_BYTES (1 << 30)	// zlib's crc32 takes at most a uInt
+
+/* *********************************************************************
+	Returns the crc32 of the given bytes
+ ******************************************************************* */
+static unsigned int checksum(const char* data, long long num_bytes) {
+	uLong crc = crc32(0L, Z_NULL, 0);
+	while (num_bytes > 0) {
+		uInt chunk = (uInt)min(num_bytes, (long long)CRC_CHUNK_BYTES);
+		crc = crc32(crc, (const Bytef*)data, chunk);
+		data += chunk;
+		num_bytes -= chunk;
+	}
+	return (unsigned int)crc;
+}
+
+/* *********************************************************************
+	Returns the value at the given slot of a raw array of the given
+	precision
+ ******************************************************************* */
+static double raw_value(const char* data, int precision, double fixed_step,
+						int slot) {
+	switch (precision) {
+		case DOUBLE_PRECISION:	return ((const double*)data)[slot];
+		case SINGLE_PRECISION:	return ((const float*)data)[slot];
+		default:				return ((const short*)data)[slot] * fixed_step;
+	}
+}
+
+/* *********************************************************************
+	Returns true if the given file starts with WEIGHT_CHECKPOINT_MAGIC
+ ******************************************************************* */
+bool is_weight_checkpoint(const string& filename) {
+	char magic[8];
+	FILE* file = fopen(filename.c_str(), "rb");
+	if (file == NULL) {
+		return false;
+	}
+	size_t num_read = fread(magic, 1, sizeof(magic), file);
+	fclose(file);
+	return (num_read == sizeof(magic) &&
+			memcmp(magic, WEIGHT_CHECKPOINT_MAGIC, sizeof(magic)) == 0);
+}
+
+/* *********************************************************************
+	Loads the checkpoint in the given file into p_weights, through mmap.
+	When the precision and layout of the file match those of p_weights,
+	the values are copied as one block; otherwise they are converted one
+	by one. p_hash_table is the hash-table of the hashed storage (NULL 
+	with the dense storage); its keys are restored from the file.
+	Exits when the file is not a valid checkpoint for p_weights, or was 
+	saved with another storage
+ ******************************************************************* */
+void load_weight_checkpoint(const string& filename, WeightVector* p_weights,
+							int num_actions, int interleave_base,
+							collision_table* p_hash_table) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	struct stat file_stat;
+	if (fd == -1 || fstat(fd, &file_stat) != 0) {
+		cerr << "Cannot open the weights checkpoint " << filename << endl;
+		exit(-1);
+	}
+	long long file_size = file_stat.st_size;
+	if (file_size < (long long)sizeof(WeightCheckpointHeader)) {
+		cerr << "Weights checkpoint " << filename << " is truncated" << endl;
+		exit(-1);
+	}
+	void* map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		cerr << "Cannot map the weights checkpoint " << filename << endl;
+		exit(-1);
+	}
+	const WeightCheckpointHeader* p_header = (const WeightCheckpointHeader*)map;
+	const char* data = (const char*)map + sizeof(WeightCheckpointHeader);
+	if (memcmp(p_header->magic, WEIGHT_CHECKPOINT_MAGIC, 8) != 0 ||
+		p_header->version != WEIGHT_CHECKPOINT_VERSION) {
+		cerr << filename << " is not a version " << WEIGHT_CHECKPOINT_VERSION
+			 << " weights checkpoint" << endl;
+		exit(-1);
+	}
+	if (p_header->num_weights != p_weights->size() ||
+		p_header->num_actions != num_actions) {
+		cerr << "Weights checkpoint " << filename << " has "
+			 << p_header->num_weights << " weights and "
+			 << p_header->num_actions << " actions, expected "
+			 << p_weights->size() << " weights and " << num_actions
+			 << " actions" << endl;
+		exit(-1);
+	}
+	int hash_size = p_hash_table ? p_hash_table->m : 0;
+	int hash_safe = p_hash_table ? p_hash_table->safe : 0;
+	if (p_header->hash_size != hash_size || p_header->hash_safe != hash_safe) {
+		cerr << "Weights checkpoint " << filename << " was saved with the "
+			 << (p_header->hash_size ? "hashed" : "dense") << " storage ("
+			 << p_header->hash_size << " slots, safe = " 
+			 << p_header->hash_safe << "), expected the " 
+			 << (hash_size ? "hashed" : "dense") << " storage (" << hash_size
+			 << " slots, safe = " << hash_safe << ")" << endl;
+		exit(-1);
+	}
+	long long keys_bytes = hash_safe ? hash_size * (long long)sizeof(long) : 0;
+	if (p_header->num_bytes + keys_bytes != 
+					file_size - (long long)sizeof(WeightCheckpointHeader) ||
+		checksum(data, p_header->num_bytes + keys_bytes) != 
+													p_header->checksum) {
+		cerr << "Weights checkpoint " << filename << " is corrupted" << endl;
+		exit(-1);
+	}
+	if (p_header->precision == p_weights->get_precision() &&
+		p_header->fixed_step == p_weights->get_fixed_step() &&
+		p_header->interleave_base == interleave_base) {
+		memcpy(p_weights->get_raw_data(), data, p_header->num_bytes);
+	} else {
+		for (int k = 0; k < p_header->num_weights; k++) {
+			int file_slot = checkpoint_slot(k, num_actions,
+											p_header->interleave_base);
+			p_weights->set(checkpoint_slot(k, num_actions, interleave_base),
+						   raw_value(data, p_header->precision,
+									 p_header->fixed_step, file_slot));
+		}
+	}
+	if (p_hash_table != NULL) {
+		// Without the probing, the slots only depend on the (fixed) hashing
+		p_hash_table->reset();
+		if (keys_bytes > 0) {
+			memcpy(p_hash_table->data, data + p_header->num_bytes, keys_bytes);
+		}
+	}
+	munmap(map, file_size);
+}
+
+/* *********************************************************************
+	Constructor
+ ******************************************************************* */
+WeightCheckpointWriter::WeightCheckpointWriter() :
+	b_writing(false) {
+}
+
+/* *********************************************************************
+	Deconstructor. Waits for the pending write
+ ******************************************************************* */
+WeightCheckpointWriter::~WeightCheckpointWriter() {
+	wait();
+}
+
+/* *********************************************************************
+	Takes a snapshot of the given weights (and of the keys of the given 
+	hash-table, NULL with the dense storage) and writes it to filename 
+	in the background
+ ******************************************************************* */
+void WeightCheckpointWriter::write(const WeightVector* p_weights,
+								   int num_actions, int interleave_base,
+								   const collision_table* p_hash_table,
+								   const string& filename) {
+	wait();
+	memset(&s_header, 0, sizeof(s_header));
+	memcpy(s_header.magic, WEIGHT_CHECKPOINT_MAGIC, 8);
+	s_header.version = WEIGHT_CHECKPOINT_VERSION;
+	s_header.precision = p_weights->get_precision();
+	s_header.num_weights = p_weights->size();
+	s_header.num_actions = num_actions;
+	s_header.interleave_base = interleave_base;
+	s_header.fixed_step = p_weights->get_fixed_step();
+	s_header.num_bytes = p_weights->get_num_bytes();
+	s_header.hash_size = p_hash_table ? p_hash_table->m : 0;
+	s_header.hash_safe = p_hash_table ? p_hash_table->safe : 0;
+	long long keys_bytes = s_header.hash_safe ? 
+						s_header.hash_size * (long long)sizeof(long) : 0;
+	v_snapshot.resize(s_header.num_bytes + keys_bytes);
+	memcpy(&v_snapshot[0], p_weights->get_raw_data(), s_header.num_bytes);
+	if (keys_bytes > 0) {
+		memcpy(&v_snapshot[s_header.num_bytes], p_hash_table->data, 
+			   keys_bytes);
+	}
+	s_filename = filename;
+	if (pthread_create(&s_thread, NULL, write_thread, this) != 0) {
+		// No thread: write it ourselves
+		write_snapshot();
+		return;
+	}
+	b_writing = true;
+}
+
+/* *********************************************************************
+	Waits until the pending write (if any) is on disk
+ ******************************************************************* */
+void WeightCheckpointWriter::wait(void) {
+	if (b_writing) {
+		pthread_join(s_thread, NULL);
+		b_writing = false;
+	}
+}
+
+/* *********************************************************************
+	Body of the background thread
+ ******************************************************************* */
+void* WeightCheckpointWriter::write_thread(void* p_writer) {
+	((WeightCheckpointWriter*)p_writer)->write_snapshot();
+	return NULL;
+}
+
+/* *********************************************************************
+	Writes the snapshot to s_filename (called from the thread)
+ ******************************************************************* */
+void WeightCheckpointWriter::write_snapshot(void) {
+	s_header.checksum = checksum(&v_snapshot[0], v_snapshot.size());
+	string temp_filename = s_filename + ".tmp";
+	FILE* file = fopen(temp_filename.c_str(), "wb");
+	bool ok = (file != NULL);
+	if (ok) {
+		ok = (fwrite(&s_header, sizeof(s_header), 1, file) == 1 &&
+			  fwrite(&v_snapshot[0], 1, v_snapshot.size(), file) ==
+											v_snapshot.size());
+		ok = (fclose(file) == 0) && ok;
+	}
+	if (!ok || rename(temp_filename.c_str(), s_filename.c_str()) != 0) {
+		cerr << "Failed to write the weights checkpoint " << s_filename
+			 << endl;
+		remove(temp_filename.c_str());
+	}
+}
@@ -0,0 +1,135 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  weight_checkpoint.h
+ *
+ *  Implementation of the binary weight checkpoints: the WeightCheckpointWriter
+ *  class, which writes snapshots of a WeightVector from a background thread,
+ *  and the functions that load them back through mmap
+ **************************************************************************** */
+
+#ifndef WEIGHT_CHECKPOINT_H
+#define WEIGHT_CHECKPOINT_H
+
+#include <pthread.h>
+#include "common_constants.h"
+#include "weight_vector.h"
+
+#define WEIGHT_CHECKPOINT_MAGIC "ALEWGTS"
+#define WEIGHT_CHECKPOINT_VERSION 2
+
+class collision_table;
+
+/* *************************************************************************
+	The header at the start of a checkpoint file. It is followed by the raw
+	array of the WeightVector (num_bytes bytes), in its storage order, and
+	with the hashed storage in safe mode, by the keys of the hash-table 
+	(hash_size longs), which depend on the order the features were seen
+ ************************************************************************* */
+struct WeightCheckpointHeader {
+	char magic[8];			// WEIGHT_CHECKPOINT_MAGIC
+	int version;			// WEIGHT_CHECKPOINT_VERSION
+	int precision;			// A WeightPrecision
+	int num_weights;		// Number of values
+	int num_actions;		// Number of actions of the agent
+	int interleave_base;	// The shared base length when the weights of
+							// the actions are interleaved, 0 otherwise
+	int hash_size;			// Number of slots of the hash-table with the
+							// hashed storage, 0 with the dense storage
+	int hash_safe;			// 1 when the hash-table probes on collisions
+	unsigned int checksum;	// crc32 of the values
+	double fixed_step;		// Value of one step in the fixed-point mode
+	long long num_bytes;	// Size of the values, in bytes
+};
+
+/* *************************************************************************
+	Returns the storage slot of the k-th value (in feature order), for the
+	given interleave_base (see WeightCheckpointHeader)
+ ************************************************************************* */
+inline int checkpoint_slot(int k, int num_actions, int interleave_base) {
+	if (interleave_base == 0) {
+		return k;
+	}
+	return (k % interleave_base) * num_actions + k / interleave_base;
+}
+
+/* *************************************************************************
+	Returns true if the given file starts with WEIGHT_CHECKPOINT_MAGIC
+ ************************************************************************* */
+bool is_weight_checkpoint(const string& filename);
+
+/* *************************************************************************
+	Loads the checkpoint in the given file into p_weights, through mmap.
+	When the precision and layout of the file match those of p_weights,
+	the values are copied as one block; otherwise they are converted one
+	by one. p_hash_table is the hash-table of the hashed storage (NULL 
+	with the dense storage); its keys are restored from the file.
+	Exits when the file is not a valid checkpoint for p_weights, or was 
+	saved with another storage
+ ************************************************************************* */
+void load_weight_checkpoint(const string& filename, WeightVector* p_weights,
+							int num_actions, int interleave_base,
+							collision_table* p_hash_table);
+
+class WeightCheckpointWriter {
+    /* *************************************************************************
+        Writes checkpoints of a WeightVector without blocking the agent:
+		write() copies the raw values into a snapshot buffer, and a
+		background thread computes the checksum and writes the file.
+		The file is written under a temporary name and renamed when
+		complete, so a crash never leaves a partial checkpoint behind.
+		Only one write is in flight at a time: write() waits for the
+		previous one to finish before taking the next snapshot.
+    ************************************************************************* */
+
+    public:
+		/* *********************************************************************
+            Constructor
+         ******************************************************************* */
+		WeightCheckpointWriter();
+
+		/* *********************************************************************
+            Deconstructor. Waits for the pending write
+         ******************************************************************* */
+		~WeightCheckpointWriter();
+
+		/* *********************************************************************
+            Takes a snapshot of the given weights (and of the keys of the
+			given hash-table, NULL with the dense storage) and writes it 
+			to filename in the background
+         ******************************************************************* */
+		void write(const WeightVector* p_weights, int num_actions,
+				   int interleave_base, const collision_table* p_hash_table,
+				   const string& filename);
+
+		/* *********************************************************************
+            Waits until the pending write (if any) is on disk
+         ******************************************************************* */
+		void wait(void);
+
+	protected:
+		/* *********************************************************************
+            Body of the background thread
+         ******************************************************************* */
+		static void* write_thread(void* p_writer);
+
+		/* *********************************************************************
+            Writes the snapshot to s_filename (called from the thread)
+         ******************************************************************* */
+		void write_snapshot(void);
+
+		WeightCheckpointHeader s_header;// Header of the pending checkpoint
+		vector<char> v_snapshot;		// Values (and hash-table keys) of the
+										// pending checkpoint
+		string s_filename;				// File of the pending checkpoint
+		pthread_t s_thread;				// The background thread
+		bool b_writing;					// True while a thread is running
+};
+
+#endif
@@ -0,0 +1,261 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  weight_vector.cpp
+ *
+ *  Implementation of the WeightVector class, a vector of learned values that 
+ *  is stored in double, single or 16-bit fixed-point precision
+ **************************************************************************** */
+
+#include "weight_vector.h"
+#include <cmath>
+#include <sys/mman.h>
+
+#define FIXED_MAX_STEPS 32767
+#define MAX_ROW_LENGTH 32		// Longest row sum_rows() can handle (we 
+								// have at most 18 actions)
+
+/* *********************************************************************
+	Constructor
+	All values are initialized to init_value
+ ******************************************************************* */
+WeightVector::WeightVector(int size, WeightPrecision precision, 
+						   double init_value, double fixed_step, bool shared) :
+	i_size(size),
+	e_precision(precision),
+	f_fixed_step(fixed_step),
+	f_inv_fixed_step(1.0 / fixed_step),
+	pf_double(NULL),
+	pf_single(NULL),
+	pi_fixed(NULL),
+	i_rnd_state(2463534242u),
+	b_shared(shared) {
+	switch (e_precision) {
+		case DOUBLE_PRECISION:	
+			pf_double = (double*)allocate(get_num_bytes());	break;
+		case SINGLE_PRECISION:	
+			pf_single = (float*)allocate(get_num_bytes());	break;
+		default:				
+			pi_fixed = (short*)allocate(get_num_bytes());
+	}
+	for (int i = 0; i < i_size; i++) {
+		set(i, init_value);
+	}
+}
+
+/* *********************************************************************
+	Deconstructor
+ ******************************************************************* */
+WeightVector::~WeightVector() {
+	if (b_shared) {
+		munmap(get_raw_data(), get_num_bytes());
+		return;
+	}
+	delete [] pf_double;
+	delete [] pf_single;
+	delete [] pi_fixed;
+}
+
+/* *********************************************************************
+	Allocates the array of the chosen precision (in a shared mapping 
+	when b_shared is true)
+ ******************************************************************* */
+void* WeightVector::allocate(long long num_bytes) {
+	if (!b_shared) {
+		switch (e_precision) {
+			case DOUBLE_PRECISION:	return new double[i_size];
+			case SINGLE_PRECISION:	return new float[i_size];
+			default:				return new short[i_size];
+		}
+	}
+	void* map = mmap(NULL, num_bytes, PROT_READ | PROT_WRITE, 
+					 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		cerr << "Cannot map " << num_bytes << " bytes of shared weights" 
+			 << endl;
+		exit(-1);
+	}
+	return map;
+}
+
+/* *********************************************************************
+	Returns the sum of the values at (inds[j] * stride + offset), for 
+	the first num_inds indices
+ ******************************************************************* */
+double WeightVector::sum(const IntArr& inds, int num_inds, int stride, 
+						 int offset) const {
+	double total = 0;
+	if (e_precision == DOUBLE_PRECISION) {
+		for (int j = 0; j < num_inds; j++) {
+			total += pf_double[inds[j] * stride + offset];
+		}
+	} else if (e_precision == SINGLE_PRECISION) {
+		for (int j = 0; j < num_inds; j++) {
+			total += pf_single[inds[j] * stride + offset];
+		}
+	} else {
+		int steps = 0;
+		for (int j = 0; j < num_inds; j++) {
+			steps += pi_fixed[inds[j] * stride + offset];
+		}
+		total = steps * f_fixed_step;
+	}
+	return total;
+}
+
+/* *********************************************************************
+	Views the values as rows of row_length values, and sets sums[k] 
+	to the sum of the k-th value of the rows listed in the first 
+	num_rows entries of rows
+ ******************************************************************* */
+void WeightVector::sum_rows(const IntArr& rows, int num_rows, int row_length,
+							FloatVect& sums) const {
+	assert(row_length <= MAX_ROW_LENGTH);
+	if (e_precision == DOUBLE_PRECISION) {
+		double acc[MAX_ROW_LENGTH] = {0};
+		for (int j = 0; j < num_rows; j++) {
+			const double* row = pf_double + rows[j] * row_length;
+			for (int k = 0; k < row_length; k++) {
+				acc[k] += row[k];
+			}
+		}
+		for (int k = 0; k < row_length; k++) {
+			sums[k] = acc[k];
+		}
+	} else if (e_precision == SINGLE_PRECISION) {
+		// Summing in double keeps the Q-values identical to sum()
+		double acc[MAX_ROW_LENGTH] = {0};
+		for (int j = 0; j < num_rows; j++) {
+			const float* row = pf_single + rows[j] * row_length;
+			for (int k = 0; k < row_length; k++) {
+				acc[k] += row[k];
+			}
+		}
+		for (int k = 0; k < row_length; k++) {
+			sums[k] = acc[k];
+		}
+	} else {
+		int acc[MAX_ROW_LENGTH] = {0};
+		for (int j = 0; j < num_rows; j++) {
+			const short* row = pi_fixed + rows[j] * row_length;
+			for (int k = 0; k < row_length; k++) {
+				acc[k] += row[k];
+			}
+		}
+		for (int k = 0; k < row_length; k++) {
+			sums[k] = acc[k] * f_fixed_step;
+		}
+	}
+}
+
+/* *********************************************************************
+	Adds scale * factors[k] to the value at inds[k], for the first 
+	num_inds indices (the packed arrays of a TraceStore)
+ ******************************************************************* */
+void WeightVector::add_scaled(const int* inds, const float* factors, 
+							  int num_inds, double scale) {
+	if (e_precision == DOUBLE_PRECISION) {
+		for (int k = 0; k < num_inds; k++) {
+			pf_double[inds[k]] += scale * factors[k];
+		}
+	} else if (e_precision == SINGLE_PRECISION) {
+		float single_scale = (float)scale;
+		for (int k = 0; k < num_inds; k++) {
+			pf_single[inds[k]] += single_scale * factors[k];
+		}
+	} else {
+		for (int k = 0; k < num_inds; k++) {
+			if (factors[k] != 0.0f) {
+				add_fixed(inds[k], scale * factors[k]);
+			}
+		}
+	}
+}
+
+/* *********************************************************************
+	Adds the given value to a fixed-point value, with stochastic 
+	rounding and saturation
+ ******************************************************************* */
+void WeightVector::add_fixed(int i, double value) {
+	double steps = value * f_inv_fixed_step;
+	double floor_steps = floor(steps);
+	// xorshift32: round up with a probability equal to the fraction
+	i_rnd_state ^= i_rnd_state << 13;
+	i_rnd_state ^= i_rnd_state >> 17;
+	i_rnd_state ^= i_rnd_state << 5;
+	double rnd = i_rnd_state * (1.0 / 4294967296.0);
+	double new_val = pi_fixed[i] + floor_steps + 
+					 ((steps - floor_steps) > rnd ? 1 : 0);
+	if (new_val > FIXED_MAX_STEPS) {
+		new_val = FIXED_MAX_STEPS;
+	} else if (new_val < -FIXED_MAX_STEPS) {
+		new_val = -FIXED_MAX_STEPS;
+	}
+	pi_fixed[i] = (short)new_val;
+}
+
+/* *********************************************************************
+	Copies the values to/from a double array (used for exporting, 
+	importing and shrinking the weights)
+ ******************************************************************* */
+void WeightVector::to_array(FloatArr& arr) const {
+	arr.resize(i_size);
+	for (int i = 0; i < i_size; i++) {
+		arr[i] = get(i);
+	}
+}
+
+void WeightVector::from_array(const FloatArr& arr) {
+	assert((int)arr.size() == i_size);
+	for (int i = 0; i < i_size; i++) {
+		set(i, arr[i]);
+	}
+}
+
+/* *********************************************************************
+	Returns the number of bytes used by the values
+ ******************************************************************* */
+long long WeightVector::get_num_bytes(void) const {
+	switch (e_precision) {
+		case DOUBLE_PRECISION:	return (long long)i_size * sizeof(double);
+		case SINGLE_PRECISION:	return (long long)i_size * sizeof(float);
+		default:				return (long long)i_size * sizeof(short);
+	}
+}
+
+/* *********************************************************************
+	Returns the array of the chosen precision, as raw bytes (used for
+	the binary checkpoints). It holds get_num_bytes() bytes
+ ******************************************************************* */
+char* WeightVector::get_raw_data(void) {
+	switch (e_precision) {
+		case DOUBLE_PRECISION:	return (char*)pf_double;
+		case SINGLE_PRECISION:	return (char*)pf_single;
+		default:				return (char*)pi_fixed;
+	}
+}
+
+const char* WeightVector::get_raw_data(void) const {
+	return const_cast<WeightVector*>(this)->get_raw_data();
+}
+
+/* *********************************************************************
+	Parses "double", "single" or "fixed16". Exits on any other value
+ ******************************************************************* */
+WeightPrecision WeightVector::parse_precision(const string& precision_str) {
+	if (precision_str == "double") {
+		return DOUBLE_PRECISION;
+	} else if (precision_str == "single") {
+		return SINGLE_PRECISION;
+	} else if (precision_str == "fixed16") {
+		return FIXED_16_PRECISION;
+	}
+	cerr << "Invalid weights precision: " << precision_str << endl;
+	exit(-1);
+}
@@ -0,0 +1,162 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  weight_vector.h
+ *
+ *  Implementation of the WeightVector class, a vector of learned values that 
+ *  is stored in double, single or 16-bit fixed-point precision
+ **************************************************************************** */
+
+#ifndef WEIGHT_VECTOR_H
+#define WEIGHT_VECTOR_H
+
+#include "common_constants.h"
+
+enum WeightPrecision {
+	DOUBLE_PRECISION,	// 8 bytes per value
+	SINGLE_PRECISION,	// 4 bytes per value
+	FIXED_16_PRECISION	// 2 bytes per value, in steps of f_fixed_step
+};
+
+class WeightVector {
+    /* *************************************************************************
+        A vector of learned values (e.g. Sarsa weights), stored in the 
+		precision chosen at construction. Only the array of the chosen 
+		precision is allocated. 
+		get(), set() and add() work for all precisions; the hot loops can 
+		also work on the raw arrays through sum() and add_scaled().
+		In the fixed-point mode, updates are rounded stochastically, so that 
+		updates smaller than one step are not lost, and values saturate at 
+		+/- 32767 steps.
+		A shared vector lives in a MAP_SHARED mapping, so the processes 
+		forked after its construction all read and update the same values.
+    ************************************************************************* */
+
+    public:
+		/* *********************************************************************
+            Constructor
+			All values are initialized to init_value
+         ******************************************************************* */
+		WeightVector(int size, WeightPrecision precision, double init_value, 
+					 double fixed_step = 1.0 / 1024, bool shared = false);
+
+		/* *********************************************************************
+            Deconstructor
+         ******************************************************************* */
+		~WeightVector();
+
+		/* *********************************************************************
+            Returns the value at the given index
+         ******************************************************************* */
+		inline double get(int i) const {
+			switch (e_precision) {
+				case DOUBLE_PRECISION:	return pf_double[i];
+				case SINGLE_PRECISION:	return pf_single[i];
+				default:				return pi_fixed[i] * f_fixed_step;
+			}
+		}
+
+		/* *********************************************************************
+            Sets the value at the given index
+         ******************************************************************* */
+		inline void set(int i, double value) {
+			switch (e_precision) {
+				case DOUBLE_PRECISION:	pf_double[i] = value;	break;
+				case SINGLE_PRECISION:	pf_single[i] = (float)value; break;
+				default:				pi_fixed[i] = 0; add_fixed(i, value);
+			}
+		}
+
+		/* *********************************************************************
+            Adds the given value to the value at the given index
+         ******************************************************************* */
+		inline void add(int i, double value) {
+			switch (e_precision) {
+				case DOUBLE_PRECISION:	pf_double[i] += value;	break;
+				case SINGLE_PRECISION:	pf_single[i] += (float)value; break;
+				default:				add_fixed(i, value);
+			}
+		}
+
+		/* *********************************************************************
+            Returns the sum of the values at (inds[j] * stride + offset), for 
+			the first num_inds indices
+         ******************************************************************* */
+		double sum(const IntArr& inds, int num_inds, int stride = 1, 
+				   int offset = 0) const;
+
+		/* *********************************************************************
+            Views the values as rows of row_length values, and sets sums[k] 
+			to the sum of the k-th value of the rows listed in the first 
+			num_rows entries of rows. The rows are contiguous, so the inner 
+			loop runs over consecutive values (and is vectorized)
+         ******************************************************************* */
+		void sum_rows(const IntArr& rows, int num_rows, int row_length, 
+					  FloatVect& sums) const;
+
+		/* *********************************************************************
+            Adds scale * factors[k] to the value at inds[k], for the first 
+			num_inds indices (the packed arrays of a TraceStore)
+         ******************************************************************* */
+		void add_scaled(const int* inds, const float* factors, int num_inds, 
+						double scale);
+
+		/* *********************************************************************
+            Copies the values to/from a double array (used for exporting, 
+			importing and shrinking the weights)
+         ******************************************************************* */
+		void to_array(FloatArr& arr) const;
+		void from_array(const FloatArr& arr);
+
+		/* *********************************************************************
+            Accessors
+         ******************************************************************* */
+		int size(void) const {return i_size;}
+		WeightPrecision get_precision(void) const {return e_precision;}
+		double get_fixed_step(void) const {return f_fixed_step;}
+		long long get_num_bytes(void) const;
+
+		/* *********************************************************************
+            Returns the array of the chosen precision, as raw bytes (used for
+			the binary checkpoints). It holds get_num_bytes() bytes
+         ******************************************************************* */
+		char* get_raw_data(void);
+		const char* get_raw_data(void) const;
+
+		/* *********************************************************************
+            Parses "double", "single" or "fixed16". Exits on any other value
+         ******************************************************************* */
+		static WeightPrecision parse_precision(const string& precision_str);
+
+	protected:
+		/* *********************************************************************
+            Allocates the array of the chosen precision (in a shared mapping 
+			when b_shared is true)
+         ******************************************************************* */
+		void* allocate(long long num_bytes);
+
+		/* *********************************************************************
+            Adds the given value to a fixed-point value, with stochastic 
+			rounding and saturation
+         ******************************************************************* */
+		void add_fixed(int i, double value);
+
+		int i_size;					// Number of values
+		WeightPrecision e_precision;// Precision of the stored values
+		double f_fixed_step;		// Value of one step in the fixed mode
+		double f_inv_fixed_step;	// 1.0 / f_fixed_step
+		double* pf_double;			// Values, in the double precision mode
+		float* pf_single;			// Values, in the single precision mode
+		short* pi_fixed;			// Values, in the fixed-point mode
+		unsigned int i_rnd_state;	// State of the rounding random generator
+		bool b_shared;				// True if the values are in a mapping 
+									// shared with the forked processes
+};
+
+#endif
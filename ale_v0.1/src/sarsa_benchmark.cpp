@@ -0,0 +1,194 @@
+/* *****************************************************************************
+ * A.L.E (Atari 2600 Learning Environment)
+ * Copyright (c) 2009-2010 by Yavar Naddaf
+ * Released under GNU General Public License www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * Based on: Stella  --  "An Atari 2600 VCS Emulator"
+ * Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+ *
+ * *****************************************************************************
+ *  sarsa_benchmark.cpp
+ *
+ *  The entry point for sarsa_benchmark: runs the Sarsa-Lambda/tile-coding
+ *  stack on MountainCar (no emulator), for each step-size variant, feature
+ *  size and trace cap, and prints the speed of each phase of the steps as CSV
+ **************************************************************************** */
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include "bspf.hxx"
+#include "Settings.hxx"
+#include "OSystem.hxx"
+#include "SettingsUNIX.hxx"
+#include "OSystemUNIX.hxx"
+#include "mountain_car_test.h"
+#include "common_constants.h"
+
+/* *********************************************************************
+	Returns a monotonic time, in nanoseconds
+ ******************************************************************* */
+static long long now_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/* *********************************************************************
+	Returns the comma separated values of the given setting
+ ******************************************************************* */
+static FloatVect get_list_setting(OSystem* osystem, const string& key) {
+	string list = osystem->settings().getString(key, true);
+	replace(list.begin(), list.end(), ',', ' ');
+	istringstream list_stream(list);
+	FloatVect values;
+	float value;
+	while (list_stream >> value) {
+		values.push_back(value);
+	}
+	if (values.empty()) {
+		cerr << "Invalid value for " << key << ": " << list << endl;
+		exit(-1);
+	}
+	return values;
+}
+
+/* *********************************************************************
+	Returns steps per second, given the time they took
+ ******************************************************************* */
+static double steps_per_sec(int num_steps, long long ns) {
+	return ns > 0 ? num_steps * 1e9 / ns : 0;
+}
+
+/* *********************************************************************
+	Runs num_steps steps of Sarsa-Lambda on MountainCar (starting new
+	episodes as needed), and returns one CSV line with the speed of each
+	phase: GetTiles, computeActionValues, updateTraces and updateWeights
+ ******************************************************************* */
+static string run_benchmark(OSystem* osystem, const string& variant,
+						  int feature_size, float trace_ratio, int num_steps) {
+	Settings& settings = osystem->settings();
+	settings.setBool("use_idbd", variant == "idbd");
+	settings.setBool("use_delta_bar_delta", variant == "dbd");
+	MountanCar car(osystem, feature_size, trace_ratio);
+	RLSarsaLambda* solver = car.sarsa_lambda_solver;
+	SarsaProfile profile;
+	solver->set_profile(&profile);
+	long long tiles_ns = 0;
+	int num_episodes = 0;
+	long long start = now_ns();
+	bool in_episode = false;
+	int action = 0;
+	for (int step = 0; step < num_steps; step++) {
+		if (!in_episode) {
+			car.initialize_state_to_random();
+			car.curr_step_num = 0;
+			long long tiles_start = now_ns();
+			car.generate_feature_vec();
+			tiles_ns += now_ns() - tiles_start;
+			action = solver->episode_start(car.pv_curr_feature_map,
+										   car.pv_num_nonzero_in_f);
+			in_episode = true;
+		}
+		car.curr_step_num++;
+		car.update_state(car.possible_actions[action]);
+		if (car.is_in_terminating_state()) {
+			solver->episode_end(-1.0, -1.0);
+			num_episodes++;
+			in_episode = false;
+			continue;
+		}
+		long long tiles_start = now_ns();
+		car.generate_feature_vec();
+		tiles_ns += now_ns() - tiles_start;
+		action = solver->episode_step(car.pv_curr_feature_map,
+									  car.pv_num_nonzero_in_f, -1.0);
+	}
+	long long total_ns = now_ns() - start;
+	solver->set_profile(NULL);
+	ostringstream line;
+	line << variant << "," << feature_size << "," << trace_ratio << ","
+		 << solver->get_max_traces() << "," << num_steps << ","
+		 << num_episodes << ","
+		 << steps_per_sec(num_steps, tiles_ns) << ","
+		 << steps_per_sec(num_steps, profile.ns[PHASE_ACTION_VALUES]) << ","
+		 << steps_per_sec(num_steps, profile.ns[PHASE_TRACES]) << ","
+		 << steps_per_sec(num_steps, profile.ns[PHASE_WEIGHTS]) << ","
+		 << steps_per_sec(num_steps, total_ns);
+	return line.str();
+}
+
+int main(int argc, char* argv[]) {
+	OSystem* osystem = new OSystemUNIX();
+	SettingsUNIX settings(osystem);
+	osystem->settings().loadConfig();
+
+	// Load the RL parameters
+    string rl_params_loc = osystem->settings().getString("working_dir") +
+                            osystem->settings().getString("rl_params_file");
+	osystem->settings().loadConfig(rl_params_loc.c_str());
+
+	// Take care of commandline arguments (over-ride all file settings)
+	osystem->settings().loadCommandLine(argc, argv);
+	osystem->settings().validate();
+
+	// The benchmark never exports the weights
+	osystem->settings().setInt("export_weights_frq", 0);
+	// iDBD needs a theta, which rl_params.txt leaves commented out (on
+	// MountainCar, iDBD diverges with 0.0001 and above)
+	if (osystem->settings().getString("theta") == "") {
+		osystem->settings().setFloat("theta", 0.00001);
+	}
+
+    if (osystem->settings().getString("random_seed") == "time") {
+        srand((unsigned)time(0));
+        srand48((unsigned)time(0));
+    } else {
+        int seed = osystem->settings().getInt("random_seed");
+        srand((unsigned)seed);
+        srand48((unsigned)seed);
+    }
+
+	string variant_list = osystem->settings().getString("bench_variants", true);
+	replace(variant_list.begin(), variant_list.end(), ',', ' ');
+	istringstream variant_stream(variant_list);
+	vector<string> variants;
+	string variant;
+	while (variant_stream >> variant) {
+		if (variant != "plain" && variant != "idbd" && variant != "dbd") {
+			cerr << "Invalid value in bench_variants: " << variant << endl;
+			exit(-1);
+		}
+		variants.push_back(variant);
+	}
+	FloatVect feature_sizes = get_list_setting(osystem, "bench_feature_sizes");
+	FloatVect trace_ratios = get_list_setting(osystem, "bench_trace_ratios");
+	int num_steps = osystem->settings().getInt("bench_steps", true);
+
+	string output_file = osystem->settings().getString("bench_output_file",
+																	true);
+	ofstream csv(output_file.c_str());
+	if (!csv) {
+		cerr << "Cannot open " << output_file << endl;
+		exit(-1);
+	}
+	csv << "variant,feature_size,trace_ratio,max_traces,steps,episodes,"
+		<< "tiles_steps_per_sec,action_values_steps_per_sec,"
+		<< "traces_steps_per_sec,weights_steps_per_sec,total_steps_per_sec"
+		<< endl;
+	for (unsigned int v = 0; v < variants.size(); v++) {
+		for (unsigned int f = 0; f < feature_sizes.size(); f++) {
+			for (unsigned int t = 0; t < trace_ratios.size(); t++) {
+				string line = run_benchmark(osystem, variants[v], 
+								(int)feature_sizes[f], trace_ratios[t], 
+								num_steps);
+				csv << line << endl;
+				cout << line << endl;
+			}
+		}
+	}
+	cout << "Results saved in " << output_file << endl;
+	delete osystem;
+	return 0;
+}